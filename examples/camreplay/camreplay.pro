@@ -0,0 +1,23 @@
+# replays recorded camera frames through the capture pipeline of the simple source
+# no camera and no display are needed, runs on a headless machine
+
+QT = core gui multimedia quick
+
+TARGET = camreplay
+TEMPLATE = app
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+INCLUDEPATH += $$PWD/../../
+
+SOURCES += main.cpp \
+    ../simpleds/camerasever.cpp \
+    ../simpleds/imageprovider.cpp \
+    ../simpleds/frameconverter.cpp
+HEADERS += ../simpleds/camerasever.h \
+    ../simpleds/imageprovider.h \
+    ../simpleds/frameconverter.hpp \
+    ../simpleds/twglue.hpp \
+    ../common/benchutil.hpp
+
+unix: LIBS += -ldl
@@ -0,0 +1,451 @@
+﻿#include <QCoreApplication>
+#include <QBuffer>
+#include <QFile>
+#include <QVideoFrame>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../simpleds/camerasever.h"
+#include "../common/benchutil.hpp"
+#if !defined(TWPP_DETAIL_OS_WIN)
+#   include <sys/resource.h>
+#endif
+using namespace Twpp;
+using namespace BenchUtil;
+
+struct FormatName {
+    const char* name;
+    QVideoFrame::PixelFormat format;
+};
+
+static const FormatName FORMATS[] = {
+    { "rgb32", QVideoFrame::Format_RGB32 },
+    { "yuyv", QVideoFrame::Format_YUYV },
+    { "nv12", QVideoFrame::Format_NV12 }
+};
+
+struct Options {
+    std::string input; // synthetic frames when empty / 为空时使用合成帧
+    int format = 1;    // index into FORMATS / FORMATS 中的索引
+    int width = 1280;
+    int height = 720;
+    double fps = 30.0;
+    int frames = 300;
+    int captureEvery = 10;
+    int queue = 4;
+    bool json = false;
+};
+
+// CPU time of the whole process in seconds, all threads
+// 整个进程（所有线程）的 CPU 时间，单位为秒
+static double cpuSeconds() {
+#if defined(TWPP_DETAIL_OS_WIN)
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+        return 0.0;
+    }
+
+    auto ticks = [](const FILETIME& t) {
+        return static_cast<double>((static_cast<std::uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime);
+    };
+    return (ticks(kernel) + ticks(user)) / 1e7;
+#else
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0.0;
+    }
+
+    return static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+            static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+#endif
+}
+
+struct Metrics {
+    int presented = 0;
+    int dropped = 0;      // late, the camera would have delivered the next frame already / 迟到，摄像头已经送出下一帧
+    int captured = 0;
+    int pageDrops = 0;    // transfer queue full / 传输队列已满
+    double seconds = 0.0;
+    double cpu = 0.0;
+    Latency present;      // the present call: conversion and preview image / present 调用：转换和预览图像
+    Latency frame;        // frame due .. preview image ready / 帧到期 .. 预览图像就绪
+    Latency page;         // frame due .. page transferred / 帧到期 .. 页面传输完成
+};
+
+static void usage() {
+    std::puts("usage: camreplay [options]\n"
+              "  --input PATH       recorded raw frames, back to back without headers; synthetic frames by default\n"
+              "  --format F         rgb32|yuyv|nv12, pixel format of the frames (yuyv)\n"
+              "  --size W H         frame size in pixels (1280 720)\n"
+              "  --fps N            frames per second, 0 = as fast as possible (30)\n"
+              "  --frames N         frames to present, the recording is looped (300)\n"
+              "  --capture-every N  capture every N-th frame as a page, 0 = never (10)\n"
+              "  --queue N          pages waiting for transfer at most (4)\n"
+              "  --json             print the results as JSON");
+}
+
+static bool parse(int argc, char** argv, Options& opt) {
+    Args args(argc, argv);
+    while (args.next()) {
+        auto& arg = args.arg();
+        const char* v = nullptr;
+        const char* v2 = nullptr;
+        if (arg == "--input" && args.value(v)) opt.input = v;
+        else if (arg == "--format" && args.value(v)) {
+            opt.format = -1;
+            for (int f = 0; f < 3; f++) {
+                if (std::strcmp(v, FORMATS[f].name) == 0) {
+                    opt.format = f;
+                }
+            }
+
+            if (opt.format < 0) {
+                return false;
+            }
+        }
+        else if (arg == "--size" && args.value(v) && args.value(v2)) {
+            opt.width = std::atoi(v);
+            opt.height = std::atoi(v2);
+        }
+        else if (arg == "--fps" && args.value(v)) opt.fps = std::atof(v);
+        else if (arg == "--frames" && args.value(v)) opt.frames = std::atoi(v);
+        else if (arg == "--capture-every" && args.value(v)) opt.captureEvery = std::atoi(v);
+        else if (arg == "--queue" && args.value(v)) opt.queue = std::atoi(v);
+        else if (arg == "--json") opt.json = true;
+        else return false;
+    }
+
+    // YUV formats share chroma between pixel pairs, NV12 between row pairs as well
+    // YUV 格式在像素对之间共享色度，NV12 还在行对之间共享
+    auto format = FORMATS[opt.format].format;
+    if (format != QVideoFrame::Format_RGB32 && opt.width % 2) return false;
+    if (format == QVideoFrame::Format_NV12 && opt.height % 2) return false;
+    return opt.width > 0 && opt.height > 0 && opt.fps >= 0.0 && opt.frames > 0 &&
+            opt.captureEvery >= 0 && opt.queue > 0;
+}
+
+static int bytesPerLine(const Options& opt) {
+    switch (FORMATS[opt.format].format) {
+    case QVideoFrame::Format_RGB32: return opt.width * 4;
+    case QVideoFrame::Format_YUYV: return opt.width * 2;
+    default: return opt.width; // Y plane of NV12, the UV plane has the same stride / NV12 的 Y 平面，UV 平面行距相同
+    }
+}
+
+static int frameBytes(const Options& opt) {
+    auto bytes = bytesPerLine(opt) * opt.height;
+    return FORMATS[opt.format].format == QVideoFrame::Format_NV12 ? bytes + bytes / 2 : bytes;
+}
+
+// diagonal gradient moving by 16 pixels per frame, so consecutive frames differ
+// 每帧移动 16 像素的对角渐变，使相邻帧互不相同
+static void synthesize(const Options& opt, int index, unsigned char* out) {
+    auto format = FORMATS[opt.format].format;
+    auto stride = bytesPerLine(opt);
+    for (int y = 0; y < opt.height; y++) {
+        auto row = out + y * stride;
+        for (int x = 0; x < opt.width; x++) {
+            auto level = static_cast<unsigned char>(16 + (x + y + index * 16) % 220);
+            if (format == QVideoFrame::Format_RGB32) {
+                row[x * 4] = level;
+                row[x * 4 + 1] = static_cast<unsigned char>(y);
+                row[x * 4 + 2] = static_cast<unsigned char>(255 - level);
+                row[x * 4 + 3] = 0xFF;
+            }
+            else if (format == QVideoFrame::Format_YUYV) {
+                row[x * 2] = level;
+                row[x * 2 + 1] = static_cast<unsigned char>(x % 2 ? 160 : 96);
+            }
+            else {
+                row[x] = level;
+            }
+        }
+    }
+
+    if (format == QVideoFrame::Format_NV12) {
+        std::memset(out + stride * opt.height, 128, static_cast<std::size_t>(stride * opt.height / 2));
+    }
+}
+
+// Recorded frames, mapped into memory; or a few synthetic frames without --input.
+// 映射到内存中的录制帧；未指定 --input 时为几帧合成帧
+class Recording {
+
+public:
+    bool open(const Options& opt) {
+        m_frameBytes = frameBytes(opt);
+        if (opt.input.empty()) {
+            static const int synthetic = 8;
+            m_synthetic.resize(m_frameBytes * synthetic);
+            for (int i = 0; i < synthetic; i++) {
+                synthesize(opt, i, reinterpret_cast<unsigned char*>(m_synthetic.data()) + i * m_frameBytes);
+            }
+
+            m_data = reinterpret_cast<const unsigned char*>(m_synthetic.constData());
+            m_count = synthetic;
+            return true;
+        }
+
+        m_file.setFileName(QString::fromLocal8Bit(opt.input.c_str()));
+        if (!m_file.open(QIODevice::ReadOnly)) {
+            std::fprintf(stderr, "could not open %s\n", opt.input.c_str());
+            return false;
+        }
+
+        m_count = static_cast<int>(m_file.size() / m_frameBytes);
+        if (m_count == 0) {
+            std::fprintf(stderr, "%s is smaller than a single frame of %d bytes\n", opt.input.c_str(), m_frameBytes);
+            return false;
+        }
+
+        if (m_file.size() % m_frameBytes) {
+            std::fprintf(stderr, "warning: %s is not a whole number of frames, check --format and --size\n", opt.input.c_str());
+        }
+
+        m_data = m_file.map(0, static_cast<qint64>(m_count) * m_frameBytes);
+        if (!m_data) {
+            std::fprintf(stderr, "could not map %s\n", opt.input.c_str());
+            return false;
+        }
+
+        return true;
+    }
+
+    int count() const noexcept {
+        return m_count;
+    }
+
+    const unsigned char* frame(int index) const noexcept {
+        return m_data + static_cast<std::size_t>(index % m_count) * m_frameBytes;
+    }
+
+private:
+    QFile m_file;
+    QByteArray m_synthetic;
+    const unsigned char* m_data = nullptr;
+    int m_frameBytes = 0;
+    int m_count = 0;
+
+};
+
+// A captured page waiting for the application, the frame due time is kept for the latency.
+// 等待应用程序取走的已采集页面，保留帧的到期时间用于计算延迟
+struct Page {
+    QByteArray bmp;
+    Clock::time_point due;
+};
+
+// Pending pages of the source, transferred by a separate thread standing in for the application.
+// The transfer copies the DIB out of the BMP into a new block, like DAT_IMAGENATIVEXFER of the simple source.
+// 数据源的待传输页面，由代替应用程序的单独线程传输
+// 传输将 BMP 中的 DIB 复制到新的内存块，与简单数据源的 DAT_IMAGENATIVEXFER 相同
+class TransferQueue {
+
+public:
+    TransferQueue(int capacity, Latency& latency) :
+        m_capacity(static_cast<std::size_t>(capacity)), m_latency(latency),
+        m_thread([this]() { run(); }) {}
+
+    ~TransferQueue() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_closed = true;
+        lock.unlock();
+
+        m_cond.notify_one();
+        m_thread.join();
+    }
+
+    // false if the queue is full and the page is dropped / 队列已满、页面被丢弃时返回 false
+    bool push(Page page) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_pages.size() >= m_capacity) {
+            return false;
+        }
+
+        m_pages.push_back(std::move(page));
+        lock.unlock();
+
+        m_cond.notify_one();
+        return true;
+    }
+
+private:
+    void run() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;) {
+            while (!m_closed && m_pages.empty()) {
+                m_cond.wait(lock);
+            }
+
+            if (m_pages.empty()) {
+                return;
+            }
+
+            auto page = std::move(m_pages.front());
+            m_pages.pop_front();
+            lock.unlock();
+
+            static const int fileHeader = 14; // BITMAPFILEHEADER
+            auto size = static_cast<std::size_t>(std::max(0, page.bmp.size() - fileHeader));
+            std::vector<char> dib(size);
+            if (size) {
+                std::memcpy(dib.data(), page.bmp.constData() + fileHeader, size);
+            }
+
+            auto latency = Clock::now() - page.due;
+
+            lock.lock();
+            m_latency.add(latency);
+        }
+    }
+
+    std::size_t m_capacity;
+    Latency& m_latency; // written by the transfer thread only until it is joined / 在线程结束前仅由传输线程写入
+    bool m_closed = false;
+    std::deque<Page> m_pages;
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::thread m_thread;
+
+};
+
+static void printText(const Options& opt, Metrics& m) {
+    std::printf("frames      %s %dx%d from %s, %g fps requested\n", FORMATS[opt.format].name, opt.width, opt.height,
+                opt.input.empty() ? "synthetic frames" : opt.input.c_str(), opt.fps);
+    std::printf("presented   %d in %.3f s, %.2f fps, %d dropped\n", m.presented, m.seconds, m.presented / m.seconds, m.dropped);
+    std::printf("pages       %d captured, %d transferred, %d dropped\n", m.captured,
+                static_cast<int>(m.page.samples.size()), m.pageDrops);
+    std::printf("cpu         %.3f ms per frame, %.1f %% of one core\n",
+                m.presented ? m.cpu * 1e3 / m.presented : 0.0, m.cpu * 100.0 / m.seconds);
+    printLatencyTable("count", { std::make_pair("present", &m.present), std::make_pair("frame", &m.frame),
+                                 std::make_pair("page", &m.page) });
+}
+
+static void printJson(const Options& opt, Metrics& m) {
+    std::printf("{\"format\":\"%s\",\"width\":%d,\"height\":%d,\"synthetic\":%s,\"fpsRequested\":%g,"
+                "\"presented\":%d,\"dropped\":%d,\"seconds\":%.6f,\"fps\":%.3f,"
+                "\"captured\":%d,\"transferred\":%d,\"pageDrops\":%d,\"cpuMsPerFrame\":%.4f,\"cpuPercent\":%.2f",
+                FORMATS[opt.format].name, opt.width, opt.height, opt.input.empty() ? "true" : "false", opt.fps,
+                m.presented, m.dropped, m.seconds, m.presented / m.seconds,
+                m.captured, static_cast<int>(m.page.samples.size()), m.pageDrops,
+                m.presented ? m.cpu * 1e3 / m.presented : 0.0, m.cpu * 100.0 / m.seconds);
+    printLatencyJson("count", { std::make_pair("presentLatencyUs", &m.present), std::make_pair("frameLatencyUs", &m.frame),
+                                std::make_pair("pageLatencyUs", &m.page) });
+
+    std::puts("}");
+}
+
+int main(int argc, char** argv) {
+    QCoreApplication app(argc, argv);
+
+    Options opt;
+    if (!parse(argc, argv, opt)) {
+        usage();
+        return 2;
+    }
+
+    Recording recording;
+    if (!recording.open(opt)) {
+        return 1;
+    }
+
+    Metrics m;
+    Clock::time_point due;
+    Clock::time_point ready;
+    bool captured = false;
+    auto cpuStart = cpuSeconds();
+    {
+        TransferQueue queue(opt.queue, m.page);
+
+        // the same capture step as the scan function of the simple source, without the blank page check
+        // 与简单数据源的扫描函数相同的采集步骤，不含空白页检测
+        auto scan = [&](QImage cap) {
+            Page page;
+            page.due = due;
+            {
+                QBuffer buffer(&page.bmp);
+                buffer.open(QIODevice::WriteOnly);
+                cap.save(&buffer, "BMP");
+            }
+
+            captured = true;
+            if (!queue.push(std::move(page))) {
+                m.pageDrops++;
+            }
+        };
+
+        QtCamera camera(QCameraInfo(), nullptr, TwGlue(scan, [](QString) {}));
+        QObject::connect(&camera, &QtCamera::imageOutput, [&]() {
+            ready = Clock::now();
+        });
+        camera.startReplay();
+
+        auto format = FORMATS[opt.format].format;
+        auto size = QSize(opt.width, opt.height);
+        auto interval = std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double>(opt.fps > 0.0 ? 1.0 / opt.fps : 0.0));
+        auto start = Clock::now();
+        for (int i = 0; i < opt.frames; i++) {
+            if (opt.fps > 0.0) {
+                due = start + interval * i;
+                auto now = Clock::now();
+                if (now >= due + interval) {
+                    m.dropped++; // still busy with an earlier frame / 仍在处理之前的帧
+                    continue;
+                }
+
+                std::this_thread::sleep_until(due);
+            }
+            else {
+                due = Clock::now();
+            }
+
+            // fill a new frame like a capture driver does / 像采集驱动那样填充新帧
+            QVideoFrame frame(frameBytes(opt), size, bytesPerLine(opt), format);
+            frame.map(QAbstractVideoBuffer::WriteOnly);
+            std::memcpy(frame.bits(), recording.frame(i), static_cast<std::size_t>(frameBytes(opt)));
+            frame.unmap();
+
+            auto presented = Clock::now();
+            if (!camera.surface()->present(frame)) {
+                std::fprintf(stderr, "frame %d was not accepted\n", i);
+                return 1;
+            }
+
+            auto done = Clock::now();
+            m.present.add(done - presented);
+            m.frame.add(ready - due);
+            m.presented++;
+
+            if (opt.captureEvery && i % opt.captureEvery == 0) {
+                captured = false;
+                camera.capture();
+                if (captured) {
+                    m.captured++;
+                }
+            }
+        }
+
+        camera.stop();
+        m.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    } // waits for the pending transfers / 等待待传输页面完成
+
+    m.cpu = cpuSeconds() - cpuStart;
+
+    if (opt.json) {
+        printJson(opt, m);
+    }
+    else {
+        printText(opt, m);
+    }
+
+    return 0;
+}
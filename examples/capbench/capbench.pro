@@ -0,0 +1,14 @@
+# microbenchmarks of capability containers, needs no data source or device
+
+QT -= core gui
+
+TARGET = capbench
+TEMPLATE = app
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+INCLUDEPATH += $$PWD/../../
+
+SOURCES += main.cpp
+
+unix: LIBS += -ldl
@@ -0,0 +1,410 @@
+﻿#include <twpp.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+using namespace Twpp;
+
+// microbenchmarks of capability containers, create, get, set and iterate
+// for OneValue, Array, Enumeration and Range of UInt16, Fix32, Frame and Str255 items
+// 能力容器的微基准测试：OneValue、Array、Enumeration 和 Range 的创建、读取、设置和遍历
+
+typedef std::chrono::steady_clock Clock;
+
+// items of Array and Enumeration, steps of Range / Array 和 Enumeration 的元素数，Range 的步数
+static constexpr UInt32 ITEMS = 64;
+
+// timed repetitions of each benchmark, the median is reported
+// 每个基准测试的计时重复次数，报告中位数
+static constexpr int REPETITIONS = 5;
+
+// keeps the compiler from optimizing the benchmarked code away
+// 防止编译器优化掉被测代码
+static volatile UInt32 g_sink;
+
+static void consume(UInt16 value) {
+    g_sink = g_sink + value;
+}
+
+static void consume(Fix32 value) {
+    g_sink = g_sink + value.whole() + value.frac();
+}
+
+static void consume(const Frame& value) {
+    consume(value.left());
+    consume(value.bottom());
+}
+
+static void consume(const Str255& value) {
+    g_sink = g_sink + static_cast<UInt32>(value.data()[0]);
+}
+
+// representative items and capabilities of each type / 各类型的代表性元素和能力
+template<typename T>
+struct Sample;
+
+template<>
+struct Sample<UInt16> {
+    static constexpr const char* name = "UInt16";
+    static constexpr CapType cap = CapType::IBitDepth;
+
+    static UInt16 item(UInt32 i) {
+        return static_cast<UInt16>(i);
+    }
+};
+
+template<>
+struct Sample<Fix32> {
+    static constexpr const char* name = "Fix32";
+    static constexpr CapType cap = CapType::IXResolution;
+
+    static Fix32 item(UInt32 i) {
+        return Fix32(static_cast<float>(i) * 0.5f);
+    }
+};
+
+template<>
+struct Sample<Frame> {
+    static constexpr const char* name = "Frame";
+    static constexpr CapType cap = CapType::IFrames;
+
+    static Frame item(UInt32 i) {
+        return Frame(0, 0, 8.5f + static_cast<float>(i), 11.0f);
+    }
+};
+
+template<>
+struct Sample<Str255> {
+    static constexpr const char* name = "Str255";
+    static constexpr CapType cap = static_cast<CapType>(static_cast<UInt16>(CapType::CustomBase) + 1);
+
+    static Str255 item(UInt32 i) {
+        static const char* texts[] = { "Bayer 4x4", "Bayer 8x8", "Diffusion", "Threshold" };
+        Str255 str;
+        str.setData(texts[i % 4], static_cast<UInt32>(std::strlen(texts[i % 4])));
+        return str;
+    }
+};
+
+struct Options {
+    double seconds = 0.1; // per benchmark / 每个基准测试
+    std::string filter;
+    bool text = false;
+};
+
+struct Report {
+    std::string name;
+    std::uint64_t iterations;
+    double median;
+    double min;
+};
+
+static Options g_options;
+static std::vector<Report> g_reports;
+
+// runs the operation until a repetition takes long enough, then times REPETITIONS of them
+// 反复运行操作直到单次重复足够长，然后对 REPETITIONS 次重复计时
+template<typename Op>
+static void bench(const std::string& name, Op op) {
+    if (!g_options.filter.empty() && name.find(g_options.filter) == std::string::npos) {
+        return;
+    }
+
+    auto target = std::chrono::duration<double>(g_options.seconds / REPETITIONS);
+    std::uint64_t iterations = 1;
+    for (;;) {
+        auto start = Clock::now();
+        for (std::uint64_t i = 0; i < iterations; i++) {
+            op(i);
+        }
+
+        auto elapsed = Clock::now() - start;
+        if (elapsed >= target || iterations >= (std::uint64_t(1) << 40)) {
+            break;
+        }
+
+        iterations *= 2;
+    }
+
+    std::vector<double> ns;
+    for (int r = 0; r < REPETITIONS; r++) {
+        auto start = Clock::now();
+        for (std::uint64_t i = 0; i < iterations; i++) {
+            op(i);
+        }
+
+        auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        ns.push_back(elapsed / static_cast<double>(iterations));
+    }
+
+    std::sort(ns.begin(), ns.end());
+    g_reports.push_back({ name, iterations, ns[ns.size() / 2], ns[0] });
+}
+
+template<typename T>
+static std::vector<T> sampleItems() {
+    std::vector<T> items;
+    for (UInt32 i = 0; i < ITEMS; i++) {
+        items.push_back(Sample<T>::item(i));
+    }
+
+    return items;
+}
+
+template<typename T>
+static void benchOneValue() {
+    auto prefix = std::string("OneValue/") + Sample<T>::name;
+    auto cap = Sample<T>::cap;
+    auto value = Sample<T>::item(1);
+
+    bench(prefix + "/create", [&](std::uint64_t) {
+        Capability c = Capability::createOneValue(cap, value);
+        consume(c.oneValue<T>().item());
+    });
+
+    Capability c = Capability::createOneValue(cap, value);
+    bench(prefix + "/get", [&](std::uint64_t) {
+        consume(c.currentItem<T>());
+    });
+
+    bench(prefix + "/tryGet", [&](std::uint64_t) {
+        consume(c.tryCurrentItem<T>().value());
+    });
+
+    bench(prefix + "/set", [&](std::uint64_t i) {
+        c.oneValue<T>().setItem(Sample<T>::item(static_cast<UInt32>(i & 7)));
+    });
+
+    bench(prefix + "/iterate", [&](std::uint64_t) {
+        for (const auto& item : c.data<T>()) {
+            consume(item);
+        }
+    });
+}
+
+template<typename T>
+static void benchArray() {
+    auto prefix = std::string("Array/") + Sample<T>::name;
+    auto cap = Sample<T>::cap;
+
+    bench(prefix + "/create", [&](std::uint64_t) {
+        Capability c = Capability::createArray<T>(cap, ITEMS);
+        auto arr = c.array<T>();
+        for (UInt32 i = 0; i < ITEMS; i++) {
+            arr[i] = Sample<T>::item(i);
+        }
+
+        consume(arr[ITEMS - 1]);
+    });
+
+    // all items at once, a single copy / 一次性写入所有元素，只复制一次
+    auto items = sampleItems<T>();
+    bench(prefix + "/createBulk", [&](std::uint64_t) {
+        Capability c = Capability::createArray<T>(cap, items.data(), items.data() + items.size());
+        consume(c.array<T>()[ITEMS - 1]);
+    });
+
+    Capability c = Capability::createArray<T>(cap, ITEMS);
+    {
+        auto arr = c.array<T>();
+        for (UInt32 i = 0; i < ITEMS; i++) {
+            arr[i] = Sample<T>::item(i);
+        }
+    }
+
+    bench(prefix + "/get", [&](std::uint64_t i) {
+        consume(c.array<T>()[static_cast<UInt32>(i % ITEMS)]);
+    });
+
+    bench(prefix + "/set", [&](std::uint64_t i) {
+        c.array<T>().set(static_cast<UInt32>(i % ITEMS), Sample<T>::item(static_cast<UInt32>(i & 7)));
+    });
+
+    bench(prefix + "/iterate", [&](std::uint64_t) {
+        for (const auto& item : c.data<T>()) {
+            consume(item);
+        }
+    });
+}
+
+template<typename T>
+static void benchEnumeration() {
+    auto prefix = std::string("Enumeration/") + Sample<T>::name;
+    auto cap = Sample<T>::cap;
+
+    bench(prefix + "/create", [&](std::uint64_t) {
+        Capability c = Capability::createEnumeration<T>(cap, ITEMS, 1, 0);
+        auto enm = c.enumeration<T>();
+        for (UInt32 i = 0; i < ITEMS; i++) {
+            enm[i] = Sample<T>::item(i);
+        }
+
+        consume(enm.currentItem());
+    });
+
+    auto items = sampleItems<T>();
+    bench(prefix + "/createBulk", [&](std::uint64_t) {
+        Capability c = Capability::createEnumeration<T>(cap, items.data(), items.data() + items.size(), 1, 0);
+        consume(c.enumeration<T>().currentItem());
+    });
+
+    Capability c = Capability::createEnumeration<T>(cap, ITEMS, 1, 0);
+    {
+        auto enm = c.enumeration<T>();
+        for (UInt32 i = 0; i < ITEMS; i++) {
+            enm[i] = Sample<T>::item(i);
+        }
+    }
+
+    bench(prefix + "/get", [&](std::uint64_t) {
+        consume(c.currentItem<T>());
+    });
+
+    bench(prefix + "/tryGet", [&](std::uint64_t) {
+        consume(c.tryCurrentItem<T>().value());
+    });
+
+    bench(prefix + "/set", [&](std::uint64_t i) {
+        c.enumeration<T>().setCurrentIndex(static_cast<UInt32>(i % ITEMS));
+    });
+
+    bench(prefix + "/iterate", [&](std::uint64_t) {
+        for (const auto& item : c.data<T>()) {
+            consume(item);
+        }
+    });
+}
+
+// ranges hold numbers only / 范围仅包含数值
+template<typename T>
+static void benchRange() {
+    auto prefix = std::string("Range/") + Sample<T>::name;
+    auto cap = Sample<T>::cap;
+    auto min = Sample<T>::item(0);
+    auto max = Sample<T>::item(ITEMS - 1);
+    auto step = Sample<T>::item(1);
+
+    bench(prefix + "/create", [&](std::uint64_t) {
+        Capability c = Capability::createRange<T>(cap, min, max, step, step, min);
+        consume(c.range<T>().currentValue());
+    });
+
+    Capability c = Capability::createRange<T>(cap, min, max, step, step, min);
+    bench(prefix + "/get", [&](std::uint64_t) {
+        consume(c.currentItem<T>());
+    });
+
+    bench(prefix + "/tryGet", [&](std::uint64_t) {
+        consume(c.tryCurrentItem<T>().value());
+    });
+
+    bench(prefix + "/set", [&](std::uint64_t i) {
+        c.range<T>().setCurrentValue(Sample<T>::item(static_cast<UInt32>(i % ITEMS)));
+    });
+
+    bench(prefix + "/iterate", [&](std::uint64_t) {
+        for (auto item : c.data<T>()) {
+            consume(item);
+        }
+    });
+}
+
+// CAP_SUPPORTEDCAPS of a source with 160 capabilities, item by item and from a list kept by the source
+// 具有 160 个能力的数据源的 CAP_SUPPORTEDCAPS，逐个写入与从数据源保存的列表一次性创建
+static void benchSupportedCaps() {
+    std::vector<CapType> caps;
+    for (UInt16 i = 0; i < 160; i++) {
+        caps.push_back(static_cast<CapType>(static_cast<UInt16>(CapType::CustomBase) + i));
+    }
+
+    bench("SupportedCaps/160/perItem", [&](std::uint64_t) {
+        Capability c = Capability::createArray<CapType::SupportedCaps>(static_cast<UInt32>(caps.size()));
+        auto arr = c.array<CapType::SupportedCaps>();
+        for (UInt32 i = 0; i < caps.size(); i++) {
+            arr[i] = caps[i];
+        }
+
+        g_sink = g_sink + static_cast<UInt32>(arr[0]);
+    });
+
+    bench("SupportedCaps/160/bulk", [&](std::uint64_t) {
+        Capability c = Capability::createArray<CapType::SupportedCaps>(caps.data(), caps.data() + caps.size());
+        g_sink = g_sink + static_cast<UInt32>(c.array<CapType::SupportedCaps>()[0]);
+    });
+}
+
+template<typename T>
+static void benchContainers() {
+    benchOneValue<T>();
+    benchArray<T>();
+    benchEnumeration<T>();
+}
+
+static void usage() {
+    std::puts("usage: capbench [options]\n"
+              "  --time S        seconds spent on each benchmark (0.1)\n"
+              "  --filter TEXT   runs only the benchmarks whose name contains TEXT\n"
+              "  --text          prints a table instead of JSON");
+}
+
+static bool parse(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--time" && i + 1 < argc) opt.seconds = std::atof(argv[++i]);
+        else if (arg == "--filter" && i + 1 < argc) opt.filter = argv[++i];
+        else if (arg == "--text") opt.text = true;
+        else return false;
+    }
+
+    return opt.seconds > 0.0;
+}
+
+int main(int argc, char** argv) {
+    if (!parse(argc, argv, g_options)) {
+        usage();
+        return 2;
+    }
+
+    // containers are allocated by the memory functions of the DSM, the in-process one
+    // provides them on every platform without any source or device
+    // 容器由 DSM 的内存函数分配，进程内 DSM 在所有平台上都能提供，无需数据源或设备
+    Manager mgr(Identity(Version(1, 0, Language::English, Country::CzechRepublic, "v1.0"),
+                         DataGroup::Image, "Martin Richter", "Examples", "Capability benchmark"));
+    if (!mgr.load(LoopbackDsm::entry()) || !success(mgr.open())) {
+        std::fprintf(stderr, "could not open the DSM\n");
+        return 1;
+    }
+
+    benchContainers<UInt16>();
+    benchContainers<Fix32>();
+    benchContainers<Frame>();
+    benchContainers<Str255>();
+    benchRange<UInt16>();
+    benchRange<Fix32>();
+    benchSupportedCaps();
+
+    mgr.close();
+
+    if (g_options.text) {
+        std::printf("%-32s %14s %12s %12s\n", "benchmark", "iterations", "median ns", "min ns");
+        for (const auto& r : g_reports) {
+            std::printf("%-32s %14llu %12.2f %12.2f\n", r.name.c_str(),
+                        static_cast<unsigned long long>(r.iterations), r.median, r.min);
+        }
+    }
+    else {
+        std::printf("{\"repetitions\":%d,\"items\":%u,\"benchmarks\":[", REPETITIONS, ITEMS);
+        for (std::size_t i = 0; i < g_reports.size(); i++) {
+            const auto& r = g_reports[i];
+            std::printf("%s\n{\"name\":\"%s\",\"iterations\":%llu,\"medianNs\":%.3f,\"minNs\":%.3f}", i ? "," : "",
+                        r.name.c_str(), static_cast<unsigned long long>(r.iterations), r.median, r.min);
+        }
+
+        std::puts("\n]}");
+    }
+
+    return 0;
+}
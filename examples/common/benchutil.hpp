@@ -0,0 +1,111 @@
+﻿#ifndef BENCHUTIL_HPP
+#define BENCHUTIL_HPP
+
+// measurement and reporting helpers shared by the benchmark harnesses
+// 各基准测试程序共用的测量和报告辅助函数
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <initializer_list>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace BenchUtil {
+
+typedef std::chrono::steady_clock Clock;
+
+// latency statistics of a single kind of call, in microseconds
+// 单类调用的延迟统计，单位为微秒
+struct Latency {
+    std::vector<double> samples;
+
+    void add(Clock::duration d) {
+        samples.push_back(std::chrono::duration<double, std::micro>(d).count());
+    }
+
+    double percentile(double p) {
+        if (samples.empty()) {
+            return 0.0;
+        }
+
+        std::sort(samples.begin(), samples.end());
+        auto i = static_cast<std::size_t>(p * static_cast<double>(samples.size() - 1) + 0.5);
+        return samples[i];
+    }
+
+    double mean() const {
+        double sum = 0.0;
+        for (auto s : samples) {
+            sum += s;
+        }
+
+        return samples.empty() ? 0.0 : sum / static_cast<double>(samples.size());
+    }
+};
+
+typedef std::pair<const char*, Latency*> NamedLatency;
+
+// walks the command line, arg() is the current option, value() consumes the next argument
+// 遍历命令行，arg() 为当前选项，value() 读取下一个参数
+class Args {
+
+public:
+    Args(int argc, char** argv) :
+        m_argc(argc), m_argv(argv), m_index(0){}
+
+    bool next() {
+        if (m_index + 1 >= m_argc) {
+            return false;
+        }
+
+        m_arg = m_argv[++m_index];
+        return true;
+    }
+
+    const std::string& arg() const {
+        return m_arg;
+    }
+
+    bool value(const char*& out) {
+        if (m_index + 1 >= m_argc) {
+            return false;
+        }
+
+        out = m_argv[++m_index];
+        return true;
+    }
+
+private:
+    int m_argc;
+    char** m_argv;
+    int m_index;
+    std::string m_arg;
+
+};
+
+// one row per latency, countLabel names the sample count column
+// 每种延迟一行，countLabel 为样本数列的标题
+static inline void printLatencyTable(const char* countLabel, std::initializer_list<NamedLatency> latencies) {
+    std::printf("%-10s  %8s %10s %10s %10s %10s %10s\n", "latency", countLabel, "min us", "mean us", "p50 us", "p99 us", "max us");
+    for (auto pair : latencies) {
+        auto& l = *pair.second;
+        std::printf("%-10s  %8zu %10.1f %10.1f %10.1f %10.1f %10.1f\n", pair.first, l.samples.size(),
+                    l.percentile(0.0), l.mean(), l.percentile(0.5), l.percentile(0.99), l.percentile(1.0));
+    }
+}
+
+// one JSON member per latency, appended to an object that is already open
+// 每种延迟一个 JSON 成员，追加到已经开始的对象中
+static inline void printLatencyJson(const char* countKey, std::initializer_list<NamedLatency> latencies) {
+    for (auto pair : latencies) {
+        auto& l = *pair.second;
+        std::printf(",\"%s\":{\"%s\":%zu,\"min\":%.1f,\"mean\":%.1f,\"p50\":%.1f,\"p99\":%.1f,\"max\":%.1f}", pair.first,
+                    countKey, l.samples.size(), l.percentile(0.0), l.mean(), l.percentile(0.5), l.percentile(0.99), l.percentile(1.0));
+    }
+}
+
+}
+
+#endif // BENCHUTIL_HPP
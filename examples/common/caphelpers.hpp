@@ -0,0 +1,203 @@
+﻿#ifndef CAPHELPERS_HPP
+#define CAPHELPERS_HPP
+
+// capability handlers shared by the example data sources, twpp.hpp must be included with TWPP_IS_DS
+// 示例数据源共用的能力处理函数，须在定义 TWPP_IS_DS 后包含 twpp.hpp
+
+#include <twpp.hpp>
+#include <algorithm>
+#include <vector>
+
+namespace CapHelpers {
+
+using namespace Twpp;
+
+template<typename T>
+inline Result oneValGet(Msg msg, Capability& data, const T& value) {
+    switch (msg) {
+    case Msg::Get:
+    case Msg::GetCurrent:
+    case Msg::GetDefault:
+        data = Capability::createOneValue(data.type(), value);
+        return {};
+
+    default:
+        return { ReturnCode::Failure, ConditionCode::CapBadOperation };
+    }
+}
+
+template<typename T>
+inline Result enmGet(Msg msg, Capability& data, const T& value) {
+    switch (msg) {
+    case Msg::Get:
+        data = Capability::createEnumeration(data.type(), { value });
+        return {};
+    case Msg::GetCurrent:
+    case Msg::GetDefault:
+        data = Capability::createOneValue(data.type(), value);
+        return {};
+
+    default:
+        return { ReturnCode::Failure, ConditionCode::CapBadOperation };
+    }
+}
+
+template<typename T>
+inline Result oneValGetSet(Msg msg, Capability& data, T& value, const T& def) {
+    switch (msg) {
+    case Msg::Reset:
+        value = def;
+        // fallthrough
+    case Msg::Get:
+    case Msg::GetCurrent:
+        data = Capability::createOneValue(data.type(), value);
+        return {};
+
+    case Msg::GetDefault:
+        data = Capability::createOneValue(data.type(), def);
+        return {};
+
+    case Msg::Set: {
+        // 不抛异常的取值路径，格式错误的请求直接返回 BadValue
+        auto item = data.tryCurrentItem<T>();
+        if (!item) {
+            return { ReturnCode::Failure, ConditionCode::BadValue };
+        }
+
+        value = item.value();
+        return {};
+    }
+
+    default:
+        return { ReturnCode::Failure, ConditionCode::CapBadOperation };
+    }
+}
+
+template<typename T>
+inline Result oneValGetSetConst(Msg msg, Capability& data, const T& def) {
+    switch (msg) {
+    case Msg::Get:
+    case Msg::GetCurrent:
+    case Msg::GetDefault:
+    case Msg::Reset:
+        data = Capability::createOneValue(data.type(), def);
+        return {};
+
+    case Msg::Set: {
+        auto item = data.tryCurrentItem<T>();
+        return item && item.value() == def ?
+            Result() : Result(ReturnCode::Failure, ConditionCode::BadValue);
+    }
+
+    default:
+        return { ReturnCode::Failure, ConditionCode::CapBadOperation };
+    }
+}
+
+template<typename T>
+inline Result enmGetSetConst(Msg msg, Capability& data, const T& def) {
+    switch (msg) {
+    case Msg::Get:
+        data = Capability::createEnumeration(data.type(), { def });
+        return {};
+
+    case Msg::GetCurrent:
+    case Msg::GetDefault:
+    case Msg::Reset:
+        data = Capability::createOneValue(data.type(), def);
+        return {};
+
+    case Msg::Set: {
+        auto item = data.tryCurrentItem<T>();
+        return item && item.value() == def ?
+            Result() : Result(ReturnCode::Failure, ConditionCode::BadValue);
+    }
+
+    default:
+        return { ReturnCode::Failure, ConditionCode::CapBadOperation };
+    }
+}
+
+template<typename T>
+inline Result enmGetSet(Msg msg, Capability& data, T& value, const std::vector<T>& values, std::size_t def) {
+    switch (msg) {
+    case Msg::Get: {
+        // Str operators live in Twpp, where std::find would not look for them
+        // Str 的比较运算符位于 Twpp 命名空间，std::find 找不到它们
+        auto curr = std::find_if(values.begin(), values.end(), [&value](const T& v) {
+            return v == value;
+        }) - values.begin();
+        data = Capability::createEnumeration<T>(data.type(), values.data(), values.data() + values.size(),
+                                                static_cast<UInt32>(curr), static_cast<UInt32>(def));
+
+        return {};
+    }
+
+    case Msg::Reset:
+        value = values[def];
+        // fallthrough
+    case Msg::GetCurrent:
+        data = Capability::createOneValue(data.type(), value);
+        return {};
+
+    case Msg::GetDefault:
+        data = Capability::createOneValue(data.type(), values[def]);
+        return {};
+
+    case Msg::Set: {
+        auto item = data.tryCurrentItem<T>();
+        auto supported = [&item](const T& v) {
+            return v == item.value();
+        };
+
+        if (!item || std::none_of(values.begin(), values.end(), supported)) {
+            return { ReturnCode::Failure, ConditionCode::BadValue };
+        }
+
+        value = item.value();
+        return {};
+    }
+
+    default:
+        return { ReturnCode::Failure, ConditionCode::CapBadOperation };
+    }
+}
+
+// values of the range, others are snapped to the nearest one and reported by CheckStatus, see Range::contains
+// 范围中的值，其他值对齐到最近的范围值并通过 CheckStatus 通知应用程序，见 Range::contains
+inline Result rngGetSet(Msg msg, Capability& data, Fix32& value, Fix32 min, Fix32 max, Fix32 step, Fix32 def) {
+    switch (msg) {
+    case Msg::Get:
+        data = Capability::createRange(data.type(), min, max, step, value, def);
+        return {};
+
+    case Msg::Reset:
+        value = def;
+        // fallthrough
+    case Msg::GetCurrent:
+        data = Capability::createOneValue(data.type(), value);
+        return {};
+
+    case Msg::GetDefault:
+        data = Capability::createOneValue(data.type(), def);
+        return {};
+
+    case Msg::Set: {
+        auto item = data.tryCurrentItem<Fix32>();
+        if (!item || item.value() < min || item.value() > max) {
+            return { ReturnCode::Failure, ConditionCode::BadValue };
+        }
+
+        typedef Range<Type::Fix32> FixRange;
+        value = FixRange::nearest(min, max, step, item.value());
+        return FixRange::contains(min, max, step, item.value()) ? Result() : Result(ReturnCode::CheckStatus, ConditionCode::Success);
+    }
+
+    default:
+        return { ReturnCode::Failure, ConditionCode::CapBadOperation };
+    }
+}
+
+}
+
+#endif // CAPHELPERS_HPP
@@ -0,0 +1,30 @@
+# libFuzzer target, the synthetic source is linked in and driven through the in-process DSM
+# needs clang with libFuzzer, sanitizers are always enabled
+
+QT = core
+
+TARGET = dsfuzz
+TEMPLATE = app
+
+QMAKE_CC = clang
+QMAKE_CXX = clang++
+QMAKE_LINK = clang++
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+INCLUDEPATH += $$PWD/../../
+
+# the source logs every call, which would slow the fuzzer down
+DEFINES += QT_NO_DEBUG_OUTPUT
+
+# TWAIN containers are packed, their items are not aligned
+QMAKE_CXXFLAGS += -g -O1 -fsanitize=fuzzer,address,undefined -fno-sanitize=alignment -fno-sanitize-recover=undefined
+QMAKE_LFLAGS += -fsanitize=fuzzer,address,undefined
+
+# synthentry.cpp compiles the source with TWPP_IS_DS, do not define it here
+SOURCES += main.cpp \
+    ../synthbench/synthentry.cpp
+HEADERS += ../synthds/synthds.hpp \
+    ../common/caphelpers.hpp
+
+unix: LIBS += -ldl
@@ -0,0 +1,417 @@
+﻿#include <twpp.hpp>
+#include <fuzzer/FuzzedDataProvider.h>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+using namespace Twpp;
+
+// libFuzzer target, feeds arbitrary triplets through LoopbackDsm into the synthetic source
+// each input opens the source, makes a sequence of calls, and closes it again
+// 基于 libFuzzer 的模糊测试目标，通过 LoopbackDsm 向合成数据源发送任意三元组
+// 每个输入都会打开数据源，执行一系列调用，然后再关闭数据源
+
+extern "C" ReturnCode TWPP_DETAIL_CALLSTYLE DS_Entry(Identity* origin, DataGroup dg, Dat dat, Msg msg, void* data);
+
+// larger native and file transfers are skipped, so that the fuzzer does not run out of memory
+// 跳过更大的原生传输和文件传输，避免模糊测试耗尽内存
+static constexpr std::uint64_t MAX_IMAGE_BYTES = 32 * 1024 * 1024;
+
+// largest memory transfer block and capability container item count / 内存传输块的最大值和能力容器的最大元素数
+static constexpr UInt32 MAX_BLOCK = 256 * 1024;
+static constexpr UInt32 MAX_ITEMS = 64;
+
+// file transfers always go here, the path sent by the input is replaced
+// 文件传输始终写入这里，输入中的路径会被替换
+static const char FILE_PATH[] = "dsfuzz.bmp";
+
+static const CapType CAPS[] = {
+    CapType::SupportedCaps, CapType::UiControllable, CapType::DeviceOnline, CapType::XferCount,
+    CapType::ICompression, CapType::IXferMech, CapType::IImageFileFormat, CapType::IPixelType,
+    CapType::IBitDepth, CapType::IBitOrder, CapType::IPlanarChunky, CapType::IPixelFlavor,
+    CapType::IUnits, CapType::IPhysicalWidth, CapType::IPhysicalHeight, CapType::IXResolution,
+    CapType::IYResolution, CapType::IFrames, CapType::ExtendedCaps
+};
+
+// sets the pause between pages of the synthetic source, never set by the fuzzer
+// 设置合成数据源两页之间的间隔，模糊测试从不设置它
+static const CapType CAP_PAGE_RATE = static_cast<CapType>(static_cast<UInt16>(CapType::CustomBase) + 1);
+
+static const ConType CONTAINERS[] = {
+    ConType::OneValue, ConType::Array, ConType::Enumeration, ConType::Range, ConType::DontCare
+};
+
+static const Type TYPES[] = {
+    Type::Int8, Type::Int16, Type::Int32, Type::UInt8, Type::UInt16, Type::UInt32, Type::Bool,
+    Type::Fix32, Type::Frame, Type::Str32, Type::Str64, Type::Str128, Type::Str255, Type::Handle,
+    Type::DontCare
+};
+
+static const Msg MSGS[] = {
+    Msg::Get, Msg::GetCurrent, Msg::GetDefault, Msg::GetFirst, Msg::GetNext, Msg::Set, Msg::Reset,
+    Msg::QuerySupport, Msg::GetHelp, Msg::GetLabel, Msg::GetLabelEnum, Msg::SetConstraint, Msg::ResetAll,
+    Msg::DisableDs, Msg::EnableDs, Msg::EnableDsUiOnly, Msg::EndXfer, Msg::StopFeeder
+};
+
+// triplets whose data holds no pointers, or whose pointers are created by the harness
+// 数据中不含指针，或指针由测试程序创建的三元组
+static const Dat DATS[] = {
+    Dat::Capability, Dat::PendingXfers, Dat::SetupMemXfer, Dat::SetupFileXfer, Dat::Status,
+    Dat::UserInterface, Dat::XferGroup, Dat::DeviceEvent, Dat::ImageInfo, Dat::ImageLayout,
+    Dat::ImageMemXfer, Dat::ImageNativeXfer, Dat::ImageFileXfer, Dat::Palette8
+};
+
+// TW_CAPABILITY as sent by an application, Capability can not hold an arbitrary handle
+// 应用程序发送的 TW_CAPABILITY，Capability 无法持有任意句柄
+TWPP_DETAIL_PACK_BEGIN
+struct RawCapability {
+    CapType m_cap;
+    ConType m_conType;
+    Handle m_cont;
+};
+TWPP_DETAIL_PACK_END
+
+static Identity g_app;
+static Identity g_src;
+static Identity g_srcDef;
+
+static ReturnCode TWPP_DETAIL_CALLSTYLE callBack(Identity*, Identity*, DataGroup, Dat, Msg, void*) {
+    return ReturnCode::Success;
+}
+
+static ReturnCode dsm(Identity* dest, DataGroup dg, Dat dat, Msg msg, void* data) {
+    return LoopbackDsm::entry()(&g_app, dest, dg, dat, msg, data);
+}
+
+static ReturnCode src(DataGroup dg, Dat dat, Msg msg, void* data) {
+    return dsm(&g_src, dg, dat, msg, data);
+}
+
+// mostly valid values, sometimes arbitrary ones / 大多是有效值，有时是任意值
+template<typename T, std::size_t size>
+static T pickOrAny(FuzzedDataProvider& in, const T(& values)[size]) {
+    if (in.ConsumeBool()) {
+        return values[in.ConsumeIntegralInRange<std::size_t>(0, size - 1)];
+    }
+
+    return static_cast<T>(in.ConsumeIntegral<typename std::underlying_type<T>::type>());
+}
+
+static void fill(FuzzedDataProvider& in, void* data, std::size_t size) {
+    auto bytes = in.ConsumeBytes<unsigned char>(size);
+    if (!bytes.empty()) {
+        std::memcpy(data, bytes.data(), bytes.size());
+    }
+}
+
+template<typename T>
+static void fill(FuzzedDataProvider& in, T& data) {
+    fill(in, &data, sizeof(T));
+}
+
+static UInt32 itemSize(Type type) {
+    return isType(type) ? typeSize(type) : 0;
+}
+
+// capability container laid out as the application declares it, contents are arbitrary
+// the source can not check the size of a handle, so only the size matches the declared item count
+// 按应用程序声明的布局创建能力容器，内容是任意的
+// 数据源无法检查句柄的大小，因此只有大小与声明的元素数一致
+static Detail::UniqueHandle container(FuzzedDataProvider& in, ConType conType) {
+    auto type = pickOrAny(in, TYPES);
+    auto count = in.ConsumeIntegralInRange<UInt32>(0, MAX_ITEMS);
+    UInt32 header = sizeof(Type);
+    UInt32 size;
+    switch (conType) {
+    case ConType::OneValue:
+        size = header + std::max<UInt32>(itemSize(type), sizeof(UInt32));
+        break;
+
+    case ConType::Array:
+        header += sizeof(UInt32);
+        size = header + count * itemSize(type);
+        break;
+
+    case ConType::Enumeration:
+        header += 3 * sizeof(UInt32);
+        size = header + count * itemSize(type);
+        break;
+
+    case ConType::Range:
+        size = header + 5 * sizeof(UInt32);
+        break;
+
+    default:
+        size = header + in.ConsumeIntegralInRange<UInt32>(0, 64);
+        break;
+    }
+
+    Detail::UniqueHandle h(Detail::alloc(size));
+    auto lock = h.lock<char>();
+    auto data = lock.data();
+    fill(in, data, size);
+    std::memcpy(data, &type, sizeof(Type));
+    if (conType == ConType::Array || conType == ConType::Enumeration) {
+        std::memcpy(data + sizeof(Type), &count, sizeof(UInt32));
+    }
+
+    // a handle inside OneValue would be freed by the source / OneValue 中的句柄会被数据源释放
+    if (conType == ConType::OneValue && type == Type::Handle) {
+        std::memset(data + header, 0, size - header);
+    }
+
+    return h;
+}
+
+// iterates at most this many items of a container / 最多遍历容器的这么多个元素
+static constexpr UInt32 MAX_READ = 1024;
+
+static volatile UInt32 g_sink;
+
+// reads the container the way generic source code does, through the public capability interface
+// iteration must visit exactly size() items
+// 按照通用数据源代码的方式，通过公开的能力接口读取容器
+// 遍历必须恰好访问 size() 个元素
+template<Type type>
+static void read(Capability& cap) {
+    auto item = cap.tryCurrentItem<type>();
+    g_sink = g_sink + item.hasValue();
+
+    try {
+        cap.currentItem<type>();
+    }
+    catch (const CapabilityException&) {
+        // expected for malformed containers / 畸形容器会抛出此异常
+    }
+
+    try {
+        auto data = cap.data<type>();
+        UInt32 count = 0;
+        for (auto it = data.begin(); it != data.end() && count <= MAX_READ; ++it) {
+            g_sink = g_sink + static_cast<UInt32>(sizeof(*it));
+            count++;
+        }
+
+        if (data.size() <= MAX_READ && count != data.size()) {
+            std::abort();
+        }
+    }
+    catch (const CapabilityException&) {
+    }
+}
+
+static void read(RawCapability& raw) {
+    // the same view of the data a source gets in DS_Entry / 与数据源在 DS_Entry 中看到的数据相同
+    auto& cap = *reinterpret_cast<Capability*>(&raw);
+    if (!cap) {
+        return;
+    }
+
+    switch (cap.itemType()) {
+    case Type::Int8: read<Type::Int8>(cap); break;
+    case Type::Int16: read<Type::Int16>(cap); break;
+    case Type::Int32: read<Type::Int32>(cap); break;
+    case Type::UInt8: read<Type::UInt8>(cap); break;
+    case Type::UInt16: read<Type::UInt16>(cap); break;
+    case Type::UInt32: read<Type::UInt32>(cap); break;
+    case Type::Bool: read<Type::Bool>(cap); break;
+    case Type::Fix32: read<Type::Fix32>(cap); break;
+    case Type::Frame: read<Type::Frame>(cap); break;
+    case Type::Str32: read<Type::Str32>(cap); break;
+    case Type::Str64: read<Type::Str64>(cap); break;
+    case Type::Str128: read<Type::Str128>(cap); break;
+    case Type::Str255: read<Type::Str255>(cap); break;
+    default: break;
+    }
+}
+
+static void capability(FuzzedDataProvider& in, Msg msg) {
+    auto cap = pickOrAny(in, CAPS);
+    if (cap == CAP_PAGE_RATE && (msg == Msg::Set || msg == Msg::SetConstraint)) {
+        return;
+    }
+
+    auto conType = pickOrAny(in, CONTAINERS);
+    Detail::UniqueHandle cont;
+    if (in.ConsumeBool()) {
+        cont = container(in, conType);
+    }
+
+    RawCapability data = { cap, conType, cont.get() };
+    read(data);
+    src(DataGroup::Control, Dat::Capability, msg, &data);
+
+    // the application frees the container returned by the source / 应用程序释放数据源返回的容器
+    if (data.m_cont != cont.get()) {
+        Detail::UniqueHandle returned(data.m_cont);
+    }
+}
+
+// the native and file transfers of too large images are skipped / 跳过图像过大的原生传输和文件传输
+static bool imageTooLarge() {
+    ImageInfo info;
+    if (!success(src(DataGroup::Image, Dat::ImageInfo, Msg::Get, &info))) {
+        return false;
+    }
+
+    auto bytes = static_cast<std::uint64_t>(static_cast<UInt32>(info.width())) *
+            static_cast<UInt32>(info.height()) * static_cast<UInt16>(info.bitsPerPixel()) / 8;
+    return bytes > MAX_IMAGE_BYTES;
+}
+
+template<typename T>
+static void plain(FuzzedDataProvider& in, DataGroup dg, Dat dat, Msg msg) {
+    T data;
+    fill(in, data);
+    src(dg, dat, msg, &data);
+}
+
+static void call(FuzzedDataProvider& in) {
+    auto dat = pickOrAny(in, DATS);
+    auto msg = pickOrAny(in, MSGS);
+    auto dg = dat >= Dat::ImageInfo && dat <= Dat::ExtImageInfo ? DataGroup::Image : DataGroup::Control;
+    if (!in.ConsumeIntegralInRange(0, 15)) {
+        dg = static_cast<DataGroup>(in.ConsumeIntegral<UInt32>());
+    }
+
+    switch (dat) {
+    case Dat::Capability:
+        capability(in, msg);
+        break;
+
+    case Dat::PendingXfers:
+        plain<PendingXfers>(in, dg, dat, msg);
+        break;
+
+    case Dat::SetupMemXfer:
+        plain<SetupMemXfer>(in, dg, dat, msg);
+        break;
+
+    case Dat::SetupFileXfer: {
+        SetupFileXfer data;
+        fill(in, data);
+        if (msg == Msg::Set) {
+            data.setFilePath(FILE_PATH);
+        }
+
+        src(dg, dat, msg, &data);
+        break;
+    }
+
+    case Dat::Status:
+        plain<Status>(in, dg, dat, msg);
+        break;
+
+    case Dat::UserInterface: {
+        // no parent window / 没有父窗口
+        UserInterface data(in.ConsumeBool(), in.ConsumeBool());
+        src(dg, dat, msg, &data);
+        break;
+    }
+
+    case Dat::XferGroup:
+        plain<DataGroup>(in, dg, dat, msg);
+        break;
+
+    case Dat::DeviceEvent:
+        plain<DeviceEvent>(in, dg, dat, msg);
+        break;
+
+    case Dat::ImageInfo:
+        plain<ImageInfo>(in, dg, dat, msg);
+        break;
+
+    case Dat::ImageLayout:
+        plain<ImageLayout>(in, dg, dat, msg);
+        break;
+
+    case Dat::ImageMemXfer: {
+        auto size = in.ConsumeIntegralInRange<UInt32>(0, MAX_BLOCK);
+        ImageMemXfer data(Compression::None, 0, 0, 0, 0, 0, 0, Memory(size));
+        src(dg, dat, msg, &data);
+        break;
+    }
+
+    case Dat::ImageNativeXfer: {
+        if (imageTooLarge()) {
+            break;
+        }
+
+        ImageNativeXfer data;
+        src(dg, dat, msg, &data);
+        break;
+    }
+
+    case Dat::ImageFileXfer:
+        if (!imageTooLarge()) {
+            src(dg, dat, msg, nullptr);
+        }
+
+        break;
+
+    case Dat::Palette8:
+        plain<Palette8>(in, dg, dat, msg);
+        break;
+
+    default: {
+        // arbitrary triplet without any data / 不带数据的任意三元组
+        src(dg, dat, msg, nullptr);
+        break;
+    }
+    }
+}
+
+static bool open() {
+    g_app = Identity(Version(1, 0, Language::English, Country::CzechRepublic, "v1.0"),
+                     DataGroup::Image, "Martin Richter", "Examples", "DS fuzzer");
+    if (!success(dsm(nullptr, DataGroup::Control, Dat::Parent, Msg::OpenDsm, nullptr))) {
+        return false;
+    }
+
+    g_src = g_srcDef;
+    if (!success(dsm(nullptr, DataGroup::Control, Dat::Identity, Msg::OpenDs, &g_src))) {
+        return false;
+    }
+
+    Detail::CallBack2 cb(callBack, 0, Msg::Null);
+    return success(src(DataGroup::Control, Dat::Callback2, Msg::RegisterCallback, &cb));
+}
+
+// back to state 4 whatever the input did, then the source and the DSM are closed
+// 无论输入做了什么，都先回到状态 4，再关闭数据源和 DSM
+static void close() {
+    PendingXfers xfers;
+    src(DataGroup::Control, Dat::PendingXfers, Msg::EndXfer, &xfers);
+    src(DataGroup::Control, Dat::PendingXfers, Msg::Reset, &xfers);
+
+    UserInterface ui(false, false);
+    src(DataGroup::Control, Dat::UserInterface, Msg::DisableDs, &ui);
+
+    if (!success(dsm(nullptr, DataGroup::Control, Dat::Identity, Msg::CloseDs, &g_src)) ||
+            !success(dsm(nullptr, DataGroup::Control, Dat::Parent, Msg::CloseDsm, nullptr))) {
+        // state would leak into the next input / 状态会泄漏到下一个输入
+        std::abort();
+    }
+}
+
+extern "C" int LLVMFuzzerInitialize(int*, char***) {
+    if (!LoopbackDsm::addSource(DS_Entry, &g_srcDef)) {
+        std::abort();
+    }
+
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data, std::size_t size) {
+    if (!open()) {
+        std::abort();
+    }
+
+    FuzzedDataProvider in(data, size);
+    while (in.remaining_bytes() > 0) {
+        call(in);
+    }
+
+    close();
+    return 0;
+}
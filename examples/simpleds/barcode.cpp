@@ -0,0 +1,499 @@
+﻿#include <algorithm>
+#include <array>
+#include "barcode.hpp"
+using namespace Twpp;
+
+static constexpr const UInt32 SCAN_LINES = 256;
+static constexpr const int MIN_CONTRAST = 64;
+static constexpr const UInt32 MIN_HITS = 2;
+
+// Code 39 characters, wide elements of bar-space-bar-...-bar marked 1
+// Code 39 字符，条-空-条-...-条 中的宽元素标记为 1
+static const char CODE39_CHARS[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ-. *$/+%";
+static const UInt16 CODE39_PATTERNS[] = {
+    0x034, 0x121, 0x061, 0x160, 0x031, 0x130, 0x070, 0x025, 0x124, 0x064, // 0-9
+    0x109, 0x049, 0x148, 0x019, 0x118, 0x058, 0x00D, 0x10C, 0x04C, 0x01C, // A-J
+    0x103, 0x043, 0x142, 0x013, 0x112, 0x052, 0x007, 0x106, 0x046, 0x016, // K-T
+    0x181, 0x0C1, 0x1C0, 0x091, 0x190, 0x0D0, 0x085, 0x184, 0x0C4, 0x094, // U-*
+    0x0A8, 0x0A2, 0x08A, 0x02A                                            // $-%
+};
+
+// Code 128 symbol values 0-106, module widths of bar-space-bar-space-bar-space
+// the stop symbol 106 is followed by a final bar of 2 modules
+// Code 128 符号值 0-106，条-空-条-空-条-空 的模块宽度，停止符 106 后面还有一个 2 模块宽的条
+static const UInt32 CODE128_PATTERNS[] = {
+    212222, 222122, 222221, 121223, 121322, 131222, 122213, 122312, 132212, 221213,
+    221312, 231212, 112232, 122132, 122231, 113222, 123122, 123221, 223211, 221132,
+    221231, 213212, 223112, 312131, 311222, 321122, 321221, 312212, 322112, 322211,
+    212123, 212321, 232121, 111323, 131123, 131321, 112313, 132113, 132311, 211313,
+    231113, 231311, 112133, 112331, 132131, 113123, 113321, 133121, 313121, 211331,
+    231131, 213113, 213311, 213131, 311123, 311321, 331121, 312113, 312311, 332111,
+    314111, 221411, 431111, 111224, 111422, 121124, 121421, 141122, 141221, 112214,
+    112412, 122114, 122411, 142112, 142211, 241211, 221114, 413111, 241112, 134111,
+    111242, 121142, 121241, 114212, 124112, 124211, 411212, 421112, 421211, 212141,
+    214121, 412121, 111143, 111341, 131141, 114113, 114311, 411113, 411311, 113141,
+    114131, 311141, 411131, 211412, 211214, 211232, 233111
+};
+
+enum : int {
+    CODE128_SHIFT = 98,
+    CODE128_CODE_C = 99,
+    CODE128_CODE_B = 100,
+    CODE128_CODE_A = 101,
+    CODE128_FNC1 = 102,
+    CODE128_START_A = 103,
+    CODE128_START_C = 105,
+    CODE128_STOP = 106
+};
+
+// patch codes: four bars, wide ones marked 1, read the same in both directions
+// 分隔码：四个条，宽条标记为 1，两个方向读取结果相同
+struct PatchPattern {
+    UInt8 mask;
+    UInt8 reversed;
+    PatchCode code;
+};
+
+static const PatchPattern PATCH_PATTERNS[] = {
+    { 0x9, 0x9, PatchCode::P1 }, // W N N W
+    { 0xA, 0x5, PatchCode::P2 }, // W N W N
+    { 0xC, 0x3, PatchCode::P3 }, // W W N N
+    { 0x6, 0x6, PatchCode::P4 }, // N W W N
+    { 0xE, 0x7, PatchCode::P6 }, // W W W N
+    { 0xB, 0xD, PatchCode::PT }  // W N W W
+};
+
+// alternating run lengths of a scan line, starting with a space, so that bars have odd indexes
+// 扫描线的交替游程长度，从空开始，因此条的索引为奇数
+struct Runs {
+    std::vector<UInt32> widths;
+    std::vector<UInt32> starts;
+    UInt32 length = 0;
+};
+
+struct Hit {
+    BarCodeType type;
+    std::string text;
+    BarCodeRotation rotation;
+    UInt32 x0, y0, x1, y1;
+    UInt32 count;
+};
+
+const std::vector<BarCodeType>& supportedBarCodeTypes() {
+    static const std::vector<BarCodeType> types = { BarCodeType::Code128, BarCodeType::ThreeOfNine };
+    return types;
+}
+
+static void makeRuns(const unsigned char* line, UInt32 length, bool reverse, Runs& runs) {
+    runs.widths.clear();
+    runs.starts.clear();
+    runs.length = length;
+
+    auto mm = std::minmax_element(line, line + length);
+    if (length == 0 || *mm.second - *mm.first < MIN_CONTRAST) {
+        return;
+    }
+
+    const int threshold = (*mm.first + *mm.second) / 2;
+    bool bar = false;
+    UInt32 start = 0;
+    runs.starts.push_back(0);
+    for (UInt32 i = 0; i < length; i++) {
+        const bool dark = line[reverse ? length - 1 - i : i] < threshold;
+        if (dark != bar) {
+            runs.widths.push_back(i - start);
+            runs.starts.push_back(i);
+            start = i;
+            bar = dark;
+        }
+    }
+
+    runs.widths.push_back(length - start);
+}
+
+static UInt32 sum(const UInt32* w, UInt32 count) {
+    UInt32 s = 0;
+    for (UInt32 i = 0; i < count; i++) {
+        s += w[i];
+    }
+
+    return s;
+}
+
+static int code39Char(const UInt32* w) {
+    // the three widest of the nine elements are wide
+    // 九个元素中最宽的三个为宽元素
+    std::array<UInt32, 9> sorted;
+    std::copy(w, w + 9, sorted.begin());
+    std::sort(sorted.begin(), sorted.end(), [](UInt32 a, UInt32 b) { return a > b; });
+    if (sorted[2] * 2 < sorted[3] * 3) {
+        return -1;
+    }
+
+    const auto threshold = (sorted[2] + sorted[3]) / 2;
+    UInt16 mask = 0;
+    for (int i = 0; i < 9; i++) {
+        mask = static_cast<UInt16>(mask << 1 | (w[i] > threshold ? 1 : 0));
+    }
+
+    auto end = std::end(CODE39_PATTERNS);
+    auto it = std::find(std::begin(CODE39_PATTERNS), end, mask);
+    return it == end ? -1 : CODE39_CHARS[it - std::begin(CODE39_PATTERNS)];
+}
+
+static bool decodeCode39(const Runs& runs, UInt32 i, std::string& text, UInt32& last) {
+    const auto* w = runs.widths.data();
+    const auto n = static_cast<UInt32>(runs.widths.size());
+    if (i + 9 >= n) {
+        return false;
+    }
+
+    const auto width = sum(w + i, 9);
+    if (w[i - 1] < width / 2 || code39Char(w + i) != '*') {
+        return false;
+    }
+
+    text.clear();
+    for (UInt32 j = i + 10; j + 9 < n; j += 10) {
+        const auto charWidth = sum(w + j, 9);
+        if (charWidth * 4 < width * 3 || charWidth * 3 > width * 4) {
+            return false;
+        }
+
+        const int c = code39Char(w + j);
+        if (c < 0) {
+            return false;
+        }
+
+        if (c == '*') {
+            // stop character, followed by a quiet zone / 停止符，后跟静区
+            last = j + 8;
+            return !text.empty() && w[j + 9] >= width / 2;
+        }
+
+        text += static_cast<char>(c);
+    }
+
+    return false;
+}
+
+static int code128Symbol(const UInt32* w, UInt32 modules) {
+    static const std::vector<Int8> lookup = [] {
+        // module widths 1-4 of six elements, two bits each
+        // 六个元素的模块宽度 1-4，每个两位
+        std::vector<Int8> table(4096, -1);
+        for (int v = 0; v < 107; v++) {
+            UInt32 key = 0;
+            for (UInt32 p = CODE128_PATTERNS[v], k = 0; k < 6; k++, p /= 10) {
+                key = key << 2 | (p % 10 - 1);
+            }
+
+            table[key] = static_cast<Int8>(v);
+        }
+
+        return table;
+    }();
+
+    const auto total = sum(w, 6);
+    UInt32 key = 0;
+    UInt32 count = 0;
+    for (int k = 5; k >= 0; k--) {
+        const auto m = (2 * w[k] * modules + total) / (2 * total);
+        if (m < 1 || m > 4) {
+            return -1;
+        }
+
+        count += m;
+        key = key << 2 | (m - 1);
+    }
+
+    return count == modules ? lookup[key] : -1;
+}
+
+static bool code128Text(const std::vector<int>& values, std::string& text) {
+    text.clear();
+    int set = values.front() - CODE128_START_A; // 0 = A, 1 = B, 2 = C
+    bool shift = false;
+    for (std::size_t k = 1; k + 1 < values.size(); k++) {
+        const int v = values[k];
+        const int cur = shift ? 1 - set : set;
+        shift = false;
+
+        if (cur == 2) {
+            if (v < 100) {
+                text += static_cast<char>('0' + v / 10);
+                text += static_cast<char>('0' + v % 10);
+            }
+            else if (v == CODE128_CODE_B || v == CODE128_CODE_A) {
+                set = v == CODE128_CODE_A ? 0 : 1;
+            }
+            else if (v != CODE128_FNC1) {
+                return false;
+            }
+
+            continue;
+        }
+
+        if (v < 96) {
+            text += static_cast<char>(cur == 0 && v >= 64 ? v - 64 : v + 32);
+        }
+        else if (v == CODE128_SHIFT) {
+            shift = true;
+        }
+        else if (v == CODE128_CODE_C) {
+            set = 2;
+        }
+        else if (v == CODE128_CODE_B && cur == 0) {
+            set = 1;
+        }
+        else if (v == CODE128_CODE_A && cur == 1) {
+            set = 0;
+        }
+        else if (v > CODE128_FNC1) {
+            return false;
+        }
+        // FNC1-4 carry no text / FNC1-4 不包含文本
+    }
+
+    return !text.empty();
+}
+
+static bool decodeCode128(const Runs& runs, UInt32 i, std::string& text, UInt32& last) {
+    const auto* w = runs.widths.data();
+    const auto n = static_cast<UInt32>(runs.widths.size());
+    if (i + 6 >= n) {
+        return false;
+    }
+
+    const int start = code128Symbol(w + i, 11);
+    if (start < CODE128_START_A || start > CODE128_START_C) {
+        return false;
+    }
+
+    const auto width = sum(w + i, 6);
+    if (w[i - 1] < width / 2) {
+        return false;
+    }
+
+    std::vector<int> values(1, start);
+    for (UInt32 j = i + 6; j + 7 < n; j += 6) {
+        const int v = code128Symbol(w + j, 11);
+        if (v < 0 || v == CODE128_START_A || v == CODE128_START_A + 1 || v == CODE128_START_C) {
+            return false;
+        }
+
+        if (v != CODE128_STOP) {
+            values.push_back(v);
+            continue;
+        }
+
+        // final bar of the stop symbol, then a quiet zone / 停止符的最后一个条，然后是静区
+        const auto module = width / 11.0f;
+        if (w[j + 6] < module || w[j + 6] > 3 * module || w[j + 7] < width / 2 || values.size() < 3) {
+            return false;
+        }
+
+        int checksum = values[0];
+        for (std::size_t k = 1; k + 1 < values.size(); k++) {
+            checksum += static_cast<int>(k) * values[k];
+        }
+
+        last = j + 6;
+        return checksum % 103 == values.back() && code128Text(values, text);
+    }
+
+    return false;
+}
+
+// patch code at bar `i`, or -1
+// 位于条 i 处的分隔码，或 -1
+static int patchAt(const Runs& runs, UInt32 i, UInt32 minBar) {
+    const auto* w = runs.widths.data();
+    if (i + 7 >= runs.widths.size()) {
+        return -1;
+    }
+
+    const UInt32 bars[] = { w[i], w[i + 2], w[i + 4], w[i + 6] };
+    const UInt32 spaces[] = { w[i + 1], w[i + 3], w[i + 5] };
+    const auto narrow = *std::min_element(bars, bars + 4);
+    const auto wide = *std::max_element(bars, bars + 4);
+    const auto gaps = std::minmax_element(spaces, spaces + 3);
+    if (narrow < minBar || wide < narrow * 2 || *gaps.second * 2 > *gaps.first * 3) {
+        return -1;
+    }
+
+    // patch codes stand alone, unlike groups of bars within bar codes
+    // 分隔码是独立的，不同于条码中的条组
+    if (w[i - 1] < 2 * wide || w[i + 7] < 2 * wide) {
+        return -1;
+    }
+
+    UInt8 mask = 0;
+    for (auto b : bars) {
+        // every bar is clearly narrow or wide / 每个条都明显是窄条或宽条
+        if (b * 4 > narrow * 5 && b * 5 < wide * 4) {
+            return -1;
+        }
+
+        mask = static_cast<UInt8>(mask << 1 | (b * 2 > narrow + wide ? 1 : 0));
+    }
+
+    for (const auto& p : PATCH_PATTERNS) {
+        if (p.mask == mask || p.reversed == mask) {
+            return static_cast<int>(p.code);
+        }
+    }
+
+    return -1;
+}
+
+// joins detections of the same code on neighbouring scan lines, `gap` apart at most
+// 合并相邻扫描线上同一条码的检测结果，间隔最多为 gap
+static void addHit(std::vector<Hit>& hits, BarCodeType type, const std::string& text, BarCodeRotation rotation,
+                   UInt32 x0, UInt32 y0, UInt32 x1, UInt32 y1, UInt32 gap) {
+    for (auto& hit : hits) {
+        if (hit.type == type && hit.rotation == rotation && hit.text == text &&
+                x0 <= hit.x1 + gap && hit.x0 <= x1 + gap && y0 <= hit.y1 + gap && hit.y0 <= y1 + gap) {
+            hit.x0 = std::min(hit.x0, x0);
+            hit.y0 = std::min(hit.y0, y0);
+            hit.x1 = std::max(hit.x1, x1);
+            hit.y1 = std::max(hit.y1, y1);
+            hit.count++;
+            return;
+        }
+    }
+
+    hits.push_back({ type, text, rotation, x0, y0, x1, y1, 1 });
+}
+
+// decodes a single scan line, `pos` is the line in the perpendicular direction
+// 解码单条扫描线，pos 为该线在垂直方向上的位置
+static void scanLine(const Runs& runs, const std::vector<BarCodeType>& types, bool vertical, bool reverse,
+                     UInt32 pos, UInt32 gap, std::vector<Hit>& hits) {
+    const auto n = static_cast<UInt32>(runs.widths.size());
+    std::string text;
+    for (UInt32 i = 1; i < n; i += 2) {
+        for (auto type : types) {
+            UInt32 last = 0;
+            const bool found = type == BarCodeType::Code128 ? decodeCode128(runs, i, text, last) :
+                               type == BarCodeType::ThreeOfNine ? decodeCode39(runs, i, text, last) : false;
+            if (!found) {
+                continue;
+            }
+
+            // back to page coordinates / 转换回页面坐标
+            auto from = runs.starts[i];
+            auto to = runs.starts[last] + runs.widths[last];
+            if (reverse) {
+                std::swap(from, to);
+                from = runs.length - from;
+                to = runs.length - to;
+            }
+
+            BarCodeRotation rotation = vertical ? (reverse ? BarCodeRotation::Rot90 : BarCodeRotation::Rot270) :
+                                                  (reverse ? BarCodeRotation::Rot180 : BarCodeRotation::Rot0);
+            if (vertical) {
+                addHit(hits, type, text, rotation, pos, from, pos, to, gap);
+            }
+            else {
+                addHit(hits, type, text, rotation, from, pos, to, pos, gap);
+            }
+
+            i = last;
+            break;
+        }
+    }
+}
+
+PageCodes detectCodes(const ImageView& page, const std::vector<BarCodeType>& types, bool patchCodes) {
+    PageCodes codes;
+    if ((page.channels != 3 && page.channels != 4) || page.width == 0 || page.height == 0) {
+        return codes;
+    }
+
+    const auto ch = page.channels;
+    const auto rowStep = std::max<UInt32>(1, page.height / SCAN_LINES);
+    const auto colStep = std::max<UInt32>(1, page.width / SCAN_LINES);
+    const auto minPatchBar = std::max<UInt32>(2, page.width / 150);
+
+    std::vector<Hit> hits;
+    std::vector<unsigned char> gray(page.width);
+    Runs runs;
+
+    UInt32 patchCounts[6] = {};
+    UInt32 rows = 0;
+    for (UInt32 y = rowStep / 2; y < page.height; y += rowStep, rows++) {
+        const unsigned char* px = page.row(y);
+        for (UInt32 x = 0; x < page.width; x++, px += ch) {
+            gray[x] = static_cast<unsigned char>((29 * px[0] + 150 * px[1] + 77 * px[2]) >> 8);
+        }
+
+        for (int reverse = 0; reverse < 2; reverse++) {
+            makeRuns(gray.data(), page.width, reverse != 0, runs);
+            scanLine(runs, types, false, reverse != 0, y, 2 * rowStep, hits);
+        }
+
+        if (patchCodes) {
+            makeRuns(gray.data(), page.width, false, runs);
+            for (UInt32 i = 1; i < runs.widths.size(); i += 2) {
+                const int patch = patchAt(runs, i, minPatchBar);
+                if (patch >= 0) {
+                    patchCounts[patch]++;
+                    break;
+                }
+            }
+        }
+    }
+
+    // columns are gathered in a single pass over the rows
+    // 在一次逐行遍历中收集所有列
+    if (!types.empty()) {
+        const auto cols = (page.width - colStep / 2 + colStep - 1) / colStep;
+        std::vector<unsigned char> columns(static_cast<std::size_t>(cols) * page.height);
+        for (UInt32 y = 0; y < page.height; y++) {
+            const unsigned char* line = page.row(y);
+            for (UInt32 c = 0; c < cols; c++) {
+                const unsigned char* px = line + (colStep / 2 + c * colStep) * ch;
+                columns[static_cast<std::size_t>(c) * page.height + y] =
+                        static_cast<unsigned char>((29 * px[0] + 150 * px[1] + 77 * px[2]) >> 8);
+            }
+        }
+
+        for (UInt32 c = 0; c < cols; c++) {
+            const unsigned char* column = columns.data() + static_cast<std::size_t>(c) * page.height;
+            for (int reverse = 0; reverse < 2; reverse++) {
+                makeRuns(column, page.height, reverse != 0, runs);
+                scanLine(runs, types, true, reverse != 0, colStep / 2 + c * colStep, 2 * colStep, hits);
+            }
+        }
+    }
+
+    // a single line may be a false positive, the patch sheet crosses most of the rows
+    // 单条扫描线可能是误报，分隔页贯穿大部分行
+    for (const auto& hit : hits) {
+        if (hit.count < MIN_HITS) {
+            continue;
+        }
+
+        BarCode code;
+        code.type = hit.type;
+        code.text = hit.text;
+        code.x = hit.x0;
+        code.y = hit.y0;
+        code.rotation = hit.rotation;
+        code.confidence = std::min<UInt32>(100, hit.count * 20);
+        codes.barCodes.push_back(std::move(code));
+    }
+
+    std::stable_sort(codes.barCodes.begin(), codes.barCodes.end(), [&types](const BarCode& a, const BarCode& b) {
+        return std::find(types.begin(), types.end(), a.type) < std::find(types.begin(), types.end(), b.type);
+    });
+
+    auto best = std::max_element(std::begin(patchCounts), std::end(patchCounts));
+    if (patchCodes && *best * 4 >= rows && *best >= MIN_HITS) {
+        codes.patchFound = true;
+        codes.patch = static_cast<PatchCode>(best - std::begin(patchCounts));
+    }
+
+    return codes;
+}
@@ -0,0 +1,39 @@
+﻿#ifndef BARCODE_HPP
+#define BARCODE_HPP
+
+#include <string>
+#include <vector>
+#include "imageview.hpp"
+
+// A decoded bar code, position of the upper-left corner in page pixels.
+// 解码的条码，左上角位置以页面像素为单位
+struct BarCode {
+    Twpp::BarCodeType type;
+    std::string text;
+    Twpp::UInt32 x;
+    Twpp::UInt32 y;
+    Twpp::BarCodeRotation rotation;
+    Twpp::UInt32 confidence; // 0-100, grows with the number of scan lines that agree / 随一致扫描线数量增长
+};
+
+// Bar codes and patch code found on a page.
+// 页面上找到的条码和分隔码
+struct PageCodes {
+    std::vector<BarCode> barCodes;
+    bool patchFound = false;
+    Twpp::PatchCode patch = Twpp::PatchCode::P1;
+};
+
+// Bar code types `detectCodes` is able to decode.
+// detectCodes 能够解码的条码类型
+const std::vector<Twpp::BarCodeType>& supportedBarCodeTypes();
+
+// Decodes 1D bar codes of `types` (in priority order) and patch codes of BGR or BGRA pixels.
+// Rows are scanned in both directions for upright and upside-down codes, columns for rotated ones,
+// only every few pixels so that the page can be processed while it is being transferred.
+// 解码 BGR 或 BGRA 像素中 types 类型（按优先级顺序）的一维条码以及分隔码
+// 双向扫描行以识别正向和倒置的条码，扫描列以识别旋转的条码，
+// 仅每隔几个像素扫描一次，以便在传输页面的同时处理页面
+PageCodes detectCodes(const ImageView& page, const std::vector<Twpp::BarCodeType>& types, bool patchCodes);
+
+#endif // BARCODE_HPP
@@ -0,0 +1,87 @@
+﻿#include <algorithm>
+#include <cstdlib>
+#include "blankpage.hpp"
+#include "thumbnail.hpp"
+using namespace Twpp;
+
+static constexpr const UInt32 SMALL_SIZE = 256;
+static constexpr const int INK_DIFFERENCE = 40;
+static constexpr const int EDGE_GRADIENT = 48;
+
+BlankPageStats analyzeBlankPage(const ImageView& page) {
+    BlankPageStats stats;
+
+    const auto thumb = makeThumbnail(page, SMALL_SIZE);
+    const auto w = thumb.width;
+    const auto h = thumb.height;
+    if (w < 3 || h < 3) {
+        return stats;
+    }
+
+    const auto& small = thumb.pixels;
+    const auto area = static_cast<std::uint64_t>(thumb.factor) * thumb.factor;
+
+    // four interleaved histograms, so that equal neighbouring values
+    // do not serialize on the same counter
+    // 四个交错的直方图，避免相邻的相同值在同一计数器上串行化
+    UInt32 hist[4][256] = {};
+    const auto count = small.size();
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        hist[0][small[i]]++;
+        hist[1][small[i + 1]]++;
+        hist[2][small[i + 2]]++;
+        hist[3][small[i + 3]]++;
+    }
+
+    for (; i < count; i++) {
+        hist[0][small[i]]++;
+    }
+
+    // background = most populated window of 16 gray levels
+    // 背景 = 像素最多的 16 级灰度窗口
+    UInt32 merged[256];
+    for (int v = 0; v < 256; v++) {
+        merged[v] = hist[0][v] + hist[1][v] + hist[2][v] + hist[3][v];
+    }
+
+    UInt32 window = 0;
+    for (int v = 0; v < 16; v++) {
+        window += merged[v];
+    }
+
+    UInt32 best = window;
+    int background = 8;
+    for (int v = 16; v < 256; v++) {
+        window += merged[v] - merged[v - 16];
+        if (window > best) {
+            best = window;
+            background = v - 8;
+        }
+    }
+
+    std::uint64_t ink = 0;
+    for (int v = 0; v < 256; v++) {
+        if (std::abs(v - background) > INK_DIFFERENCE) {
+            ink += merged[v];
+        }
+    }
+
+    // gradient over the interior / 内部区域的梯度
+    std::uint64_t edges = 0;
+    for (UInt32 y = 1; y + 1 < h; y++) {
+        const unsigned char* row = small.data() + static_cast<std::size_t>(y) * w;
+        const unsigned char* up = row - w;
+        const unsigned char* down = row + w;
+        for (UInt32 x = 1; x + 1 < w; x++) {
+            const int gx = std::abs(row[x + 1] - row[x - 1]);
+            const int gy = std::abs(down[x] - up[x]);
+            edges += gx + gy > EDGE_GRADIENT ? 1 : 0;
+        }
+    }
+
+    stats.inkRatio = static_cast<double>(ink) / count;
+    stats.edgeRatio = static_cast<double>(edges) / ((w - 2) * (h - 2));
+    stats.inkPixels = ink * area;
+    return stats;
+}
@@ -0,0 +1,21 @@
+﻿#ifndef BLANKPAGE_HPP
+#define BLANKPAGE_HPP
+
+#include "imageview.hpp"
+
+// Content statistics of a captured page, computed on a downsampled gray copy.
+// 采集页面的内容统计，在缩小的灰度副本上计算
+struct BlankPageStats {
+    double inkRatio = 0.0;        // pixels differing from the background / 与背景不同的像素比例
+    double edgeRatio = 0.0;       // pixels on an edge / 位于边缘的像素比例
+    std::uint64_t inkPixels = 0;   // estimate at full resolution / 全分辨率下的估计值
+};
+
+// Analyzes BGR or BGRA pixels (3 or 4 channels).
+// The page is reduced to at most 256 pixels on the longer side, the background level
+// is the most frequent gray level, and the edges are found by a simple gradient.
+// 分析 BGR 或 BGRA 像素（3 或 4 通道）
+// 页面缩小到长边最多 256 像素，背景灰度取出现最多的灰度级，边缘由简单梯度求得
+BlankPageStats analyzeBlankPage(const ImageView& page);
+
+#endif // BLANKPAGE_HPP
@@ -12,6 +12,8 @@ QList<QVideoFrame::PixelFormat> QtCameraCapture::supportedPixelFormats(QAbstract
             << QVideoFrame::Format_ARGB32
             << QVideoFrame::Format_ARGB32_Premultiplied
             << QVideoFrame::Format_RGB32
+            << QVideoFrame::Format_YUYV
+            << QVideoFrame::Format_NV12
             << QVideoFrame::Format_AdobeDng;
 }
 
@@ -19,28 +21,46 @@ bool QtCameraCapture::present(const QVideoFrame &frame)
 {
     if (frame.isValid()) {
         QVideoFrame cloneFrame(frame);
-        cloneFrame.map(QAbstractVideoBuffer::ReadOnly);
-        int format= QVideoFrame::imageFormatFromPixelFormat(cloneFrame.pixelFormat());
+        if (!cloneFrame.map(QAbstractVideoBuffer::ReadOnly)) {
+            qDebug() << "frame can not be mapped";
+            return false;
+        }
+        QImage::Format format = QVideoFrame::imageFormatFromPixelFormat(cloneFrame.pixelFormat());
         if (format != QImage::Format_Invalid)
         {
             const QImage image(cloneFrame.bits(),
                                cloneFrame.width(),
                                cloneFrame.height(),
-                               QVideoFrame::imageFormatFromPixelFormat(cloneFrame.pixelFormat()));
+                               cloneFrame.bytesPerLine(),
+                               format);
             emit frameAvailable(image);
-            cloneFrame.unmap();
-            return true;
         }
-        else {
-            if (cloneFrame.pixelFormat() == QVideoFrame::Format_YUYV)
-            {
-                qDebug() << "QVideoFrame::Format_YUYV";
+        else if (cloneFrame.pixelFormat() == QVideoFrame::Format_YUYV ||
+                 cloneFrame.pixelFormat() == QVideoFrame::Format_NV12)
+        {
+            // raw formats of most USB cameras, converted here instead of asking the camera for RGB
+            // 大多数 USB 摄像头的原始格式，在此转换，而不是要求摄像头输出 RGB
+            if (m_rgb.size() != cloneFrame.size()) {
+                m_rgb = QImage(cloneFrame.size(), QImage::Format_RGB32);
+            }
+            auto width = static_cast<Twpp::UInt32>(cloneFrame.width());
+            auto height = static_cast<Twpp::UInt32>(cloneFrame.height());
+            auto dstStride = static_cast<Twpp::UInt32>(m_rgb.bytesPerLine());
+            if (cloneFrame.pixelFormat() == QVideoFrame::Format_YUYV) {
+                yuyvToRgb32(cloneFrame.bits(), static_cast<Twpp::UInt32>(cloneFrame.bytesPerLine()),
+                            width, height, m_rgb.bits(), dstStride);
             }
-            else
-            {
-                int nbytes = frame.mappedBytes();
-                emit frameAvailable(QImage::fromData(frame.bits(), nbytes));
+            else {
+                nv12ToRgb32(cloneFrame.bits(0), static_cast<Twpp::UInt32>(cloneFrame.bytesPerLine(0)),
+                            cloneFrame.bits(1), static_cast<Twpp::UInt32>(cloneFrame.bytesPerLine(1)),
+                            width, height, m_rgb.bits(), dstStride);
             }
+            emit frameAvailable(m_rgb);
+        }
+        else
+        {
+            int nbytes = cloneFrame.mappedBytes();
+            emit frameAvailable(QImage::fromData(cloneFrame.bits(), nbytes));
         }
         cloneFrame.unmap();
         return true;
@@ -53,6 +73,7 @@ bool QtCameraCapture::present(const QVideoFrame &frame)
 //--------------------------------------------------------------------------------------------
 QtCamera::QtCamera(QCameraInfo cameraInfo, QObject *parent, const TwGlue& glue) :
     QObject(parent),
+    m_camera(NULL),
     m_glue(glue)
 {
     m_started = false;
@@ -123,9 +144,21 @@ bool QtCamera::start()
     return true;
 }
 
+bool QtCamera::startReplay()
+{
+    if (m_started) return false;
+    m_started = true;
+    return true;
+}
+
+QtCameraCapture *QtCamera::surface() const
+{
+    return m_cameraCapture;
+}
+
 bool QtCamera::stop()
 {
-    m_camera->stop();
+    if (m_camera != NULL) m_camera->stop();
     m_started = false;
     return true;
 }
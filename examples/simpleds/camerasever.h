@@ -6,6 +6,7 @@
 #include <QAbstractVideoSurface>
 #include "imageprovider.h"
 #include "twglue.hpp"
+#include "frameconverter.hpp"
 
 class QtCameraCapture : public QAbstractVideoSurface
 {
@@ -26,6 +27,8 @@ public:
     bool present(const QVideoFrame &frame) override;
 signals:
     void frameAvailable(QImage frame);
+private:
+    QImage              m_rgb; // converted YUV frame, reused while the size stays / 转换后的 YUV 帧，尺寸不变时复用
 };
 
 class QtCamera : public QObject
@@ -38,6 +41,10 @@ public:
     ~QtCamera();
 
     Q_INVOKABLE bool start();
+    // Starts without a camera device, frames are presented to `surface()` by the caller, e.g. a replay source.
+    // 不使用摄像头设备启动，由调用者向 surface() 提交帧，例如回放源
+    bool startReplay();
+    QtCameraCapture *surface() const;
     Q_INVOKABLE bool stop();
     Q_INVOKABLE bool isStarted();
     Q_INVOKABLE bool capture();
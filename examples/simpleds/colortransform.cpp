@@ -0,0 +1,376 @@
+﻿#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include "colortransform.hpp"
+using namespace Twpp;
+
+typedef std::array<double, 3> Vector3;
+typedef std::array<Vector3, 3> Matrix3;
+
+static constexpr const int NODES = 17;
+static constexpr const int NODE_SCALE = 16;
+
+static const ColorSpace CAMERA = {
+    "SimpleDs camera (nominal)", { 0.655f, 0.330f }, { 0.290f, 0.610f }, { 0.150f, 0.055f }, { 0.3127f, 0.3290f }, 2.0f
+};
+
+static const ColorSpace SRGB = {
+    "sRGB IEC61966-2.1", { 0.64f, 0.33f }, { 0.30f, 0.60f }, { 0.15f, 0.06f }, { 0.3127f, 0.3290f }, 0.0f
+};
+
+static const ColorSpace ADOBE_RGB = {
+    "Adobe RGB (1998)", { 0.64f, 0.33f }, { 0.21f, 0.71f }, { 0.15f, 0.06f }, { 0.3127f, 0.3290f }, 563.0f / 256.0f
+};
+
+// ICC profile connection space white / ICC 配置文件连接空间的白点
+static const Vector3 D50 = {{ 0.9642, 1.0, 0.8249 }};
+
+const ColorSpace& cameraColorSpace() noexcept {
+    return CAMERA;
+}
+
+const ColorSpace& srgbColorSpace() noexcept {
+    return SRGB;
+}
+
+const ColorSpace& adobeRgbColorSpace() noexcept {
+    return ADOBE_RGB;
+}
+
+static Vector3 mul(const Matrix3& m, const Vector3& v) {
+    Vector3 r;
+    for (int i = 0; i < 3; i++) {
+        r[i] = m[i][0] * v[0] + m[i][1] * v[1] + m[i][2] * v[2];
+    }
+
+    return r;
+}
+
+static Matrix3 mul(const Matrix3& a, const Matrix3& b) {
+    Matrix3 r;
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            r[i][j] = a[i][0] * b[0][j] + a[i][1] * b[1][j] + a[i][2] * b[2][j];
+        }
+    }
+
+    return r;
+}
+
+static Matrix3 inverse(const Matrix3& m) {
+    const double det = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+                       m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+                       m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+
+    Matrix3 r;
+    r[0][0] = (m[1][1] * m[2][2] - m[1][2] * m[2][1]) / det;
+    r[0][1] = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) / det;
+    r[0][2] = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) / det;
+    r[1][0] = (m[1][2] * m[2][0] - m[1][0] * m[2][2]) / det;
+    r[1][1] = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) / det;
+    r[1][2] = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) / det;
+    r[2][0] = (m[1][0] * m[2][1] - m[1][1] * m[2][0]) / det;
+    r[2][1] = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) / det;
+    r[2][2] = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) / det;
+    return r;
+}
+
+static Vector3 xyToXyz(const float xy[2]) {
+    return {{ xy[0] / xy[1], 1.0, (1.0 - xy[0] - xy[1]) / xy[1] }};
+}
+
+// linear RGB -> XYZ, white of the color space has Y = 1
+// 线性 RGB -> XYZ，色彩空间的白点 Y = 1
+static Matrix3 rgbToXyz(const ColorSpace& space) {
+    const Vector3 r = xyToXyz(space.red);
+    const Vector3 g = xyToXyz(space.green);
+    const Vector3 b = xyToXyz(space.blue);
+    const Matrix3 primaries = {{ {{ r[0], g[0], b[0] }}, {{ r[1], g[1], b[1] }}, {{ r[2], g[2], b[2] }} }};
+
+    const Vector3 scale = mul(inverse(primaries), xyToXyz(space.white));
+    Matrix3 m = primaries;
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            m[i][j] *= scale[j];
+        }
+    }
+
+    return m;
+}
+
+// Bradford chromatic adaptation / Bradford 色适应
+static Matrix3 adaptation(const Vector3& from, const Vector3& to) {
+    static const Matrix3 BRADFORD = {{
+        {{ 0.8951, 0.2664, -0.1614 }},
+        {{ -0.7502, 1.7135, 0.0367 }},
+        {{ 0.0389, -0.0685, 1.0296 }}
+    }};
+
+    const Vector3 src = mul(BRADFORD, from);
+    const Vector3 dst = mul(BRADFORD, to);
+    Matrix3 scale = {};
+    for (int i = 0; i < 3; i++) {
+        scale[i][i] = dst[i] / src[i];
+    }
+
+    return mul(inverse(BRADFORD), mul(scale, BRADFORD));
+}
+
+static double decode(const ColorSpace& space, double v) {
+    if (space.gamma > 0.0f) {
+        return std::pow(v, static_cast<double>(space.gamma));
+    }
+
+    return v <= 0.04045 ? v / 12.92 : std::pow((v + 0.055) / 1.055, 2.4);
+}
+
+static double encode(const ColorSpace& space, double v) {
+    v = std::min(std::max(v, 0.0), 1.0);
+    if (space.gamma > 0.0f) {
+        return std::pow(v, 1.0 / space.gamma);
+    }
+
+    return v <= 0.0031308 ? v * 12.92 : 1.055 * std::pow(v, 1.0 / 2.4) - 0.055;
+}
+
+void ColorTransform::setup(const ColorSpace& from, const ColorSpace& to) {
+    m_nodes.clear();
+    if (&from == &to) {
+        return;
+    }
+
+    const Matrix3 m = mul(inverse(rgbToXyz(to)), mul(adaptation(xyToXyz(from.white), xyToXyz(to.white)), rgbToXyz(from)));
+
+    m_nodes.resize(NODES * NODES * NODES * 3);
+    auto node = m_nodes.begin();
+    for (int r = 0; r < NODES; r++) {
+        for (int g = 0; g < NODES; g++) {
+            for (int b = 0; b < NODES; b++) {
+                const Vector3 linear = {{
+                    decode(from, r / (NODES - 1.0)), decode(from, g / (NODES - 1.0)), decode(from, b / (NODES - 1.0))
+                }};
+
+                const Vector3 out = mul(m, linear);
+                for (int c = 2; c >= 0; c--) {
+                    *node++ = static_cast<UInt16>(encode(to, out[c]) * 255 * NODE_SCALE + 0.5);
+                }
+            }
+        }
+    }
+}
+
+void ColorTransform::apply(const unsigned char* in, unsigned char* out, UInt32 width, UInt32 channels) const noexcept {
+    const UInt16* nodes = m_nodes.data();
+    const int dr = NODES * NODES * 3;
+    const int dg = NODES * 3;
+    const int db = 3;
+
+    for (UInt32 x = 0; x < width; x++, in += channels, out += channels) {
+        // cell of the table and position within it, 0-255
+        // 查找表中的单元格及其中的位置，0-255
+        int pr = in[2] * (NODES - 1);
+        int pg = in[1] * (NODES - 1);
+        int pb = in[0] * (NODES - 1);
+        const int ir = std::min(pr / 255, NODES - 2);
+        const int ig = std::min(pg / 255, NODES - 2);
+        const int ib = std::min(pb / 255, NODES - 2);
+        const int fr = pr - ir * 255;
+        const int fg = pg - ig * 255;
+        const int fb = pb - ib * 255;
+
+        // the tetrahedron containing the color, vertices from c000 to c111
+        // 包含该颜色的四面体，顶点从 c000 到 c111
+        const UInt16* c000 = nodes + ir * dr + ig * dg + ib * db;
+        const UInt16* c111 = c000 + dr + dg + db;
+        const UInt16* c1;
+        const UInt16* c2;
+        int f0, f1, f2;
+        if (fr >= fg) {
+            if (fg >= fb) {
+                c1 = c000 + dr; c2 = c000 + dr + dg; f0 = fr; f1 = fg; f2 = fb;
+            }
+            else if (fr >= fb) {
+                c1 = c000 + dr; c2 = c000 + dr + db; f0 = fr; f1 = fb; f2 = fg;
+            }
+            else {
+                c1 = c000 + db; c2 = c000 + dr + db; f0 = fb; f1 = fr; f2 = fg;
+            }
+        }
+        else {
+            if (fb >= fg) {
+                c1 = c000 + db; c2 = c000 + dg + db; f0 = fb; f1 = fg; f2 = fr;
+            }
+            else if (fb >= fr) {
+                c1 = c000 + dg; c2 = c000 + dg + db; f0 = fg; f1 = fb; f2 = fr;
+            }
+            else {
+                c1 = c000 + dg; c2 = c000 + dr + dg; f0 = fg; f1 = fr; f2 = fb;
+            }
+        }
+
+        for (int c = 0; c < 3; c++) {
+            const int v = c000[c] * 255 + f0 * (c1[c] - c000[c]) + f1 * (c2[c] - c1[c]) + f2 * (c111[c] - c2[c]);
+            out[c] = static_cast<unsigned char>((v + 255 * NODE_SCALE / 2) / (255 * NODE_SCALE));
+        }
+
+        if (channels == 4) {
+            out[3] = in[3];
+        }
+    }
+}
+
+// big-endian writer of ICC structures / ICC 结构的大端写入器
+class IccWriter {
+
+public:
+    void u8(UInt32 v) {
+        m_data.push_back(static_cast<unsigned char>(v));
+    }
+
+    void u16(UInt32 v) {
+        u8(v >> 8);
+        u8(v);
+    }
+
+    void u32(UInt32 v) {
+        u16(v >> 16);
+        u16(v);
+    }
+
+    void sig(const char* s) {
+        m_data.insert(m_data.end(), s, s + 4);
+    }
+
+    void s15f16(double v) {
+        u32(static_cast<UInt32>(static_cast<Int32>(std::floor(v * 65536.0 + 0.5))));
+    }
+
+    void zeros(std::size_t count) {
+        m_data.resize(m_data.size() + count, 0);
+    }
+
+    void align() {
+        zeros((4 - m_data.size() % 4) % 4);
+    }
+
+    void put32(std::size_t offset, UInt32 v) {
+        for (int i = 0; i < 4; i++) {
+            m_data[offset + i] = static_cast<unsigned char>(v >> (24 - 8 * i));
+        }
+    }
+
+    std::size_t size() const noexcept {
+        return m_data.size();
+    }
+
+    std::vector<unsigned char>& data() noexcept {
+        return m_data;
+    }
+
+private:
+    std::vector<unsigned char> m_data;
+
+};
+
+std::vector<unsigned char> makeIccProfile(const ColorSpace& space) {
+    // colorants adapted to the D50 connection space / 适应到 D50 连接空间的原色
+    const Matrix3 m = mul(adaptation(xyToXyz(space.white), D50), rgbToXyz(space));
+
+    IccWriter w;
+    w.u32(0); // size, written at the end / 大小，最后写入
+    w.u32(0);
+    w.u32(0x02100000);
+    w.sig("mntr");
+    w.sig("RGB ");
+    w.sig("XYZ ");
+    for (UInt32 v : { 2020, 1, 1, 0, 0, 0 }) {
+        w.u16(v);
+    }
+
+    w.sig("acsp");
+    w.zeros(28); // platform, flags, manufacturer, model, attributes, rendering intent / 平台、标志、制造商、型号、属性、渲染意图
+    for (double v : D50) {
+        w.s15f16(v);
+    }
+
+    w.zeros(48); // creator, ID, reserved / 创建者、ID、保留
+
+    // tag table, the three curves share their data
+    // 标签表，三条曲线共用数据
+    const char* tags[] = { "desc", "cprt", "wtpt", "rXYZ", "gXYZ", "bXYZ", "rTRC", "gTRC", "bTRC" };
+    const std::size_t tagCount = sizeof(tags) / sizeof(tags[0]);
+    w.u32(static_cast<UInt32>(tagCount));
+    const auto table = w.size();
+    for (auto tag : tags) {
+        w.sig(tag);
+        w.u32(0);
+        w.u32(0);
+    }
+
+    auto setTag = [&w, table](std::size_t index, std::size_t begin) {
+        w.put32(table + index * 12 + 4, static_cast<UInt32>(begin));
+        w.put32(table + index * 12 + 8, static_cast<UInt32>(w.size() - begin));
+        w.align();
+    };
+
+    const auto nameLength = std::strlen(space.name) + 1;
+    auto begin = w.size();
+    w.sig("desc");
+    w.u32(0);
+    w.u32(static_cast<UInt32>(nameLength));
+    w.data().insert(w.data().end(), space.name, space.name + nameLength);
+    w.zeros(4 + 4 + 2 + 1 + 67); // no Unicode nor ScriptCode description / 无 Unicode 和 ScriptCode 描述
+    setTag(0, begin);
+
+    static const char COPYRIGHT[] = "No copyright, use freely";
+    begin = w.size();
+    w.sig("text");
+    w.u32(0);
+    w.data().insert(w.data().end(), COPYRIGHT, COPYRIGHT + sizeof(COPYRIGHT));
+    setTag(1, begin);
+
+    begin = w.size();
+    w.sig("XYZ ");
+    w.u32(0);
+    for (double v : D50) {
+        w.s15f16(v);
+    }
+
+    setTag(2, begin);
+
+    for (int c = 0; c < 3; c++) {
+        begin = w.size();
+        w.sig("XYZ ");
+        w.u32(0);
+        for (int i = 0; i < 3; i++) {
+            w.s15f16(m[i][c]);
+        }
+
+        setTag(3 + c, begin);
+    }
+
+    begin = w.size();
+    w.sig("curv");
+    w.u32(0);
+    if (space.gamma > 0.0f) {
+        w.u32(1);
+        w.u16(static_cast<UInt32>(space.gamma * 256.0f + 0.5f));
+    }
+    else {
+        w.u32(1024);
+        for (int i = 0; i < 1024; i++) {
+            w.u16(static_cast<UInt32>(decode(space, i / 1023.0) * 65535.0 + 0.5));
+        }
+    }
+
+    const auto curveSize = w.size() - begin;
+    for (int c = 0; c < 3; c++) {
+        w.put32(table + (6 + c) * 12 + 4, static_cast<UInt32>(begin));
+        w.put32(table + (6 + c) * 12 + 8, static_cast<UInt32>(curveSize));
+    }
+
+    w.align();
+    w.put32(0, static_cast<UInt32>(w.size()));
+    return std::move(w.data());
+}
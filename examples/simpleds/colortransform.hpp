@@ -0,0 +1,50 @@
+﻿#ifndef COLORTRANSFORM_HPP
+#define COLORTRANSFORM_HPP
+
+#include <vector>
+#include <twpp.hpp>
+
+// RGB color space, given by CIE xy chromaticities of its primaries and white point, and its transfer curve.
+// 由原色和白点的 CIE xy 色度以及传递曲线定义的 RGB 色彩空间
+struct ColorSpace {
+    const char* name;      // ICC profile description / ICC 配置文件描述
+    float red[2];
+    float green[2];
+    float blue[2];
+    float white[2];
+    float gamma;           // pure power curve, 0 = sRGB curve / 纯幂函数曲线，0 = sRGB 曲线
+};
+
+// Nominal characterization of the camera, replace it by measured values of the device.
+// 摄像头的标称特性，请替换为设备的实测值
+const ColorSpace& cameraColorSpace() noexcept;
+const ColorSpace& srgbColorSpace() noexcept;
+const ColorSpace& adobeRgbColorSpace() noexcept;
+
+// Converts pixels between two color spaces through a 3D lookup table built once by `setup`.
+// Lookups use tetrahedral interpolation between the 4 nodes around each color,
+// so the cost per pixel does not depend on how the table was computed.
+// 通过 setup 一次性构建的三维查找表在两个色彩空间之间转换像素
+// 查找时在每种颜色周围的 4 个节点之间进行四面体插值，因此每像素的开销与查找表的计算方式无关
+class ColorTransform {
+
+public:
+    void setup(const ColorSpace& from, const ColorSpace& to);
+
+    bool isIdentity() const noexcept {
+        return m_nodes.empty();
+    }
+
+    // Converts `width` BGR pixels, `channels` (3 or 4) bytes each, `out` may alias `in`.
+    // 转换 width 个 BGR 像素，每个 channels（3 或 4）字节，out 可以与 in 相同
+    void apply(const unsigned char* in, unsigned char* out, Twpp::UInt32 width, Twpp::UInt32 channels) const noexcept;
+
+private:
+    std::vector<Twpp::UInt16> m_nodes; // B, G, R of each node, 16 steps per 8-bit level / 每个节点的 B、G、R，每个 8 位级别 16 步
+};
+
+// Matrix/TRC ICC v2 display profile of the color space.
+// 色彩空间的矩阵/TRC ICC v2 显示配置文件
+std::vector<unsigned char> makeIccProfile(const ColorSpace& space);
+
+#endif // COLORTRANSFORM_HPP
@@ -0,0 +1,314 @@
+﻿#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include "deskew.hpp"
+#include "thumbnail.hpp"
+using namespace Twpp;
+
+static constexpr const UInt32 SMALL_SIZE = 512;
+static constexpr const float MAX_ANGLE = 15.0f;
+static constexpr const int EDGE_GRADIENT = 40;
+static constexpr const UInt32 MIN_EDGES = 64;
+static constexpr const UInt32 TILE = 64;
+static constexpr const float PI = 3.14159265f;
+
+struct Point {
+    float x;
+    float y;
+};
+
+// sharpness of the profile of points projected perpendicular to lines at `angle`
+// 沿 angle 方向的直线垂直投影后的轮廓锐度
+static double profileScore(const std::vector<Point>& points, float angle, std::vector<UInt32>& bins, float offset) {
+    const float s = std::sin(angle * PI / 180.0f);
+    const float c = std::cos(angle * PI / 180.0f);
+
+    std::fill(bins.begin(), bins.end(), 0);
+    for (const auto& p : points) {
+        auto r = static_cast<std::size_t>(p.y * c - p.x * s + offset);
+        bins[r]++;
+    }
+
+    double score = 0.0;
+    for (auto b : bins) {
+        score += static_cast<double>(b) * b;
+    }
+
+    return score;
+}
+
+static float estimateAngle(const Thumbnail& thumb, bool& found) {
+    // points on horizontal edges: text lines, page top and bottom
+    // 水平边缘上的点：文本行、页面上下边缘
+    std::vector<Point> points;
+    for (UInt32 y = 1; y + 1 < thumb.height; y++) {
+        const unsigned char* up = thumb.row(y - 1);
+        const unsigned char* row = thumb.row(y);
+        const unsigned char* down = thumb.row(y + 1);
+        for (UInt32 x = 1; x + 1 < thumb.width; x++) {
+            const int gy = std::abs(down[x] - up[x]);
+            const int gx = std::abs(row[x + 1] - row[x - 1]);
+            if (gy > EDGE_GRADIENT && gy > gx) {
+                points.push_back({static_cast<float>(x), static_cast<float>(y)});
+            }
+        }
+    }
+
+    found = false;
+    if (points.size() < MIN_EDGES) {
+        return 0.0f;
+    }
+
+    const float offset = static_cast<float>(thumb.width + 1);
+    std::vector<UInt32> bins(thumb.width + thumb.height + 3);
+
+    // coarse search in whole degrees, then refine by tenths
+    // 先以整度粗搜索，再以 0.1 度细化
+    float best = 0.0f;
+    double bestScore = 0.0;
+    double sum = 0.0;
+    int count = 0;
+    for (float a = -MAX_ANGLE; a <= MAX_ANGLE; a += 1.0f) {
+        auto score = profileScore(points, a, bins, offset);
+        sum += score;
+        count++;
+        if (score > bestScore) {
+            bestScore = score;
+            best = a;
+        }
+    }
+
+    // a flat score means no dominant line direction
+    // 得分平坦说明没有主导的直线方向
+    if (bestScore < 1.05 * sum / count) {
+        return 0.0f;
+    }
+
+    const float coarse = best;
+    for (int i = -10; i <= 10; i++) {
+        const float a = coarse + i * 0.1f;
+        auto score = profileScore(points, a, bins, offset);
+        if (score > bestScore) {
+            bestScore = score;
+            best = a;
+        }
+    }
+
+    found = true;
+    return std::fabs(best) < 0.05f ? 0.0f : best;
+}
+
+static UInt8 otsu(const Thumbnail& thumb) {
+    UInt32 hist[256] = {};
+    for (auto v : thumb.pixels) {
+        hist[v]++;
+    }
+
+    const double total = static_cast<double>(thumb.pixels.size());
+    double sumAll = 0.0;
+    for (int v = 0; v < 256; v++) {
+        sumAll += static_cast<double>(v) * hist[v];
+    }
+
+    double sumLow = 0.0;
+    double weightLow = 0.0;
+    double bestVar = 0.0;
+    int best = 128;
+    for (int t = 0; t < 256; t++) {
+        weightLow += hist[t];
+        if (weightLow == 0.0 || weightLow == total) {
+            continue;
+        }
+
+        sumLow += static_cast<double>(t) * hist[t];
+        const double meanLow = sumLow / weightLow;
+        const double meanHigh = (sumAll - sumLow) / (total - weightLow);
+        const double var = weightLow * (total - weightLow) * (meanLow - meanHigh) * (meanLow - meanHigh);
+        if (var > bestVar) {
+            bestVar = var;
+            best = t;
+        }
+    }
+
+    return static_cast<UInt8>(best);
+}
+
+// first and last index whose count reaches half of the maximum
+// 计数达到最大值一半的第一个和最后一个索引
+static void extent(const std::vector<UInt32>& counts, UInt32& first, UInt32& last) {
+    const auto max = *std::max_element(counts.begin(), counts.end());
+    first = 0;
+    last = static_cast<UInt32>(counts.size()) - 1;
+    while (first < last && counts[first] * 2 < max) {
+        first++;
+    }
+
+    while (last > first && counts[last] * 2 < max) {
+        last--;
+    }
+}
+
+PageGeometry analyzePage(const ImageView& page, bool deskew, bool crop) {
+    PageGeometry geometry;
+    geometry.width = page.width;
+    geometry.height = page.height;
+
+    if (!deskew && !crop) {
+        return geometry;
+    }
+
+    const auto thumb = makeThumbnail(page, SMALL_SIZE);
+    if (thumb.width < 8 || thumb.height < 8) {
+        return geometry;
+    }
+
+    if (deskew) {
+        geometry.angle = estimateAngle(thumb, geometry.angleFound);
+    }
+
+    if (!crop) {
+        return geometry;
+    }
+
+    // bright pixels projected into the deskewed thumbnail
+    // 明亮像素投影到纠偏后的缩略图中
+    const auto threshold = otsu(thumb);
+    const float s = std::sin(-geometry.angle * PI / 180.0f);
+    const float c = std::cos(-geometry.angle * PI / 180.0f);
+    const float cx = thumb.width / 2.0f;
+    const float cy = thumb.height / 2.0f;
+
+    std::vector<UInt32> cols(thumb.width, 0);
+    std::vector<UInt32> rows(thumb.height, 0);
+    UInt32 bright = 0;
+    for (UInt32 y = 0; y < thumb.height; y++) {
+        const unsigned char* row = thumb.row(y);
+        for (UInt32 x = 0; x < thumb.width; x++) {
+            if (row[x] <= threshold) {
+                continue;
+            }
+
+            bright++;
+            const float dx = x + 0.5f - cx;
+            const float dy = y + 0.5f - cy;
+            const auto u = static_cast<int>(cx + c * dx - s * dy);
+            const auto v = static_cast<int>(cy + s * dx + c * dy);
+            if (u >= 0 && v >= 0 && u < static_cast<int>(thumb.width) && v < static_cast<int>(thumb.height)) {
+                cols[static_cast<UInt32>(u)]++;
+                rows[static_cast<UInt32>(v)]++;
+            }
+        }
+    }
+
+    // nothing to separate, or the page fills the whole frame
+    // 没有可分离的内容，或者页面占满整个画面
+    const auto total = thumb.width * thumb.height;
+    if (bright < total / 10 || bright > total - total / 50) {
+        return geometry;
+    }
+
+    UInt32 x0, x1, y0, y1;
+    extent(cols, x0, x1);
+    extent(rows, y0, y1);
+
+    const auto f = thumb.factor;
+    geometry.left = std::min(x0 * f, page.width - 1);
+    geometry.top = std::min(y0 * f, page.height - 1);
+    geometry.width = std::min((x1 + 1) * f, page.width) - geometry.left;
+    geometry.height = std::min((y1 + 1) * f, page.height) - geometry.top;
+    return geometry;
+}
+
+ImageView transformPage(const ImageView& page, const PageGeometry& geometry, std::vector<unsigned char>& out) {
+    auto view = allocatePage(page, geometry, out);
+    transformPage(page, geometry, view, nullptr);
+    return view;
+}
+
+ImageView allocatePage(const ImageView& page, const PageGeometry& geometry, std::vector<unsigned char>& out) {
+    const auto outStride = static_cast<std::size_t>(geometry.width) * page.channels;
+    out.resize(outStride * geometry.height);
+
+    ImageView view;
+    view.data = out.data();
+    view.stride = static_cast<std::ptrdiff_t>(outStride);
+    view.width = geometry.width;
+    view.height = geometry.height;
+    view.channels = page.channels;
+    return view;
+}
+
+void transformPage(const ImageView& page, const PageGeometry& geometry, const ImageView& view,
+                   const std::function<void(UInt32 rows)>& progress) {
+    const auto ch = page.channels;
+    const auto w = geometry.width;
+    const auto h = geometry.height;
+    const auto outStride = static_cast<std::size_t>(view.stride);
+    const auto out = const_cast<unsigned char*>(view.data);
+
+    if (geometry.angle == 0.0f) {
+        // crop only / 仅裁剪
+        for (UInt32 y = 0; y < h; y++) {
+            std::memcpy(out + y * outStride, page.row(geometry.top + y) + geometry.left * ch, outStride);
+            if (progress && ((y + 1) % TILE == 0 || y + 1 == h)) {
+                progress(y + 1);
+            }
+        }
+
+        return;
+    }
+
+    const float s = std::sin(geometry.angle * PI / 180.0f);
+    const float c = std::cos(geometry.angle * PI / 180.0f);
+    const float cx = page.width / 2.0f;
+    const float cy = page.height / 2.0f;
+    const float maxX = page.width - 0.5f;
+    const float maxY = page.height - 0.5f;
+    const int lastX = static_cast<int>(page.width) - 1;
+    const int lastY = static_cast<int>(page.height) - 1;
+
+    // source = center + R(angle) * (output - center), bilinear sampling
+    // 源坐标 = 中心 + R(angle) * (输出坐标 - 中心)，双线性采样
+    for (UInt32 ty = 0; ty < h; ty += TILE) {
+        const auto tyEnd = std::min(ty + TILE, h);
+        for (UInt32 tx = 0; tx < w; tx += TILE) {
+            const auto txEnd = std::min(tx + TILE, w);
+            for (UInt32 y = ty; y < tyEnd; y++) {
+                const float qy = geometry.top + y + 0.5f - cy;
+                const float qx = geometry.left + tx + 0.5f - cx;
+                float sx = cx + c * qx - s * qy - 0.5f;
+                float sy = cy + s * qx + c * qy - 0.5f;
+
+                unsigned char* dst = out + y * outStride + tx * ch;
+                for (UInt32 x = tx; x < txEnd; x++, sx += c, sy += s, dst += ch) {
+                    if (sx < -0.5f || sy < -0.5f || sx > maxX || sy > maxY) {
+                        std::fill(dst, dst + ch, 255);
+                        continue;
+                    }
+
+                    const float fx = std::floor(sx);
+                    const float fy = std::floor(sy);
+                    const float ax = sx - fx;
+                    const float ay = sy - fy;
+                    const int x0 = static_cast<int>(fx);
+                    const int y0 = static_cast<int>(fy);
+
+                    const auto cx0 = static_cast<UInt32>(std::max(x0, 0));
+                    const auto cx1 = static_cast<UInt32>(std::min(x0 + 1, lastX));
+                    const unsigned char* r0 = page.row(static_cast<UInt32>(std::max(y0, 0)));
+                    const unsigned char* r1 = page.row(static_cast<UInt32>(std::min(y0 + 1, lastY)));
+                    for (UInt32 k = 0; k < ch; k++) {
+                        const float top = r0[cx0 * ch + k] + ax * (r0[cx1 * ch + k] - r0[cx0 * ch + k]);
+                        const float bottom = r1[cx0 * ch + k] + ax * (r1[cx1 * ch + k] - r1[cx0 * ch + k]);
+                        dst[k] = static_cast<unsigned char>(top + ay * (bottom - top) + 0.5f);
+                    }
+                }
+            }
+        }
+
+        if (progress) {
+            progress(tyEnd);
+        }
+    }
+}
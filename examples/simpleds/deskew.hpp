@@ -0,0 +1,50 @@
+﻿#ifndef DESKEW_HPP
+#define DESKEW_HPP
+
+#include <functional>
+#include <vector>
+#include "imageview.hpp"
+
+// Skew and page bounds found by `analyzePage`.
+// Coordinates are in page pixels after deskewing, i.e. after rotating by -angle around the page center.
+// analyzePage 得到的倾斜角和页面边界
+// 坐标为纠偏后（绕页面中心旋转 -angle 后）的页面像素
+struct PageGeometry {
+    float angle = 0.0f;          // skew of the content in degrees, clockwise / 内容的顺时针倾斜角（度）
+    bool angleFound = false;     // deskew was requested and succeeded / 请求了纠偏且成功
+    Twpp::UInt32 left = 0;
+    Twpp::UInt32 top = 0;
+    Twpp::UInt32 width = 0;
+    Twpp::UInt32 height = 0;
+
+    bool isIdentity(const ImageView& page) const noexcept {
+        return angle == 0.0f && left == 0 && top == 0 && width == page.width && height == page.height;
+    }
+};
+
+// Estimates skew and/or page bounds on a downsampled copy of BGR or BGRA pixels.
+// The angle comes from the projection profile of horizontal edges, the bounds
+// from the bright (paper) area separated from the darker background by Otsu threshold.
+// 在 BGR 或 BGRA 像素的缩小副本上估计倾斜角和/或页面边界
+// 角度来自水平边缘的投影轮廓，边界来自用 Otsu 阈值从较暗背景中分离出的明亮（纸张）区域
+PageGeometry analyzePage(const ImageView& page, bool deskew, bool crop);
+
+// Rotates and crops full-resolution pixels into `out` (top-down, tightly packed),
+// working in small tiles so that the rotated source reads stay in cache.
+// Areas outside of the page are white.
+// 将全分辨率像素旋转并裁剪到 out（自顶向下，紧密排列），按小块处理以使旋转后的源读取保持在缓存中
+// 页面以外的区域为白色
+ImageView transformPage(const ImageView& page, const PageGeometry& geometry, std::vector<unsigned char>& out);
+
+// Sizes `out` for the transformed page without filling it.
+// 为变换后的页面分配 out，但不填充
+ImageView allocatePage(const ImageView& page, const PageGeometry& geometry, std::vector<unsigned char>& out);
+
+// Fills the page allocated by `allocatePage` from the top, band by band.
+// `progress` receives the number of finished rows after every band, so that they can be consumed while the rest is transformed.
+// 自顶向下逐条带填充由 allocatePage 分配的页面
+// 每完成一个条带，progress 都会收到已完成的行数，以便在变换其余部分的同时使用这些行
+void transformPage(const ImageView& page, const PageGeometry& geometry, const ImageView& out,
+                   const std::function<void(Twpp::UInt32 rows)>& progress);
+
+#endif // DESKEW_HPP
@@ -0,0 +1,63 @@
+﻿#include "frameconverter.hpp"
+using namespace Twpp;
+
+// chroma contributions of a U V pair, shared by the pixels the pair covers
+// 一对 U V 的色度分量，由该对覆盖的像素共享
+struct Chroma {
+    int r;
+    int g;
+    int b;
+};
+
+static inline Chroma chroma(unsigned char u, unsigned char v) noexcept {
+    int d = static_cast<int>(u) - 128;
+    int e = static_cast<int>(v) - 128;
+    return { 409 * e + 128, -100 * d - 208 * e + 128, 516 * d + 128 };
+}
+
+static inline UInt32 clamp8(int value) noexcept {
+    value >>= 8;
+    return static_cast<UInt32>(value < 0 ? 0 : value > 255 ? 255 : value);
+}
+
+static inline UInt32 rgb32(unsigned char y, const Chroma& c) noexcept {
+    int luma = 298 * (static_cast<int>(y) - 16);
+    return 0xFF000000u | (clamp8(luma + c.r) << 16) | (clamp8(luma + c.g) << 8) | clamp8(luma + c.b);
+}
+
+void yuyvToRgb32(const unsigned char* src, UInt32 srcStride, UInt32 width, UInt32 height,
+                 unsigned char* dst, UInt32 dstStride) noexcept {
+    for (UInt32 row = 0; row < height; row++) {
+        auto in = src + static_cast<std::size_t>(row) * srcStride;
+        auto out = reinterpret_cast<UInt32*>(dst + static_cast<std::size_t>(row) * dstStride);
+        UInt32 x = 0;
+        for (; x + 1 < width; x += 2, in += 4) {
+            auto c = chroma(in[1], in[3]);
+            out[x] = rgb32(in[0], c);
+            out[x + 1] = rgb32(in[2], c);
+        }
+
+        if (x < width) { // odd width, the last pair is incomplete / 宽度为奇数，最后一对不完整
+            out[x] = rgb32(in[0], chroma(in[1], in[3]));
+        }
+    }
+}
+
+void nv12ToRgb32(const unsigned char* y, UInt32 yStride, const unsigned char* uv, UInt32 uvStride,
+                 UInt32 width, UInt32 height, unsigned char* dst, UInt32 dstStride) noexcept {
+    for (UInt32 row = 0; row < height; row++) {
+        auto luma = y + static_cast<std::size_t>(row) * yStride;
+        auto pairs = uv + static_cast<std::size_t>(row / 2) * uvStride;
+        auto out = reinterpret_cast<UInt32*>(dst + static_cast<std::size_t>(row) * dstStride);
+        UInt32 x = 0;
+        for (; x + 1 < width; x += 2, pairs += 2) {
+            auto c = chroma(pairs[0], pairs[1]);
+            out[x] = rgb32(luma[x], c);
+            out[x + 1] = rgb32(luma[x + 1], c);
+        }
+
+        if (x < width) {
+            out[x] = rgb32(luma[x], chroma(pairs[0], pairs[1]));
+        }
+    }
+}
@@ -0,0 +1,26 @@
+﻿#ifndef FRAMECONVERTER_HPP
+#define FRAMECONVERTER_HPP
+
+#include <twpp.hpp>
+
+// Conversion of YUV camera frames into RGB32 pixels, the layout of QImage::Format_RGB32 (0xffRRGGBB words).
+// Both use BT.601 limited range coefficients in integer arithmetic, which is what USB (UVC) cameras deliver.
+// Destination rows must be 4-byte aligned, as QImage rows are.
+// 将 YUV 摄像头帧转换为 RGB32 像素，即 QImage::Format_RGB32 的布局（0xffRRGGBB 字）
+// 均使用 BT.601 有限范围系数和整数运算，与 USB（UVC）摄像头输出的一致
+// 目标行必须 4 字节对齐，QImage 的行满足此要求
+
+// YUYV (YUY2) 4:2:2, each pair of pixels is stored as Y0 U Y1 V.
+// YUYV（YUY2）4:2:2，每两个像素存储为 Y0 U Y1 V
+void yuyvToRgb32(const unsigned char* src, Twpp::UInt32 srcStride,
+                 Twpp::UInt32 width, Twpp::UInt32 height,
+                 unsigned char* dst, Twpp::UInt32 dstStride) noexcept;
+
+// NV12 4:2:0, a full size Y plane and a half size plane of interleaved U V pairs.
+// NV12 4:2:0，全尺寸的 Y 平面和半尺寸的 U V 交错平面
+void nv12ToRgb32(const unsigned char* y, Twpp::UInt32 yStride,
+                 const unsigned char* uv, Twpp::UInt32 uvStride,
+                 Twpp::UInt32 width, Twpp::UInt32 height,
+                 unsigned char* dst, Twpp::UInt32 dstStride) noexcept;
+
+#endif // FRAMECONVERTER_HPP
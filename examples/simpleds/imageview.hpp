@@ -0,0 +1,33 @@
+﻿#ifndef IMAGEVIEW_HPP
+#define IMAGEVIEW_HPP
+
+#include <twpp.hpp>
+#include <cstddef>
+
+// Non-owning view of 8-bit interleaved pixels.
+// The stride may be negative, so that a bottom-up BMP can be read top-down without copying.
+// 8 位交错像素的非拥有视图
+// 行距可以为负，这样无需复制即可自顶向下读取自底向上的 BMP
+struct ImageView {
+    const unsigned char* data = nullptr; // top row / 最上面一行
+    std::ptrdiff_t stride = 0;
+    Twpp::UInt32 width = 0;
+    Twpp::UInt32 height = 0;
+    Twpp::UInt32 channels = 0;
+
+    const unsigned char* row(Twpp::UInt32 y) const noexcept {
+        return data + stride * static_cast<std::ptrdiff_t>(y);
+    }
+
+    // rectangle of this view sharing its pixels, must lie within the view
+    // 与本视图共享像素的矩形区域，必须位于视图之内
+    ImageView crop(Twpp::UInt32 x, Twpp::UInt32 y, Twpp::UInt32 cropWidth, Twpp::UInt32 cropHeight) const noexcept {
+        ImageView view = *this;
+        view.data = row(y) + x * channels;
+        view.width = cropWidth;
+        view.height = cropHeight;
+        return view;
+    }
+};
+
+#endif // IMAGEVIEW_HPP
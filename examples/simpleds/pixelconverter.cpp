@@ -0,0 +1,208 @@
+﻿#include <algorithm>
+#include "pixelconverter.hpp"
+using namespace Twpp;
+
+// ordered dithering matrices, values 0 .. n*n-1
+// 有序抖动矩阵，取值 0 .. n*n-1
+static const unsigned char BAYER4[4][4] = {
+    { 0,  8,  2, 10},
+    {12,  4, 14,  6},
+    { 3, 11,  1,  9},
+    {15,  7, 13,  5}
+};
+
+static const unsigned char BAYER8[8][8] = {
+    { 0, 32,  8, 40,  2, 34, 10, 42},
+    {48, 16, 56, 24, 50, 18, 58, 26},
+    {12, 44,  4, 36, 14, 46,  6, 38},
+    {60, 28, 52, 20, 62, 30, 54, 22},
+    { 3, 35, 11, 43,  1, 33,  9, 41},
+    {51, 19, 59, 27, 49, 17, 57, 25},
+    {15, 47,  7, 39, 13, 45,  5, 37},
+    {63, 31, 55, 23, 61, 29, 53, 21}
+};
+
+void PixelConverter::setup(UInt32 width, Format format, BitDepthReduction method, UInt8 threshold, Halftone halftone) {
+    m_width = width;
+    m_format = format;
+    m_method = method;
+    m_threshold = threshold;
+    m_halftone = halftone;
+    m_tone = false;
+
+    m_gray.resize(width);
+    m_error.assign(width + 2, 0);
+    m_errorNext.assign(width + 2, 0);
+}
+
+void PixelConverter::setToneCurves(const ToneCurve& blue, const ToneCurve& green, const ToneCurve& red) {
+    m_curves[0] = blue;
+    m_curves[1] = green;
+    m_curves[2] = red;
+    m_tone = !isIdentity(blue) || !isIdentity(green) || !isIdentity(red);
+}
+
+UInt16 PixelConverter::bitsPerPixel(Format format) noexcept {
+    switch (format) {
+    case Format::Gray:
+        return 8;
+    case Format::BlackWhite:
+        return 1;
+    default:
+        return 24;
+    }
+}
+
+UInt32 PixelConverter::rowBytes() const noexcept {
+    return (m_width * bitsPerPixel(m_format) + 7) / 8;
+}
+
+void PixelConverter::convert(const unsigned char* bgr, UInt32 y, unsigned char* out) {
+    switch (m_format) {
+    case Format::Bgr:
+        if (m_tone) {
+            const auto* cb = m_curves[0].data();
+            const auto* cg = m_curves[1].data();
+            const auto* cr = m_curves[2].data();
+            for (UInt32 x = 0; x < m_width; x++, bgr += 3, out += 3) {
+                out[0] = cb[bgr[0]];
+                out[1] = cg[bgr[1]];
+                out[2] = cr[bgr[2]];
+            }
+        }
+        else if (out != bgr) {
+            std::copy(bgr, bgr + m_width * 3, out);
+        }
+        break;
+
+    case Format::Rgb:
+        if (m_tone) {
+            const auto* cb = m_curves[0].data();
+            const auto* cg = m_curves[1].data();
+            const auto* cr = m_curves[2].data();
+            for (UInt32 x = 0; x < m_width; x++, bgr += 3, out += 3) {
+                unsigned char b = cb[bgr[0]];
+                out[1] = cg[bgr[1]];
+                out[0] = cr[bgr[2]];
+                out[2] = b;
+            }
+        }
+        else {
+            for (UInt32 x = 0; x < m_width; x++, bgr += 3, out += 3) {
+                unsigned char b = bgr[0];
+                out[1] = bgr[1];
+                out[0] = bgr[2];
+                out[2] = b;
+            }
+        }
+        break;
+
+    case Format::Gray:
+        toGray(bgr, out);
+        break;
+
+    case Format::BlackWhite:
+        toGray(bgr, m_gray.data());
+        switch (m_method) {
+        case BitDepthReduction::HalfTone:
+            halftone(m_gray.data(), y, out);
+            break;
+        case BitDepthReduction::Diffusion:
+            diffusion(m_gray.data(), out);
+            break;
+        default:
+            threshold(m_gray.data(), out);
+            break;
+        }
+        break;
+    }
+}
+
+void PixelConverter::toGray(const unsigned char* bgr, unsigned char* gray) const noexcept {
+    // ITU-R BT.601 luma in 8-bit fixed point, a branch-free loop the compiler vectorizes
+    // ITU-R BT.601 亮度，8 位定点，无分支循环可由编译器向量化
+    for (UInt32 x = 0; x < m_width; x++) {
+        const unsigned b = bgr[3 * x];
+        const unsigned g = bgr[3 * x + 1];
+        const unsigned r = bgr[3 * x + 2];
+        gray[x] = static_cast<unsigned char>((29 * b + 150 * g + 77 * r + 128) >> 8);
+    }
+
+    if (m_tone) {
+        // the row is still in cache / 该行仍在缓存中
+        const auto* curve = m_curves[0].data();
+        for (UInt32 x = 0; x < m_width; x++) {
+            gray[x] = curve[gray[x]];
+        }
+    }
+}
+
+// packs 8 pixels per byte, `white(x)` decides each bit
+// 每字节打包 8 个像素，white(x) 决定每一位
+template<typename White>
+static void pack(UInt32 width, unsigned char* out, White white) {
+    UInt32 x = 0;
+    for (; x + 8 <= width; x += 8) {
+        unsigned char byte = 0;
+        for (UInt32 bit = 0; bit < 8; bit++) {
+            byte = static_cast<unsigned char>((byte << 1) | (white(x + bit) ? 1 : 0));
+        }
+
+        *out++ = byte;
+    }
+
+    if (x < width) {
+        unsigned char byte = 0;
+        for (UInt32 bit = 0; bit < 8; bit++) {
+            byte = static_cast<unsigned char>((byte << 1) | (x + bit < width && white(x + bit) ? 1 : 0));
+        }
+
+        *out = byte;
+    }
+}
+
+void PixelConverter::threshold(const unsigned char* gray, unsigned char* out) const noexcept {
+    const auto t = m_threshold;
+    pack(m_width, out, [gray, t](UInt32 x) {
+        return gray[x] >= t;
+    });
+}
+
+void PixelConverter::halftone(const unsigned char* gray, UInt32 y, unsigned char* out) const noexcept {
+    if (m_halftone == Halftone::Bayer4x4) {
+        const unsigned char* row = BAYER4[y % 4];
+        pack(m_width, out, [gray, row](UInt32 x) {
+            return gray[x] > row[x % 4] * 16 + 8;
+        });
+    }
+    else {
+        const unsigned char* row = BAYER8[y % 8];
+        pack(m_width, out, [gray, row](UInt32 x) {
+            return gray[x] > row[x % 8] * 4 + 2;
+        });
+    }
+}
+
+void PixelConverter::diffusion(const unsigned char* gray, unsigned char* out) noexcept {
+    // Floyd-Steinberg, errors are stored with one guard cell on each side
+    // Floyd-Steinberg，误差数组两端各有一个保护单元
+    std::fill(m_errorNext.begin(), m_errorNext.end(), 0);
+    int* cur = m_error.data() + 1;
+    int* next = m_errorNext.data() + 1;
+    const int t = m_threshold;
+
+    pack(m_width, out, [gray, cur, next, t](UInt32 ux) {
+        const auto x = static_cast<int>(ux);
+        const int value = gray[x] + cur[x];
+        const bool white = value >= t;
+        const int err = value - (white ? 255 : 0);
+
+        cur[x + 1] += err * 7 / 16;
+        next[x - 1] += err * 3 / 16;
+        next[x] += err * 5 / 16;
+        next[x + 1] += err / 16;
+        return white;
+    });
+
+    m_error.swap(m_errorNext);
+}
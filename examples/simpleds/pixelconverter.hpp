@@ -0,0 +1,75 @@
+﻿#ifndef PIXELCONVERTER_HPP
+#define PIXELCONVERTER_HPP
+
+#include <twpp.hpp>
+#include <vector>
+#include "tonecurve.hpp"
+
+// Converts BGR rows of the output image into the negotiated pixel format, one row at a time.
+// Gray and black & white rows are reduced from BGR, black & white uses threshold,
+// ordered dithering (halftone) or Floyd-Steinberg error diffusion.
+// Error diffusion carries state between rows, so rows must be converted top-down.
+// Tone curves are looked up in the same pass, before any bit depth reduction.
+// 将输出图像的 BGR 行逐行转换为协商的像素格式
+// 灰度和黑白由 BGR 降低位深，黑白支持阈值、有序抖动（半色调）或 Floyd-Steinberg 误差扩散
+// 误差扩散在行之间保留状态，因此必须自顶向下转换
+// 色调曲线在同一遍中查表，先于任何位深降低
+class PixelConverter {
+
+public:
+    enum class Format {
+        Bgr,       // BMP order, native transfer / BMP 顺序，本地传输
+        Rgb,       // memory transfer / 内存传输
+        Gray,      // 8 bits per pixel / 每像素 8 位
+        BlackWhite // 1 bit per pixel, MSB first, 1 = white / 每像素 1 位，高位在前，1 = 白
+    };
+
+    // ordered dithering patterns / 有序抖动图案
+    enum class Halftone {
+        Bayer4x4,
+        Bayer8x8
+    };
+
+    void setup(Twpp::UInt32 width, Format format,
+               Twpp::BitDepthReduction method = Twpp::BitDepthReduction::Threshold,
+               Twpp::UInt8 threshold = 128, Halftone halftone = Halftone::Bayer4x4);
+
+    // Curves of the blue, green and red channel, gray and black & white use the first one.
+    // Must be called after `setup`, which removes the curves.
+    // 蓝、绿、红通道的曲线，灰度和黑白使用第一条，必须在 setup 之后调用，setup 会移除曲线
+    void setToneCurves(const ToneCurve& blue, const ToneCurve& green, const ToneCurve& red);
+
+    bool hasToneCurves() const noexcept {
+        return m_tone;
+    }
+
+    static Twpp::UInt16 bitsPerPixel(Format format) noexcept;
+
+    // Bytes written by `convert`, excluding any row padding.
+    // convert 写入的字节数，不含行填充
+    Twpp::UInt32 rowBytes() const noexcept;
+
+    // Converts BGR row `y` (width * 3 bytes) into `out`, `out` may alias `bgr`.
+    // 将第 y 行 BGR（width * 3 字节）转换到 out，out 可以与 bgr 相同
+    void convert(const unsigned char* bgr, Twpp::UInt32 y, unsigned char* out);
+
+private:
+    void toGray(const unsigned char* bgr, unsigned char* gray) const noexcept;
+    void threshold(const unsigned char* gray, unsigned char* out) const noexcept;
+    void halftone(const unsigned char* gray, Twpp::UInt32 y, unsigned char* out) const noexcept;
+    void diffusion(const unsigned char* gray, unsigned char* out) noexcept;
+
+    Twpp::UInt32 m_width = 0;
+    Format m_format = Format::Bgr;
+    Twpp::BitDepthReduction m_method = Twpp::BitDepthReduction::Threshold;
+    Twpp::UInt8 m_threshold = 128;
+    Halftone m_halftone = Halftone::Bayer4x4;
+    bool m_tone = false;
+    ToneCurve m_curves[3]; // B, G, R
+
+    std::vector<unsigned char> m_gray;
+    std::vector<int> m_error;     // current row / 当前行
+    std::vector<int> m_errorNext; // next row / 下一行
+};
+
+#endif // PIXELCONVERTER_HPP
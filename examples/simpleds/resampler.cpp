@@ -0,0 +1,188 @@
+﻿#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "resampler.hpp"
+using namespace Twpp;
+
+static constexpr const UInt32 NO_ROW = std::numeric_limits<UInt32>::max();
+
+static float lanczos3(float x) {
+    x = std::fabs(x);
+    if (x < 1e-6f) {
+        return 1.0f;
+    }
+
+    if (x >= 3.0f) {
+        return 0.0f;
+    }
+
+    const float px = 3.14159265f * x;
+    return 3.0f * std::sin(px) * std::sin(px / 3.0f) / (px * px);
+}
+
+void Resampler::weights(UInt32 srcSize, UInt32 dstSize, std::vector<Taps>& taps, std::vector<float>& weights) {
+    taps.clear();
+    weights.clear();
+    taps.reserve(dstSize);
+
+    const float scale = static_cast<float>(srcSize) / dstSize; // source pixels per output pixel / 每个输出像素对应的源像素
+    const auto last = static_cast<int>(srcSize) - 1;
+    for (UInt32 i = 0; i < dstSize; i++) {
+        Taps t;
+        t.offset = static_cast<UInt32>(weights.size());
+
+        if (scale > 1.0f) {
+            // area: weight = covered part of the source pixel
+            // 面积：权重 = 源像素被覆盖的部分
+            const float lo = i * scale;
+            const float hi = std::min(lo + scale, static_cast<float>(srcSize));
+            const auto first = static_cast<UInt32>(lo);
+            const auto end = std::min(static_cast<UInt32>(std::ceil(hi)), srcSize);
+
+            t.first = first;
+            t.count = end - first;
+            for (auto j = first; j < end; j++) {
+                auto w = std::min(j + 1.0f, hi) - std::max(static_cast<float>(j), lo);
+                weights.push_back(w / scale);
+            }
+        }
+        else {
+            // Lanczos-3, taps outside of the image are folded into the edge pixels
+            // Lanczos-3，图像外的采样折叠到边缘像素
+            const float center = (i + 0.5f) * scale - 0.5f;
+            const auto base = static_cast<int>(std::floor(center));
+            const auto lo = std::max(base - 2, 0);
+            const auto hi = std::min(base + 3, last);
+
+            t.first = static_cast<UInt32>(lo);
+            t.count = static_cast<UInt32>(hi - lo + 1);
+            weights.resize(weights.size() + t.count, 0.0f);
+
+            float sum = 0.0f;
+            for (auto j = base - 2; j <= base + 3; j++) {
+                auto w = lanczos3(center - j);
+                weights[t.offset + static_cast<UInt32>(std::min(std::max(j, lo), hi) - lo)] += w;
+                sum += w;
+            }
+
+            for (UInt32 k = 0; k < t.count; k++) {
+                weights[t.offset + k] /= sum;
+            }
+        }
+
+        taps.push_back(t);
+    }
+}
+
+void Resampler::setup(UInt32 srcWidth, UInt32 srcHeight, UInt32 dstWidth, UInt32 dstHeight, UInt32 channels) {
+    m_srcWidth = srcWidth;
+    m_srcHeight = srcHeight;
+    m_dstWidth = dstWidth;
+    m_dstHeight = dstHeight;
+    m_channels = channels;
+
+    weights(srcWidth, dstWidth, m_xTaps, m_xWeights);
+    weights(srcHeight, dstHeight, m_yTaps, m_yWeights);
+
+    m_cacheRows = 0;
+    for (const auto& t : m_yTaps) {
+        m_cacheRows = std::max(m_cacheRows, t.count);
+    }
+
+    const auto rowSize = static_cast<std::size_t>(dstWidth) * channels;
+    m_cache.assign(rowSize * m_cacheRows, 0.0f);
+    m_cacheTags.assign(m_cacheRows, NO_ROW);
+    m_rows.resize(m_cacheRows);
+    m_acc.resize(rowSize);
+}
+
+bool Resampler::isIdentity() const noexcept {
+    return m_srcWidth == m_dstWidth && m_srcHeight == m_dstHeight;
+}
+
+UInt32 Resampler::width() const noexcept {
+    return m_dstWidth;
+}
+
+UInt32 Resampler::height() const noexcept {
+    return m_dstHeight;
+}
+
+UInt32 Resampler::sourceRows(UInt32 y) const noexcept {
+    // taps of successive rows never move up / 相邻输出行的采样位置不会向上移动
+    const auto& t = m_yTaps[y];
+    return t.first + t.count;
+}
+
+template<UInt32 ch>
+void Resampler::filterRow(const unsigned char* in, float* out) const {
+    const auto n = ch != 0 ? ch : m_channels;
+    for (UInt32 x = 0; x < m_dstWidth; x++, out += n) {
+        const auto& t = m_xTaps[x];
+        const unsigned char* s = in + static_cast<std::size_t>(t.first) * n;
+        const float* w = m_xWeights.data() + t.offset;
+
+        for (UInt32 c = 0; c < n; c++) {
+            out[c] = 0.0f;
+        }
+
+        for (UInt32 k = 0; k < t.count; k++, s += n) {
+            for (UInt32 c = 0; c < n; c++) {
+                out[c] += w[k] * s[c];
+            }
+        }
+    }
+}
+
+const float* Resampler::filtered(const ImageView& src, UInt32 srcRow) {
+    const auto slot = srcRow % m_cacheRows;
+    float* out = m_cache.data() + static_cast<std::size_t>(slot) * m_dstWidth * m_channels;
+    if (m_cacheTags[slot] == srcRow) {
+        return out;
+    }
+
+    const unsigned char* in = src.row(srcRow);
+    switch (m_channels) {
+    case 1:
+        filterRow<1>(in, out);
+        break;
+    case 3:
+        filterRow<3>(in, out);
+        break;
+    case 4:
+        filterRow<4>(in, out);
+        break;
+    default:
+        filterRow<0>(in, out);
+        break;
+    }
+
+    m_cacheTags[slot] = srcRow;
+    return out;
+}
+
+void Resampler::row(const ImageView& src, UInt32 y, unsigned char* out) {
+    const auto& t = m_yTaps[y];
+    for (UInt32 k = 0; k < t.count; k++) {
+        m_rows[k] = filtered(src, t.first + k);
+    }
+
+    // vertical pass over whole rows, a plain multiply-add the compiler vectorizes
+    // 对整行做垂直滤波，简单的乘加运算可由编译器向量化
+    const auto n = m_acc.size();
+    float* acc = m_acc.data();
+    const float* w = m_yWeights.data() + t.offset;
+    std::fill(m_acc.begin(), m_acc.end(), 0.0f);
+    for (UInt32 k = 0; k < t.count; k++) {
+        const float* r = m_rows[k];
+        const float wk = w[k];
+        for (std::size_t i = 0; i < n; i++) {
+            acc[i] += wk * r[i];
+        }
+    }
+
+    for (std::size_t i = 0; i < n; i++) {
+        auto v = acc[i] + 0.5f;
+        out[i] = static_cast<unsigned char>(v <= 0.0f ? 0.0f : (v >= 255.0f ? 255.0f : v));
+    }
+}
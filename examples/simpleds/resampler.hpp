@@ -0,0 +1,76 @@
+﻿#ifndef RESAMPLER_HPP
+#define RESAMPLER_HPP
+
+#include <vector>
+#include "imageview.hpp"
+
+// Separable image resampler producing one output row at a time.
+// Upscaling uses Lanczos-3, downscaling averages the covered area.
+// Only the source rows needed by the current output row are filtered horizontally
+// and kept in a small cache, the whole rescaled image is never materialized.
+// 可分离的图像重采样器，每次输出一行
+// 放大使用 Lanczos-3，缩小按覆盖面积取平均
+// 只对当前输出行需要的源行做水平滤波并缓存，不会生成完整的缩放图像
+class Resampler {
+
+public:
+    // Prepares filter weights, clears the row cache.
+    // 准备滤波权重，清空行缓存
+    void setup(Twpp::UInt32 srcWidth, Twpp::UInt32 srcHeight,
+               Twpp::UInt32 dstWidth, Twpp::UInt32 dstHeight, Twpp::UInt32 channels);
+
+    // Whether the output has the same size as the source.
+    // 输出尺寸是否与源相同
+    bool isIdentity() const noexcept;
+
+    Twpp::UInt32 width() const noexcept;
+    Twpp::UInt32 height() const noexcept;
+
+    // Number of source rows from the top that output rows up to `y` are computed from.
+    // 计算到输出第 y 行为止所需的源行数（自顶部起）
+    Twpp::UInt32 sourceRows(Twpp::UInt32 y) const noexcept;
+
+    // Writes output row `y` (width * channels bytes) into `out`.
+    // Requesting rows in increasing order reuses the cached source rows.
+    // 将输出第 y 行（width * channels 字节）写入 out
+    // 按递增顺序请求时可复用缓存的源行
+    void row(const ImageView& src, Twpp::UInt32 y, unsigned char* out);
+
+private:
+    struct Taps {
+        Twpp::UInt32 first;  // first source index / 第一个源索引
+        Twpp::UInt32 count;  // number of weights / 权重数量
+        Twpp::UInt32 offset; // into the weight table / 在权重表中的位置
+    };
+
+    static void weights(Twpp::UInt32 srcSize, Twpp::UInt32 dstSize,
+                        std::vector<Taps>& taps, std::vector<float>& weights);
+
+    // horizontal pass, the channel count is a template argument so the inner loop unrolls
+    // 水平滤波，通道数作为模板参数以展开内层循环
+    template<Twpp::UInt32 ch>
+    void filterRow(const unsigned char* in, float* out) const;
+
+    const float* filtered(const ImageView& src, Twpp::UInt32 srcRow);
+
+    Twpp::UInt32 m_srcWidth = 0;
+    Twpp::UInt32 m_srcHeight = 0;
+    Twpp::UInt32 m_dstWidth = 0;
+    Twpp::UInt32 m_dstHeight = 0;
+    Twpp::UInt32 m_channels = 0;
+
+    std::vector<Taps> m_xTaps;
+    std::vector<float> m_xWeights;
+    std::vector<Taps> m_yTaps;
+    std::vector<float> m_yWeights;
+
+    // horizontally filtered source rows, slot = source row % m_cacheRows
+    // 水平滤波后的源行，槽位 = 源行 % m_cacheRows
+    Twpp::UInt32 m_cacheRows = 0;
+    std::vector<float> m_cache;
+    std::vector<Twpp::UInt32> m_cacheTags;
+    std::vector<const float*> m_rows;
+    std::vector<float> m_acc;
+};
+
+#endif // RESAMPLER_HPP
@@ -1,4 +1,7 @@
 ﻿#include <memory>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
 #include <QQmlContext>
 #include <QByteArray>
 #include <QApplication>
@@ -9,7 +12,9 @@
 #include "simpleds.hpp"
 #include "twglue.hpp"
 #include "camerasever.h"
+#include "../common/caphelpers.hpp"
 using namespace Twpp;
+using namespace CapHelpers;
 using namespace std::placeholders;
 
 TWPP_ENTRY(SimpleDs)
@@ -32,6 +37,28 @@ static constexpr const Identity srcIdent(
 // 让我们只模拟两个轴的统一分辨率
 static constexpr UInt32 RESOLUTION = 85;
 
+// resolutions the image can be resampled to
+// 图像可以重采样到的分辨率范围
+static constexpr UInt32 RESOLUTION_MIN = 50;
+static constexpr UInt32 RESOLUTION_MAX = 600;
+
+// rows of a memory transfer strip with undefined image size, one band of the page transform
+// 图像尺寸未定义时内存传输条带的行数，等于页面变换的一个条带
+static constexpr UInt32 STREAM_ROWS = 64;
+
+// width and height of a memory transfer tile, a multiple of 32 keeps the rows of all pixel types aligned
+// 内存传输块的宽度和高度，32 的倍数可使所有像素类型的行保持对齐
+static constexpr UInt32 TILE_SIZE = 256;
+
+// frames that can be cut from a single capture
+// 单次采集可以切分出的帧数
+static constexpr UInt16 MAX_FRAMES = 16;
+
+// custom capability selecting the output color space of RGB images, there is no standard one
+// 0 = camera RGB, 1 = sRGB, 2 = Adobe RGB
+// 自定义能力，选择 RGB 图像的输出色彩空间，没有对应的标准能力
+static constexpr CapType CAP_COLOR_SPACE = static_cast<CapType>(static_cast<UInt16>(CapType::CustomBase) + 1);
+
 static int argc = 0;
 static char** argv = nullptr;
 static QByteArray bmpData;
@@ -52,106 +79,11 @@ Result SimpleDs::call(const Identity& origin, DataGroup dg, Dat dat, Msg msg, vo
         return Base::call(origin, dg, dat, msg, data);
     }
     catch (const CapabilityException&) {
+        // 能力处理函数使用 tryCurrentItem，这里仅作为兜底
         return badValue();
     }
 }
 
-// 一些辅助函数来处理能力的东西
-template<typename T>
-static Result oneValGet(Msg msg, Capability& data, const T& value) {
-    switch (msg) {
-    case Msg::Get:
-    case Msg::GetCurrent:
-    case Msg::GetDefault:
-        data = Capability::createOneValue(data.type(), value);
-        return {};
-
-    default:
-        return { ReturnCode::Failure, ConditionCode::CapBadOperation };
-    }
-}
-
-template<typename T>
-static Result enmGet(Msg msg, Capability& data, const T& value) {
-    switch (msg) {
-    case Msg::Get:
-        data = Capability::createEnumeration(data.type(), { value });
-        return {};
-    case Msg::GetCurrent:
-    case Msg::GetDefault:
-        data = Capability::createOneValue(data.type(), value);
-        return {};
-
-    default:
-        return { ReturnCode::Failure, ConditionCode::CapBadOperation };
-    }
-}
-
-template<typename T>
-static Result oneValGetSet(Msg msg, Capability& data, T& value, const T& def) {
-    switch (msg) {
-    case Msg::Reset:
-        value = def;
-        // fallthrough
-    case Msg::Get:
-    case Msg::GetCurrent:
-        data = Capability::createOneValue(data.type(), value);
-        return {};
-
-    case Msg::GetDefault:
-        data = Capability::createOneValue(data.type(), def);
-        return {};
-
-    case Msg::Set:
-        value = data.currentItem<T>();
-        return {};
-
-    default:
-        return { ReturnCode::Failure, ConditionCode::CapBadOperation };
-    }
-}
-
-template<typename T>
-static Result oneValGetSetConst(Msg msg, Capability& data, const T& def) {
-    switch (msg) {
-    case Msg::Get:
-    case Msg::GetCurrent:
-    case Msg::GetDefault:
-    case Msg::Reset:
-        data = Capability::createOneValue(data.type(), def);
-        return {};
-
-    case Msg::Set:
-        return data.currentItem<T>() == def ?
-            Result() : Result(ReturnCode::Failure, ConditionCode::BadValue);
-
-    default:
-        return { ReturnCode::Failure, ConditionCode::CapBadOperation };
-    }
-}
-
-template<typename T>
-static Result enmGetSetConst(Msg msg, Capability& data, const T& def) {
-    switch (msg) {
-    case Msg::Get:
-        data = Capability::createEnumeration(data.type(), { def });
-        return {};
-
-    case Msg::GetCurrent:
-    case Msg::GetDefault:
-    case Msg::Reset:
-        data = Capability::createOneValue(data.type(), def);
-        return {};
-
-    case Msg::Set:
-        return data.currentItem<T>() == def ?
-            Result() : Result(ReturnCode::Failure, ConditionCode::BadValue);
-
-    default:
-        return { ReturnCode::Failure, ConditionCode::CapBadOperation };
-    }
-}
-
 Result SimpleDs::capCommon(const Identity&, Msg msg, Capability& data) {
     auto it = m_caps.find(data.type());
     if (it != m_caps.end()) {
@@ -197,6 +129,13 @@ Result SimpleDs::capabilityResetAll(const Identity& origin) {
 
 Result SimpleDs::capabilitySet(const Identity& origin, Capability& data) {
     qDebug()<<"capabilitySet:  "<<UINT16(data.type());
+    // standard capabilities are checked against their description first, custom ones are left to the handlers
+    // 标准能力先按其描述检查，自定义能力交给各自的处理函数
+    auto cc = capSetCondition(data);
+    if (cc != ConditionCode::Success) {
+        return { ReturnCode::Failure, cc };
+    }
+
     return capCommon(origin, Msg::Set, data);
 }
 
@@ -228,13 +167,8 @@ Result SimpleDs::identityOpenDs(const Identity&) {
         case Msg::Get:
         case Msg::GetCurrent:
         case Msg::GetDefault: {
-            data = Capability::createArray<CapType::SupportedCaps>(m_caps.size());
-            auto arr = data.array<CapType::SupportedCaps>();
-            UInt32 i = 0;
-            for (const auto& kv : m_caps) {
-                arr[i] = kv.first;
-                i++;
-            }
+            data = Capability::createArray<CapType::SupportedCaps>(m_supportedCaps.data(),
+                                                                   m_supportedCaps.data() + m_supportedCaps.size());
 
             return success();
         }
@@ -253,8 +187,8 @@ Result SimpleDs::identityOpenDs(const Identity&) {
     m_query[CapType::XferCount] = msgSupportGetAllSetReset;
     m_caps[CapType::XferCount] = [this](Msg msg, Capability& data) -> Result {
         if (msg == Msg::Set) {
-            auto item = data.currentItem<Int16>();
-            if (item > 1 || item < -1) {
+            auto item = data.tryCurrentItem<Int16>();
+            if (!item || item.value() > 1 || item.value() < -1) {
                 return badValue();
             }
         }
@@ -272,8 +206,56 @@ Result SimpleDs::identityOpenDs(const Identity&) {
     m_caps[CapType::ICompression] = std::bind(enmGetSetConst<Compression>, _1, _2, Compression::None);
 
 
+    m_grayResponse = identityToneCurve();
+    for (auto& curve : m_rgbResponse) {
+        curve = identityToneCurve();
+    }
+
+    // nothing is captured before the first scan, the page has zero size until then
+    // 首次扫描之前没有采集的图像，在此之前页面大小为零
+    m_pageGeometry = bmpData.isEmpty() ? PageGeometry() : analyzePage(bmpView(), false, false);
+    m_pageBuffer.clear();
+    publishPageRows(m_pageGeometry.height);
+    m_capFrames.clear();
+    m_capMaxFrames = MAX_FRAMES;
+    prepareFrames();
+    m_capXRes = Fix32(RESOLUTION);
+    m_capYRes = Fix32(RESOLUTION);
+
+    // bit depth follows the pixel type / 位深由像素类型决定
     m_query[CapType::IBitDepth] = msgSupportGetAllSetReset;
-    m_caps[CapType::IBitDepth] = std::bind(enmGetSetConst<UInt16>, _1, _2, UInt16(header()->biBitCount));
+    m_caps[CapType::IBitDepth] = [this](Msg msg, Capability& data) {
+        return enmGetSetConst<UInt16>(msg, data, PixelConverter::bitsPerPixel(outFormat(false)));
+    };
+
+    // reduction of RGB to black & white / RGB 降为黑白的方式
+    m_query[CapType::IBitDepthReduction] = msgSupportGetAllSetReset;
+    m_caps[CapType::IBitDepthReduction] = std::bind(enmGetSet<BitDepthReduction>, _1, _2, std::ref(m_capBitDepthReduction),
+        std::vector<BitDepthReduction>{ BitDepthReduction::Threshold, BitDepthReduction::HalfTone, BitDepthReduction::Diffusion }, 0);
+
+    m_query[CapType::IThreshold] = msgSupportGetAllSetReset;
+    m_caps[CapType::IThreshold] = std::bind(rngGetSet, _1, _2, std::ref(m_capThreshold), Fix32(0), Fix32(255), Fix32(1), Fix32(128));
+
+    // brightness, contrast and gamma are compiled into a single tone curve together with DAT_RGBRESPONSE or DAT_GRAYRESPONSE
+    // 亮度、对比度和伽马与 DAT_RGBRESPONSE 或 DAT_GRAYRESPONSE 一起编译为一条色调曲线
+    m_query[CapType::IBrightness] = msgSupportGetAllSetReset;
+    m_caps[CapType::IBrightness] = std::bind(rngGetSet, _1, _2, std::ref(m_capBrightness), Fix32(-1000), Fix32(1000), Fix32(1), Fix32(0));
+
+    m_query[CapType::IContrast] = msgSupportGetAllSetReset;
+    m_caps[CapType::IContrast] = std::bind(rngGetSet, _1, _2, std::ref(m_capContrast), Fix32(-1000), Fix32(1000), Fix32(1), Fix32(0));
+
+    m_query[CapType::IGamma] = msgSupportGetAllSetReset;
+    m_caps[CapType::IGamma] = std::bind(rngGetSet, _1, _2, std::ref(m_capGamma), Fix32(0.1f), Fix32(5.0f), Fix32(0.1f), Fix32(1));
+
+    // camera RGB is converted to the selected color space through a 3D lookup table
+    // 摄像头 RGB 通过三维查找表转换到所选色彩空间
+    m_query[CAP_COLOR_SPACE] = msgSupportGetAllSetReset;
+    m_caps[CAP_COLOR_SPACE] = std::bind(enmGetSet<UInt16>, _1, _2, std::ref(m_capColorSpace),
+        std::vector<UInt16>{ 0, 1, 2 }, 0);
+
+    m_query[CapType::IHalfTones] = msgSupportGetAllSetReset;
+    m_caps[CapType::IHalfTones] = std::bind(enmGetSet<Str32>, _1, _2, std::ref(m_capHalftone),
+        std::vector<Str32>{ Str32("Bayer 4x4"), Str32("Bayer 8x8") }, 0);
 
     m_query[CapType::IBitOrder] = msgSupportGetAllSetReset;
     m_caps[CapType::IBitOrder] = std::bind(enmGetSetConst<BitOrder>, _1, _2, BitOrder::MsbFirst);
@@ -282,48 +264,194 @@ Result SimpleDs::identityOpenDs(const Identity&) {
     m_caps[CapType::IPlanarChunky] = std::bind(enmGetSetConst<PlanarChunky>, _1, _2, PlanarChunky::Chunky);
 
     m_query[CapType::IPhysicalWidth] = msgSupportGetAll;
-    m_caps[CapType::IPhysicalWidth] = std::bind(oneValGet<Fix32>, _1, _2, Fix32(static_cast<float>(header()->biWidth) / RESOLUTION));
+    m_caps[CapType::IPhysicalWidth] = std::bind(oneValGet<Fix32>, _1, _2, Fix32(static_cast<float>(bmpView().width) / RESOLUTION));
 
     m_query[CapType::IPhysicalHeight] = msgSupportGetAll;
-    m_caps[CapType::IPhysicalHeight] = std::bind(oneValGet<Fix32>, _1, _2, Fix32(static_cast<float>(header()->biHeight) / RESOLUTION));
+    m_caps[CapType::IPhysicalHeight] = std::bind(oneValGet<Fix32>, _1, _2, Fix32(static_cast<float>(bmpView().height) / RESOLUTION));
 
     m_query[CapType::IPixelFlavor] = msgSupportGetAllSetReset;
     m_caps[CapType::IPixelFlavor] = std::bind(enmGetSetConst<PixelFlavor>, _1, _2, PixelFlavor::Chocolate);
 
     m_query[CapType::IPixelType] = msgSupportGetAllSetReset;
-    m_caps[CapType::IPixelType] = std::bind(enmGetSetConst<PixelType>, _1, _2, PixelType::Rgb);
+    m_caps[CapType::IPixelType] = std::bind(enmGetSet<PixelType>, _1, _2, std::ref(m_capPixelType),
+        std::vector<PixelType>{ PixelType::BlackWhite, PixelType::Gray, PixelType::Rgb }, 2);
 
-    m_query[CapType::IUnits] = msgSupportGetAllSetReset;
-    m_caps[CapType::IUnits] = std::bind(enmGetSetConst<Unit>, _1, _2, Unit::Inches);
+    // Disabled, Auto, or discard pages with no more than N bytes of content
+    // 禁用、自动，或丢弃内容不超过 N 字节的页面
+    m_query[CapType::IAutoDiscardBlankPages] = msgSupportGetAllSetReset;
+    m_caps[CapType::IAutoDiscardBlankPages] = [this](Msg msg, Capability& data) -> Result {
+        if (msg == Msg::Set) {
+            auto item = data.tryCurrentItem<CapType::IAutoDiscardBlankPages>();
+            if (!item || static_cast<Int32>(item.value()) < static_cast<Int32>(DiscardBlankPages::Disabled)) {
+                return badValue();
+            }
+        }
 
-    m_query[CapType::IXferMech] = msgSupportGetAllSetReset;
-    m_caps[CapType::IXferMech] = [this](Msg msg, Capability& data) -> Result {
+        return oneValGetSet<DiscardBlankPages>(msg, data, m_capDiscardBlank, DiscardBlankPages::Disabled);
+    };
+
+    // the page is straightened and cropped to its borders once it has been scanned
+    // 页面扫描完成后进行纠偏并裁剪到其边框
+    m_query[CapType::IAutomaticDeskew] = msgSupportGetAllSetReset;
+    m_caps[CapType::IAutomaticDeskew] = std::bind(oneValGetSet<Bool>, _1, _2, std::ref(m_capDeskew), Bool(false));
+
+    m_query[CapType::IAutomaticBorderDetection] = msgSupportGetAllSetReset;
+    m_caps[CapType::IAutomaticBorderDetection] = std::bind(oneValGetSet<Bool>, _1, _2, std::ref(m_capBorderDetection), Bool(false));
+
+    m_query[CapType::IExtImageInfo] = msgSupportGetAllSetReset;
+    m_caps[CapType::IExtImageInfo] = std::bind(oneValGetSet<Bool>, _1, _2, std::ref(m_capExtImageInfo), Bool(false));
+
+    // Code 128 and Code 39 bar codes, patch codes for batch separation
+    // Code 128 和 Code 39 条码，用于批次分隔的分隔码
+    m_query[CapType::IBarCodeDetectionEnabled] = msgSupportGetAllSetReset;
+    m_caps[CapType::IBarCodeDetectionEnabled] = std::bind(oneValGetSet<Bool>, _1, _2, std::ref(m_capBarCodeDetection), Bool(false));
+
+    m_query[CapType::ISupportedBarCodeTypes] = msgSupportGetAll;
+    m_caps[CapType::ISupportedBarCodeTypes] = [](Msg msg, Capability& data) -> Result {
         switch (msg) {
         case Msg::Get:
-            data = Capability::createEnumeration<CapType::IXferMech>(
-                { XferMech::Native, XferMech::Memory }, m_capXferMech == XferMech::Native ? 0 : 1, 0);
+        case Msg::GetCurrent:
+        case Msg::GetDefault: {
+            const auto& types = supportedBarCodeTypes();
+            data = Capability::createArray<CapType::ISupportedBarCodeTypes>(types.data(), types.data() + types.size());
             return success();
+        }
 
+        default:
+            return capBadOperation();
+        }
+    };
+
+    m_query[CapType::IBarCodeMaxSearchPriorities] = msgSupportGetAll;
+    m_caps[CapType::IBarCodeMaxSearchPriorities] = std::bind(oneValGet<UInt32>, _1, _2,
+        static_cast<UInt32>(supportedBarCodeTypes().size()));
+
+    m_query[CapType::IBarCodeSearchPriorities] = msgSupportGetAllSetReset;
+    m_caps[CapType::IBarCodeSearchPriorities] = [this](Msg msg, Capability& data) -> Result {
+        switch (msg) {
         case Msg::Reset:
-            m_capXferMech = XferMech::Native;
+            m_capBarCodePriorities = supportedBarCodeTypes();
             // fallthrough
+        case Msg::Get:
         case Msg::GetCurrent:
-            data = Capability::createOneValue<CapType::IXferMech>(m_capXferMech);
+        case Msg::GetDefault: {
+            const auto& types = msg == Msg::GetDefault ? supportedBarCodeTypes() : m_capBarCodePriorities;
+            data = Capability::createArray<CapType::IBarCodeSearchPriorities>(types.data(), types.data() + types.size());
+            return success();
+        }
+
+        case Msg::Set: {
+            // supported types in priority order, each at most once
+            // 按优先级排列的受支持类型，每种最多出现一次
+            if (data.container() != ConType::Array) {
+                return badValue();
+            }
+
+            const auto& supported = supportedBarCodeTypes();
+            std::vector<BarCodeType> types;
+            for (auto type : data.array<CapType::IBarCodeSearchPriorities>()) {
+                if (std::find(supported.begin(), supported.end(), type) == supported.end() ||
+                        std::find(types.begin(), types.end(), type) != types.end()) {
+                    return badValue();
+                }
+
+                types.push_back(type);
+            }
+
+            m_capBarCodePriorities = std::move(types);
             return success();
+        }
+
+        default:
+            return capBadOperation();
+        }
+    };
+
+    m_query[CapType::IPatchCodeDetectionEnabled] = msgSupportGetAllSetReset;
+    m_caps[CapType::IPatchCodeDetectionEnabled] = std::bind(oneValGetSet<Bool>, _1, _2, std::ref(m_capPatchCodeDetection), Bool(false));
 
+    m_query[CapType::ISupportedPatchCodeTypes] = msgSupportGetAll;
+    m_caps[CapType::ISupportedPatchCodeTypes] = [](Msg msg, Capability& data) -> Result {
+        switch (msg) {
+        case Msg::Get:
+        case Msg::GetCurrent:
         case Msg::GetDefault:
-            data = Capability::createOneValue<CapType::IXferMech>(XferMech::Native);
+            data = Capability::createArray<CapType::ISupportedPatchCodeTypes>(
+                { PatchCode::P1, PatchCode::P2, PatchCode::P3, PatchCode::P4, PatchCode::P6, PatchCode::PT });
             return success();
 
+        default:
+            return capBadOperation();
+        }
+    };
+
+    m_query[CapType::ISupportedExtImageInfo] = msgSupportGetAll;
+    m_caps[CapType::ISupportedExtImageInfo] = [](Msg msg, Capability& data) -> Result {
+        switch (msg) {
+        case Msg::Get:
+        case Msg::GetCurrent:
+        case Msg::GetDefault:
+            data = Capability::createArray<CapType::ISupportedExtImageInfo>(
+                { InfoId::DeskewStatus, InfoId::SkewOriginalAngle, InfoId::BarCodeCount, InfoId::BarCodeConfidence,
+                  InfoId::BarCodeRotation, InfoId::BarCodeTextLength, InfoId::BarCodeText, InfoId::BarCodeX,
+                  InfoId::BarCodeY, InfoId::BarCodeType, InfoId::PatchCode, InfoId::IccProfile });
+            return success();
+
+        default:
+            return capBadOperation();
+        }
+    };
+
+    // each frame of a capture is transferred separately, see prepareFrames
+    // 每次采集的各帧分别传输，参见 prepareFrames
+    m_query[CapType::IFrames] = msgSupportGetAllSetReset;
+    m_caps[CapType::IFrames] = [this](Msg msg, Capability& data) -> Result {
+        auto toFrame = [](const FrameRect& rect) {
+            return Frame(static_cast<float>(rect.left) / RESOLUTION, static_cast<float>(rect.top) / RESOLUTION,
+                         static_cast<float>(rect.left + rect.width) / RESOLUTION,
+                         static_cast<float>(rect.top + rect.height) / RESOLUTION);
+        };
+
+        switch (msg) {
+        case Msg::Get: {
+            data = Capability::createEnumeration<CapType::IFrames>(static_cast<UInt32>(m_frameRects.size()), m_frameIndex, 0);
+            auto enm = data.enumeration<CapType::IFrames>();
+            for (std::size_t i = 0; i < m_frameRects.size(); i++) {
+                enm[i] = toFrame(m_frameRects[i]);
+            }
+
+            return success();
+        }
+
+        case Msg::Reset:
+            m_capFrames.clear();
+            prepareFrames();
+            // fallthrough
+        case Msg::GetCurrent:
+            data = Capability::createOneValue<CapType::IFrames>(toFrame(m_frameRects[m_frameIndex]));
+            return success();
+
+        case Msg::GetDefault: {
+            auto bmp = bmpView();
+            data = Capability::createOneValue<CapType::IFrames>(toFrame({ 0, 0, bmp.width, bmp.height }));
+            return success();
+        }
+
         case Msg::Set: {
-            auto mech = data.currentItem<CapType::IXferMech>();
-            if (mech == XferMech::Native || mech == XferMech::Memory) {
-                m_capXferMech = mech;
-                return success();
+            std::vector<Frame> frames;
+            if (data.container() == ConType::OneValue) {
+                frames.push_back(data.oneValue<CapType::IFrames>().item());
+            }
+            else if (data.container() == ConType::Enumeration) {
+                for (const auto& frame : data.enumeration<CapType::IFrames>()) {
+                    frames.push_back(frame);
+                }
             }
             else {
                 return badValue();
             }
+
+            return setFrames(frames);
         }
 
         default:
@@ -331,41 +459,109 @@ Result SimpleDs::identityOpenDs(const Identity&) {
         }
     };
 
-    m_query[CapType::IXResolution] = msgSupportGetAllSetReset;
-    m_caps[CapType::IXResolution] = [](Msg msg, Capability& data) {
+    m_query[CapType::IMaxFrames] = msgSupportGetAllSetReset;
+    m_caps[CapType::IMaxFrames] = [this](Msg msg, Capability& data) -> Result {
+        switch (msg) {
+        case Msg::Set: {
+            auto item = data.tryCurrentItem<UInt16>();
+            if (!item || item.value() == 0 || item.value() > MAX_FRAMES || item.value() < m_capFrames.size()) {
+                return badValue();
+            }
+
+            m_capMaxFrames = item.value();
+            return success();
+        }
+
+        case Msg::Reset:
+            if (m_capFrames.size() > 1) {
+                m_capFrames.clear();
+                prepareFrames();
+            }
+
+            // fallthrough
+        default:
+            return oneValGetSet<UInt16>(msg, data, m_capMaxFrames, MAX_FRAMES);
+        }
+    };
+
+    m_query[CapType::IUnits] = msgSupportGetAllSetReset;
+    m_caps[CapType::IUnits] = std::bind(enmGetSetConst<Unit>, _1, _2, Unit::Inches);
+
+    m_query[CapType::IXferMech] = msgSupportGetAllSetReset;
+    m_caps[CapType::IXferMech] = [this](Msg msg, Capability& data) -> Result {
         switch (msg) {
         case Msg::Get:
-            data = Capability::createEnumeration(data.type(), { Fix32(RESOLUTION) });
+            data = Capability::createEnumeration<CapType::IXferMech>(
+                { XferMech::Native, XferMech::Memory }, m_capXferMech == XferMech::Native ? 0 : 1, 0);
             return success();
+
+        case Msg::Reset:
+            m_capXferMech = XferMech::Native;
+            // fallthrough
         case Msg::GetCurrent:
+            data = Capability::createOneValue<CapType::IXferMech>(m_capXferMech);
+            return success();
+
         case Msg::GetDefault:
-        case Msg::Reset:
-            data = Capability::createOneValue(data.type(), Fix32(RESOLUTION));
+            data = Capability::createOneValue<CapType::IXferMech>(XferMech::Native);
             return success();
 
-        case Msg::Set:
-            return data.currentItem<Fix32>() == RESOLUTION ?
-                success() : badValue();
+        case Msg::Set: {
+            auto mech = data.tryCurrentItem<CapType::IXferMech>();
+            if (mech && (mech.value() == XferMech::Native || mech.value() == XferMech::Memory)) {
+                m_capXferMech = mech.value();
+                return success();
+            }
+            else {
+                return badValue();
+            }
+        }
 
         default:
             return capBadOperation();
         }
     };
 
+    // memory transfers may start before the page is complete, the height is known once it ends
+    // 内存传输可以在页面完成前开始，高度在传输结束时才确定
+    m_query[CapType::IUndefinedImageSize] = msgSupportGetAllSetReset;
+    m_caps[CapType::IUndefinedImageSize] = std::bind(oneValGetSet<Bool>, _1, _2, std::ref(m_capUndefinedImageSize), Bool(false));
+
+    // memory transfers in tiles of TILE_SIZE pixels instead of full width strips
+    // 内存传输按 TILE_SIZE 像素的块进行，而不是整行宽度的条带
+    m_query[CapType::ITiles] = msgSupportGetAllSetReset;
+    m_caps[CapType::ITiles] = std::bind(oneValGetSet<Bool>, _1, _2, std::ref(m_capTiles), Bool(false));
+
+    // any whole resolution within the range, the image is resampled during the transfer
+    // 范围内的任意整数分辨率，图像在传输时重采样
+    m_query[CapType::IXResolution] = msgSupportGetAllSetReset;
+    m_caps[CapType::IXResolution] = std::bind(rngGetSet, _1, _2, std::ref(m_capXRes),
+        Fix32(RESOLUTION_MIN), Fix32(RESOLUTION_MAX), Fix32(1), Fix32(RESOLUTION));
+
     m_query[CapType::IYResolution] = msgSupportGetAllSetReset;
-    m_caps[CapType::IYResolution] = m_caps[CapType::IXResolution];
+    m_caps[CapType::IYResolution] = std::bind(rngGetSet, _1, _2, std::ref(m_capYRes),
+        Fix32(RESOLUTION_MIN), Fix32(RESOLUTION_MAX), Fix32(1), Fix32(RESOLUTION));
 
     m_query[CapType::IXNativeResolution] = msgSupportGetAll;
     m_caps[CapType::IXNativeResolution] = std::bind(enmGet<Fix32>, _1, _2, Fix32(RESOLUTION));
 
     m_query[CapType::IYNativeResolution] = msgSupportGetAll;
     m_caps[CapType::IYNativeResolution] = m_caps[CapType::IXNativeResolution];
+
+    // the capabilities do not change while the source is open, SupportedCaps copies this list at once
+    // 数据源打开期间能力集合不变，SupportedCaps 一次性复制此列表
+    m_supportedCaps.clear();
+    for (const auto& kv : m_caps) {
+        m_supportedCaps.push_back(kv.first);
+    }
+
     return success();
 }
 
 Result SimpleDs::identityCloseDs(const Identity&) {
     // 如果使用 RAII，则无需显式释放任何资源
     // TWPP 将在此方法之后自行释放整个源
+    waitPageCodes();
     return success();
 }
 
@@ -375,21 +571,45 @@ Result SimpleDs::pendingXfersGet(const Identity&, PendingXfers& data) {
 }
 
 Result SimpleDs::pendingXfersEnd(const Identity&, PendingXfers& data) {
-    data.setCount(0);
+    // move on to the next frame of the capture
+    // 转到本次采集的下一帧
+    if (m_pendingXfers) {
+        m_pendingXfers--;
+    }
+
+    if (m_pendingXfers && m_frameIndex + 1 < m_frameRects.size()) {
+        m_frameIndex++;
+        m_memXferYOff = 0;
+        m_memXferXOff = 0;
+    }
+
+    data.setCount(m_pendingXfers);
     return success();
 }
 
 Result SimpleDs::pendingXfersReset(const Identity&, PendingXfers& data) {
+    m_pendingXfers = 0;
     data.setCount(0);
     return success();
 }
 
 Result SimpleDs::setupMemXferGet(const Identity&, SetupMemXfer& data) {
-    auto bpl = bytesPerLine();
-    auto max = bpl * static_cast<UInt32>(header()->biHeight);
+    if (m_capTiles) {
+        // exactly one tile, the largest one / 正好一个块，即最大的块
+        auto tile = tileBytesPerLine(std::min(TILE_SIZE, outWidth())) * std::min(TILE_SIZE, outHeight());
+        data.setMinSize(tile);
+        data.setPreferredSize(tile);
+        data.setMaxSize(tile);
+        return success();
+    }
+
+    auto bpl = outBytesPerLine();
+    auto max = bpl * outHeight();
 
+    // a single strip is ready soon, the whole page is not
+    // 单个条带很快就绪，整页则不然
     data.setMinSize(bpl);
-    data.setPreferredSize(max);
+    data.setPreferredSize(streaming() ? bpl * std::min(STREAM_ROWS, outHeight()) : max);
     data.setMaxSize(max);
     return success();
 }
@@ -402,12 +622,22 @@ Result SimpleDs::userInterfaceDisable(const Identity&, UserInterface&) {
 Result SimpleDs::userInterfaceEnable(const Identity&, UserInterface& ui) {
     m_pendingXfers = 1;
     m_memXferYOff = 0;
+    m_memXferXOff = 0;
     if (!ui.showUi()) {
         // this is an exception when we want to set state explicitly, notifyXferReady can be called only in enabled state
         // with hidden UI, the usual workflow DsState::Enabled -> notifyXferReady() -> DsState::XferReady is a single step
         // 当我们要显式设置状态时这是一个异常，notifyXferReady 只能在启用状态下调用使用隐藏的 UI，
         // 通常的工作流程 DsState::Enabled -> notifyXferReady() -> DsState::XferReady 是一个步骤
         setState(DsState::Enabled);
+        if (bmpData.isEmpty() || discardBlankPage(bmpView())) {
+            // nothing has been captured yet, or the only page is blank, there is nothing to transfer
+            // 尚未采集任何图像，或唯一的页面是空白页，没有可传输的内容
+            m_pendingXfers = 0;
+            return Twpp::success(notifyCloseCancel()) ? success() : bummer();
+        }
+
+        preparePage();
+
         auto notified = notifyXferReady();
         return Twpp::success(notified) ? success() : bummer();
     }
@@ -437,10 +667,28 @@ Result SimpleDs::userInterfaceEnable(const Identity&, UserInterface& ui) {
     QString oldPath = QCoreApplication::applicationDirPath();
     QDir::setCurrent(szDs);
     auto scanFunction1 = [this](QImage cap) {
+        // check the captured frame before encoding, blank pages never become pending
+        // 编码前检查采集的帧，空白页不会进入待传输状态
+        if (m_capDiscardBlank != DiscardBlankPages::Disabled) {
+            auto frame = cap.convertToFormat(QImage::Format_RGB32);
+            ImageView view;
+            view.data = frame.constBits();
+            view.stride = frame.bytesPerLine();
+            view.width = static_cast<UInt32>(frame.width());
+            view.height = static_cast<UInt32>(frame.height());
+            view.channels = 4;
+            if (discardBlankPage(view)) {
+                qDebug() << "blank page discarded";
+                return;
+            }
+        }
+
+        waitPageCodes(); // the previous page may still be searched for codes / 上一页可能仍在检测条码
         QBuffer buffer(&bmpData);
         buffer.open(QIODevice::WriteOnly);
         cap.save(&buffer, "BMP");
         bmpData = qUncompress(qCompress(bmpData, -1));
+        preparePage();
         notifyXferReady();
     };
     auto cancelFunction1 = [this](QString oldTwainPath) {
@@ -468,49 +716,289 @@ Result SimpleDs::userInterfaceEnableUiOnly(const Identity&, UserInterface&) {
     return { ReturnCode::Failure, ConditionCode::OperationError };
 }
 
+Result SimpleDs::extImageInfoGet(const Identity&, ExtImageInfo& data) {
+    if (!m_capExtImageInfo) {
+        return seqError();
+    }
+
+    waitPageCodes();
+    const auto& codes = m_pageCodes.barCodes;
+    const auto count = static_cast<UInt16>(codes.size());
+
+    for (auto& info : data) {
+        // per bar code items, nothing to return without any bar code
+        // 每个条码各一项，没有条码时没有可返回的内容
+        const auto id = info.id();
+        const bool perBarCode = id == InfoId::BarCodeConfidence || id == InfoId::BarCodeRotation ||
+                id == InfoId::BarCodeTextLength || id == InfoId::BarCodeText || id == InfoId::BarCodeX ||
+                id == InfoId::BarCodeY || id == InfoId::BarCodeType;
+        if (perBarCode && count == 0) {
+            info.setReturnCode(m_capBarCodeDetection ? ReturnCode::DataNotAvailable : ReturnCode::InfoNotSupported);
+            continue;
+        }
+
+        switch (info.id()) {
+        case InfoId::DeskewStatus: {
+            auto status = DeskewStatus::Disabled;
+            if (m_capDeskew) {
+                status = m_pageGeometry.angleFound ? DeskewStatus::Success : DeskewStatus::Fail;
+            }
+
+            info.allocSimple<InfoId::DeskewStatus>();
+            *info.items<Type::UInt32>()[0] = static_cast<UInt32>(status);
+            break;
+        }
+
+        case InfoId::SkewOriginalAngle:
+            if (!m_capDeskew || !m_pageGeometry.angleFound) {
+                info.setReturnCode(ReturnCode::DataNotAvailable);
+                break;
+            }
+
+            info.allocSimple<InfoId::SkewOriginalAngle>();
+            *info.items<InfoId::SkewOriginalAngle>()[0] = static_cast<UInt32>(std::fabs(m_pageGeometry.angle) + 0.5f);
+            break;
+
+        case InfoId::BarCodeCount:
+            if (!m_capBarCodeDetection) {
+                info.setReturnCode(ReturnCode::InfoNotSupported);
+                break;
+            }
+
+            info.allocSimple<InfoId::BarCodeCount>();
+            *info.items<InfoId::BarCodeCount>()[0] = count;
+            break;
+
+        case InfoId::BarCodeConfidence: {
+            info.allocSimple<InfoId::BarCodeConfidence>(count);
+            auto items = info.items<InfoId::BarCodeConfidence>();
+            for (UInt16 i = 0; i < count; i++) {
+                *items[i] = codes[i].confidence;
+            }
+
+            break;
+        }
+
+        case InfoId::BarCodeRotation: {
+            info.allocSimple<InfoId::BarCodeRotation>(count);
+            auto items = info.items<Type::UInt32>();
+            for (UInt16 i = 0; i < count; i++) {
+                *items[i] = static_cast<UInt32>(codes[i].rotation);
+            }
+
+            break;
+        }
+
+        case InfoId::BarCodeTextLength: {
+            info.allocSimple<InfoId::BarCodeTextLength>(count);
+            auto items = info.items<InfoId::BarCodeTextLength>();
+            for (UInt16 i = 0; i < count; i++) {
+                *items[i] = static_cast<UInt32>(codes[i].text.size());
+            }
+
+            break;
+        }
+
+        case InfoId::BarCodeText: {
+            // all texts in a single handle, split by BarCodeTextLength
+            // 所有文本放在一个句柄中，按 BarCodeTextLength 拆分
+            std::string texts;
+            for (const auto& code : codes) {
+                texts += code.text;
+            }
+
+            info.allocHandle(static_cast<UInt32>(texts.size()));
+            auto text = info.items<InfoId::BarCodeText>()[0];
+            std::copy(texts.begin(), texts.end(), text.data());
+            break;
+        }
+
+        case InfoId::BarCodeX:
+        case InfoId::BarCodeY: {
+            info.allocSimple(Type::UInt32, count);
+            auto items = info.items<Type::UInt32>();
+            for (UInt16 i = 0; i < count; i++) {
+                *items[i] = info.id() == InfoId::BarCodeX ? codes[i].x : codes[i].y;
+            }
+
+            break;
+        }
+
+        case InfoId::BarCodeType: {
+            info.allocSimple<InfoId::BarCodeType>(count);
+            auto items = info.items<Type::UInt32>();
+            for (UInt16 i = 0; i < count; i++) {
+                *items[i] = static_cast<UInt32>(codes[i].type);
+            }
+
+            break;
+        }
+
+        case InfoId::PatchCode:
+            if (!m_capPatchCodeDetection || !m_pageCodes.patchFound) {
+                info.setReturnCode(m_capPatchCodeDetection ? ReturnCode::DataNotAvailable : ReturnCode::InfoNotSupported);
+                break;
+            }
+
+            info.allocSimple<InfoId::PatchCode>();
+            *info.items<Type::UInt32>()[0] = static_cast<UInt32>(m_pageCodes.patch);
+            break;
+
+        case InfoId::IccProfile: {
+            if (m_capPixelType != PixelType::Rgb) {
+                info.setReturnCode(ReturnCode::DataNotAvailable);
+                break;
+            }
+
+            // description of the profile returned by DAT_ICCPROFILE
+            // DAT_ICCPROFILE 返回的配置文件的描述
+            auto name = outColorSpace().name;
+            info.allocSimple<InfoId::IccProfile>();
+            info.items<InfoId::IccProfile>()[0]->setData(name, static_cast<UInt32>(std::strlen(name)));
+            break;
+        }
+
+        default:
+            info.setReturnCode(ReturnCode::InfoNotSupported);
+            break;
+        }
+    }
+
+    return success();
+}
+
 Result SimpleDs::imageInfoGet(const Identity&, ImageInfo& data) {
     // 我们的图片不会改变
-    auto dib = header();
-    data.setBitsPerPixel(static_cast<Int16>(dib->biBitCount));
-    data.setHeight(dib->biHeight);
-    data.setPixelType(PixelType::Rgb);
+    auto bpp = PixelConverter::bitsPerPixel(outFormat(false));
+    data.setBitsPerPixel(static_cast<Int16>(bpp));
+    // -1 until the memory transfer of the undefined size image ends
+    // 在未定义尺寸图像的内存传输结束之前为 -1
+    data.setHeight(streaming() && m_memXferYOff < outHeight() ? -1 : static_cast<Int32>(outHeight()));
+    data.setPixelType(m_capPixelType);
     data.setPlanar(false);
-    data.setWidth(dib->biWidth);
-    data.setXResolution(RESOLUTION);
-    data.setYResolution(RESOLUTION);
+    data.setWidth(static_cast<Int32>(outWidth()));
+    data.setXResolution(m_capXRes);
+    data.setYResolution(m_capYRes);
+
+    if (m_capPixelType == PixelType::Rgb) {
+        data.setSamplesPerPixel(3);
+        data.bitsPerSample()[0] = 8;
+        data.bitsPerSample()[1] = 8;
+        data.bitsPerSample()[2] = 8;
+    }
+    else {
+        data.setSamplesPerPixel(1);
+        data.bitsPerSample()[0] = static_cast<Int16>(bpp);
+    }
+
+    return success();
+}
+
+// 2^8 elements for our 8-bit samples
+// 8 位采样共 2^8 个元素
+static const Element8* responseElements(const Detail::CurveResponse& data) noexcept {
+    return data.data();
+}
+
+Result SimpleDs::grayResponseSet(const Identity&, GrayResponse& data) {
+    if (m_capPixelType != PixelType::Gray) {
+        return seqError();
+    }
+
+    auto elements = responseElements(data);
+    for (int i = 0; i < 256; i++) {
+        m_grayResponse[i] = elements[i].channel1();
+    }
+
+    return success();
+}
+
+Result SimpleDs::grayResponseReset(const Identity&, GrayResponse&) {
+    m_grayResponse = identityToneCurve();
+    return success();
+}
+
+Result SimpleDs::rgbResponseSet(const Identity&, RgbResponse& data) {
+    if (m_capPixelType != PixelType::Rgb) {
+        return seqError();
+    }
+
+    // channels 1-3 are red, green and blue, our curves are stored in BGR order
+    // 通道 1-3 为红、绿、蓝，我们的曲线按 BGR 顺序存储
+    auto elements = responseElements(data);
+    for (int i = 0; i < 256; i++) {
+        m_rgbResponse[0][i] = elements[i].channel3();
+        m_rgbResponse[1][i] = elements[i].channel2();
+        m_rgbResponse[2][i] = elements[i].channel1();
+    }
+
+    return success();
+}
 
-    data.setSamplesPerPixel(3);
-    data.bitsPerSample()[0] = 8;
-    data.bitsPerSample()[1] = 8;
-    data.bitsPerSample()[2] = 8;
+Result SimpleDs::rgbResponseReset(const Identity&, RgbResponse&) {
+    for (auto& curve : m_rgbResponse) {
+        curve = identityToneCurve();
+    }
 
     return success();
 }
 
+Result SimpleDs::iccProfileGet(const Identity&, IccProfileMemory& data) {
+    if (m_capPixelType != PixelType::Rgb) {
+        return seqError();
+    }
+
+    // the application becomes the owner of the profile
+    // 应用程序成为配置文件的所有者
+    auto profile = makeIccProfile(outColorSpace());
+    auto size = static_cast<UInt32>(profile.size());
+    Detail::UniqueHandle handle(Detail::alloc(size));
+    {
+        Detail::MaybeLock<char> lock(handle.get());
+        std::copy(profile.begin(), profile.end(), lock.data());
+    }
+
+    data = IccProfileMemory(handle.release(), size, false);
+    return success();
+}
+
 Result SimpleDs::imageLayoutGet(const Identity&, ImageLayout& data) {
+    // 当前帧，裁剪到检测到的页面边框，纠偏后的坐标
+    const auto& rect = m_frameRects[m_frameIndex];
+    auto document = std::max<UInt32>(1, m_documentNumber);
+
+    data.setDocumentNumber(document);
+    data.setFrameNumber(m_frameIndex + 1);
+    data.setPageNumber(document);
+    data.setFrame(Frame(static_cast<float>(rect.left) / RESOLUTION, static_cast<float>(rect.top) / RESOLUTION,
+                        static_cast<float>(rect.left + rect.width) / RESOLUTION,
+                        static_cast<float>(rect.top + rect.height) / RESOLUTION));
+    return success();
+}
+
+Result SimpleDs::imageLayoutGetDefault(const Identity&, ImageLayout& data) {
     // 我们的图片不会改变
-    auto dib = header();
+    auto bmp = bmpView();
 
     data.setDocumentNumber(1);
     data.setFrameNumber(1);
     data.setPageNumber(1);
-    data.setFrame(Frame(0, 0, static_cast<float>(dib->biWidth) / RESOLUTION, static_cast<float>(dib->biHeight) / RESOLUTION));
+    data.setFrame(Frame(0, 0, static_cast<float>(bmp.width) / RESOLUTION, static_cast<float>(bmp.height) / RESOLUTION));
     return success();
 }
 
-Result SimpleDs::imageLayoutGetDefault(const Identity& origin, ImageLayout& data) {
-    return imageLayoutGet(origin, data);
-}
-
-Result SimpleDs::imageLayoutSet(const Identity& origin, ImageLayout& lay) {
-    // 我们不支持设置图像框架
-    ImageLayout def;
-    imageLayoutGetDefault(origin, def);
-
-    return lay.frame() == def.frame() ? success() : badValue();
+Result SimpleDs::imageLayoutSet(const Identity&, ImageLayout& lay) {
+    // a single frame, ICAP_FRAMES sets more of them
+    // 单个帧，ICAP_FRAMES 可设置多个
+    std::vector<Frame> frames = { lay.frame() };
+    auto rc = setFrames(frames);
+    lay.setFrame(frames[0]);
+    return rc;
 }
 
 Result SimpleDs::imageLayoutReset(const Identity& origin, ImageLayout& data) {
+    m_capFrames.clear();
+    prepareFrames();
     return imageLayoutGet(origin, data);
 }
 
@@ -523,22 +1011,33 @@ Result SimpleDs::imageMemXferGet(const Identity& origin, ImageMemXfer& data) {
     SetupMemXfer setup;
     setupMemXferGet(origin, setup);
 
-    // 只是一个简单的存储 BMP 图像
-    auto dib = header();
-    auto bpl = bytesPerLine();
+    // 只是一个简单的存储 BMP 图像，按协商的分辨率逐行输出
+    auto bpl = outBytesPerLine();
+    auto height = outHeight();
     auto memSize = data.memory().size();
     if (memSize > setup.maxSize() || memSize < setup.minSize()) {
         return badValue();
     }
 
+    if (m_capTiles) {
+        return tileMemXfer(data);
+    }
+
     auto maxRows = memSize / bpl;
-    auto rows = std::min<UInt32>(maxRows, static_cast<UInt32>(dib->biHeight) - m_memXferYOff);
+    auto rows = std::min<UInt32>(maxRows, height - m_memXferYOff);
     if (rows == 0) {
         return seqError(); // 此会话中已传输图像
     }
 
+    if (m_memXferYOff == 0) {
+        prepareOutput(false);
+    }
+
+    // the page rows this strip is resampled from / 本条带重采样所用的页面行
+    waitPageRows(m_frameRects[m_frameIndex].top - m_pageGeometry.top + m_resampler.sourceRows(m_memXferYOff + rows - 1));
+
     data.setBytesPerRow(bpl);
-    data.setColumns(static_cast<UInt32>(dib->biWidth));
+    data.setColumns(outWidth());
     data.setRows(rows);
     data.setBytesWritten(rows * bpl);
     data.setXOffset(0);
@@ -548,26 +1047,15 @@ Result SimpleDs::imageMemXferGet(const Identity& origin, ImageMemXfer& data) {
     auto lock = data.memory().data();
     char* out = lock.data();
 
-    // 自底向上 BMP -> 自顶向下内存传输
-    auto begin = bmpEnd() - (bpl * (m_memXferYOff + 1));
+    // 自底向上 BMP -> 自顶向下内存传输，BGR -> RGB/灰度/黑白
     for (UInt32 i = 0; i < rows; i++) {
-        // copy bytes
-        std::copy(begin, begin + bpl, out);
-
-        char* line = out;
+        outputRow(m_memXferYOff + i, out);
         out += bpl;
-        begin -= bpl;
-
-        // BGR BMP -> RGB 内存传输
-        for (; line + 3 < out; line += 3) {
-            std::swap(line[0], line[2]);
-        }
     }
 
     m_memXferYOff += rows;
 
-    if (m_memXferYOff >= static_cast<UInt32>(std::abs(dib->biHeight))) {
-        m_pendingXfers = 0;
+    if (m_memXferYOff >= height) {
         return { ReturnCode::XferDone, ConditionCode::Success };
     }
 
@@ -579,13 +1067,58 @@ Result SimpleDs::imageNativeXferGet(const Identity&, ImageNativeXfer& data) {
         return seqError();
     }
 
-    // it does not get easier than that if we already have BMP
-    // 如果我们已经有了 BMP，那就再简单不过了
-    data = ImageNativeXfer(bmpSize());
+    waitPageRows(pageView().height);
+    prepareOutput(true);
+    auto src = sourceView();
+    if (m_pageBuffer.empty() && src.width == bmpView().width && src.height == bmpView().height && m_resampler.isIdentity() && !m_converter.hasToneCurves() &&
+            m_colorTransform.isIdentity() && outFormat(true) == PixelConverter::Format::Bgr) {
+        // it does not get easier than that if we already have BMP
+        // 如果我们已经有了 BMP，那就再简单不过了
+        data = ImageNativeXfer(bmpSize());
 
-    std::copy(bmpBegin(), bmpEnd(), data.data<char>().data());
+        std::copy(bmpBegin(), bmpEnd(), data.data<char>().data());
+    }
+    else {
+        // new DIB at the negotiated resolution and pixel type, rows stay bottom-up
+        // gray and black & white DIBs need a palette
+        // 按协商的分辨率和像素类型生成新的 DIB，行仍然自底向上，灰度和黑白 DIB 需要调色板
+        auto bpp = PixelConverter::bitsPerPixel(outFormat(true));
+        auto colors = bpp <= 8 ? UInt32(1) << bpp : 0;
+        auto bpl = outBytesPerLine();
+        auto height = outHeight();
+        auto offset = sizeof(BITMAPINFOHEADER) + colors * sizeof(RGBQUAD);
+        data = ImageNativeXfer(static_cast<UInt32>(offset) + bpl * height);
+
+        auto lock = data.data<char>();
+        auto dib = reinterpret_cast<BITMAPINFOHEADER*>(lock.data());
+        *dib = *header();
+        dib->biSize = sizeof(BITMAPINFOHEADER);
+        dib->biWidth = static_cast<LONG>(outWidth());
+        dib->biHeight = static_cast<LONG>(height);
+        dib->biBitCount = bpp;
+        dib->biCompression = BI_RGB;
+        dib->biSizeImage = bpl * height;
+        dib->biXPelsPerMeter = static_cast<LONG>(static_cast<float>(m_capXRes) / 0.0254f + 0.5f);
+        dib->biYPelsPerMeter = static_cast<LONG>(static_cast<float>(m_capYRes) / 0.0254f + 0.5f);
+        dib->biClrUsed = colors;
+        dib->biClrImportant = 0;
+
+        auto palette = reinterpret_cast<RGBQUAD*>(lock.data() + sizeof(BITMAPINFOHEADER));
+        for (UInt32 i = 0; i < colors; i++) {
+            auto level = static_cast<unsigned char>(i * 255 / (colors - 1));
+            palette[i].rgbBlue = level;
+            palette[i].rgbGreen = level;
+            palette[i].rgbRed = level;
+            palette[i].rgbReserved = 0;
+        }
+
+        char* pixels = lock.data() + offset;
+        for (UInt32 y = 0; y < height; y++) {
+            char* line = pixels + bpl * (height - 1 - y);
+            outputRow(y, line);
+        }
+    }
 
-    m_pendingXfers = 0;
     return { ReturnCode::XferDone, ConditionCode::Success };
 }
 
@@ -611,6 +1144,356 @@ const char* SimpleDs::bmpEnd() const noexcept {
     return bmpData.cend();
 }
 
+ImageView SimpleDs::bmpView() const noexcept {
+    // zero-size view before the first capture, there is no header to read
+    // 首次采集之前返回零大小的视图，此时没有可读取的文件头
+    if (bmpData.isEmpty()) {
+        return ImageView();
+    }
+
+    // 自底向上 BMP，最上面一行位于数据末尾
+    auto dib = header();
+    auto bpl = bytesPerLine();
+
+    ImageView view;
+    view.data = reinterpret_cast<const unsigned char*>(bmpEnd() - bpl);
+    view.stride = -static_cast<std::ptrdiff_t>(bpl);
+    view.width = static_cast<UInt32>(dib->biWidth);
+    view.height = static_cast<UInt32>(dib->biHeight);
+    view.channels = static_cast<UInt32>(dib->biBitCount) / 8;
+    return view;
+}
+
+void SimpleDs::preparePage() {
+    // the corrected page replaces the BMP as the source of all transfers
+    // 校正后的页面代替 BMP 作为所有传输的来源
+    waitPageCodes();
+    m_pageCodes = PageCodes();
+
+    std::vector<BarCodeType> types;
+    if (m_capBarCodeDetection) {
+        types = m_capBarCodePriorities;
+    }
+
+    bool codes = m_capBarCodeDetection || m_capPatchCodeDetection;
+    bool patch = m_capPatchCodeDetection;
+
+    auto bmp = bmpView();
+    m_pageGeometry = analyzePage(bmp, m_capDeskew, m_capBorderDetection);
+    if (m_pageGeometry.isIdentity(bmp)) {
+        m_pageBuffer.clear();
+        publishPageRows(bmp.height);
+    }
+    else if (!streaming()) {
+        m_pageView = transformPage(bmp, m_pageGeometry, m_pageBuffer);
+        publishPageRows(m_pageView.height);
+    }
+    else {
+        // transfers read the finished bands while the rest is transformed, codes are searched afterwards
+        // 传输读取已完成的条带，同时变换其余部分，之后再检测条码
+        m_pageView = allocatePage(bmp, m_pageGeometry, m_pageBuffer);
+        publishPageRows(0);
+
+        auto geometry = m_pageGeometry;
+        auto view = m_pageView;
+        m_pageCodesTask = std::async(std::launch::async, [this, bmp, geometry, view, types, codes, patch]() {
+            transformPage(bmp, geometry, view, [this](UInt32 rows) {
+                publishPageRows(rows);
+            });
+
+            return codes ? detectCodes(view, types, patch) : PageCodes();
+        });
+    }
+
+    // every frame is a pending transfer of the same document
+    // 每一帧都是同一文档的一个待传输项
+    prepareFrames();
+    m_pendingXfers = static_cast<UInt16>(m_frameRects.size());
+    m_memXferYOff = 0;
+    m_memXferXOff = 0;
+    m_documentNumber++;
+
+    // the page stays unchanged until the next one is prepared, see waitPageCodes
+    // 页面在准备下一页之前保持不变，参见 waitPageCodes
+    if (codes && !m_pageCodesTask.valid()) {
+        m_pageCodesTask = std::async(std::launch::async, detectCodes, pageView(), std::move(types), patch);
+    }
+}
+
+bool SimpleDs::streaming() const noexcept {
+    return m_capUndefinedImageSize && m_capXferMech == XferMech::Memory;
+}
+
+void SimpleDs::publishPageRows(UInt32 rows) {
+    {
+        std::lock_guard<std::mutex> lock(m_pageRowsMutex);
+        m_pageRows = rows;
+    }
+
+    m_pageRowsCond.notify_all();
+}
+
+void SimpleDs::waitPageRows(UInt32 rows) {
+    std::unique_lock<std::mutex> lock(m_pageRowsMutex);
+    m_pageRowsCond.wait(lock, [this, rows]() {
+        return m_pageRows >= rows;
+    });
+}
+
+void SimpleDs::waitPageCodes() {
+    if (m_pageCodesTask.valid()) {
+        m_pageCodes = m_pageCodesTask.get();
+    }
+}
+
+ImageView SimpleDs::pageView() const noexcept {
+    return m_pageBuffer.empty() ? bmpView() : m_pageView;
+}
+
+void SimpleDs::prepareFrames() {
+    // frames are in deskewed capture pixels, the page view starts at the detected border
+    // 帧使用纠偏后的采集图像像素坐标，页面视图从检测到的边框开始
+    const auto& page = m_pageGeometry;
+    m_frameRects.clear();
+    for (const auto& frame : m_capFrames) {
+        auto left = std::max(frame.left, page.left);
+        auto top = std::max(frame.top, page.top);
+        auto right = std::min(frame.left + frame.width, page.left + page.width);
+        auto bottom = std::min(frame.top + frame.height, page.top + page.height);
+        if (right > left && bottom > top) {
+            m_frameRects.push_back({ left, top, right - left, bottom - top });
+        }
+    }
+
+    if (m_frameRects.empty()) {
+        m_frameRects.push_back({ page.left, page.top, page.width, page.height });
+    }
+
+    m_frameIndex = 0;
+}
+
+Result SimpleDs::setFrames(std::vector<Frame>& frames) {
+    if (frames.empty() || frames.size() > m_capMaxFrames) {
+        return badValue();
+    }
+
+    // frames are clipped to the capture and reported back by CheckStatus
+    // 帧被裁剪到采集图像范围内，并通过 CheckStatus 通知应用程序
+    auto bmp = bmpView();
+    auto toPixels = [](Fix32 inches, UInt32 max) {
+        auto pixels = static_cast<float>(inches) * RESOLUTION + 0.5f;
+        return pixels <= 0 ? 0 : std::min(max, static_cast<UInt32>(pixels));
+    };
+
+    std::vector<FrameRect> rects;
+    bool clipped = false;
+    for (auto& frame : frames) {
+        auto left = toPixels(frame.left(), bmp.width);
+        auto top = toPixels(frame.top(), bmp.height);
+        auto right = toPixels(frame.right(), bmp.width);
+        auto bottom = toPixels(frame.bottom(), bmp.height);
+        if (right <= left || bottom <= top) {
+            return badValue();
+        }
+
+        Frame actual(frame.left() < Fix32(0) ? Fix32(0) : frame.left(), frame.top() < Fix32(0) ? Fix32(0) : frame.top(),
+                     right < bmp.width ? frame.right() : Fix32(static_cast<float>(bmp.width) / RESOLUTION),
+                     bottom < bmp.height ? frame.bottom() : Fix32(static_cast<float>(bmp.height) / RESOLUTION));
+        clipped = clipped || !(actual == frame);
+        frame = actual;
+        rects.push_back({ left, top, right - left, bottom - top });
+    }
+
+    m_capFrames = std::move(rects);
+    prepareFrames();
+    return clipped ? Result(ReturnCode::CheckStatus, ConditionCode::Success) : success();
+}
+
+ImageView SimpleDs::sourceView() const noexcept {
+    // the current frame shares the pixels of the page
+    // 当前帧与页面共享像素
+    const auto& page = m_pageGeometry;
+    const auto& rect = m_frameRects[m_frameIndex];
+    return pageView().crop(rect.left - page.left, rect.top - page.top, rect.width, rect.height);
+}
+
+UInt32 SimpleDs::outWidth() const noexcept {
+    auto width = sourceView().width * static_cast<float>(m_capXRes) / RESOLUTION;
+    return std::max<UInt32>(1, static_cast<UInt32>(width + 0.5f));
+}
+
+UInt32 SimpleDs::outHeight() const noexcept {
+    auto height = sourceView().height * static_cast<float>(m_capYRes) / RESOLUTION;
+    return std::max<UInt32>(1, static_cast<UInt32>(height + 0.5f));
+}
+
+UInt32 SimpleDs::outBytesPerLine() const noexcept {
+    return (outWidth() * PixelConverter::bitsPerPixel(outFormat(false)) + 31) / 32 * 4;
+}
+
+PixelConverter::Format SimpleDs::outFormat(bool native) const noexcept {
+    switch (m_capPixelType) {
+    case PixelType::BlackWhite:
+        return PixelConverter::Format::BlackWhite;
+    case PixelType::Gray:
+        return PixelConverter::Format::Gray;
+    default:
+        // BMP 保持 BGR，内存传输使用 RGB
+        return native ? PixelConverter::Format::Bgr : PixelConverter::Format::Rgb;
+    }
+}
+
+void SimpleDs::prepareOutput(bool native) {
+    auto src = sourceView();
+    m_resampler.setup(src.width, src.height, outWidth(), outHeight(), src.channels);
+
+    auto halftone = m_capHalftone == Str32("Bayer 8x8") ?
+                PixelConverter::Halftone::Bayer8x8 : PixelConverter::Halftone::Bayer4x4;
+    m_converter.setup(outWidth(), outFormat(native), m_capBitDepthReduction,
+                      static_cast<UInt8>(static_cast<float>(m_capThreshold)), halftone);
+
+    auto brightness = static_cast<float>(m_capBrightness);
+    auto contrast = static_cast<float>(m_capContrast);
+    auto gamma = static_cast<float>(m_capGamma);
+    if (m_capPixelType == PixelType::Rgb) {
+        m_converter.setToneCurves(compileToneCurve(m_rgbResponse[0], brightness, contrast, gamma),
+                                  compileToneCurve(m_rgbResponse[1], brightness, contrast, gamma),
+                                  compileToneCurve(m_rgbResponse[2], brightness, contrast, gamma));
+    }
+    else {
+        auto curve = compileToneCurve(m_capPixelType == PixelType::Gray ? m_grayResponse : identityToneCurve(),
+                                      brightness, contrast, gamma);
+        m_converter.setToneCurves(curve, curve, curve);
+    }
+
+    // the lookup table is rebuilt only when the output color space changes
+    // 仅在输出色彩空间变化时重建查找表
+    auto& space = outColorSpace();
+    if (&space != m_colorTransformSpace) {
+        m_colorTransform.setup(cameraColorSpace(), space);
+        m_colorTransformSpace = &space;
+    }
+
+    m_rowBuffer.resize(static_cast<std::size_t>(outWidth()) * src.channels);
+}
+
+const ColorSpace& SimpleDs::outColorSpace() const noexcept {
+    if (m_capPixelType == PixelType::Rgb) {
+        switch (m_capColorSpace) {
+        case 1:
+            return srgbColorSpace();
+        case 2:
+            return adobeRgbColorSpace();
+        default:
+            break;
+        }
+    }
+
+    return cameraColorSpace();
+}
+
+bool SimpleDs::discardBlankPage(const ImageView& page) const {
+    if (m_capDiscardBlank == DiscardBlankPages::Disabled) {
+        return false;
+    }
+
+    auto stats = analyzeBlankPage(page);
+    if (m_capDiscardBlank == DiscardBlankPages::Auto) {
+        return stats.inkRatio < 0.002 && stats.edgeRatio < 0.002;
+    }
+
+    // content size estimated in the negotiated pixel type and resolution
+    // 按协商的像素类型和分辨率估计内容大小
+    auto scale = static_cast<float>(m_capXRes) * static_cast<float>(m_capYRes) / (RESOLUTION * RESOLUTION);
+    auto bits = stats.inkPixels * scale * PixelConverter::bitsPerPixel(outFormat(false));
+    return bits / 8 <= static_cast<Int32>(m_capDiscardBlank);
+}
+
+void SimpleDs::outputRow(UInt32 y, char* out) {
+    // 自顶向下第 y 行，重采样后转换为输出像素格式，填充字节清零
+    auto src = sourceView();
+    auto line = reinterpret_cast<unsigned char*>(out);
+
+    const unsigned char* bgr = src.row(y);
+    if (!m_resampler.isIdentity()) {
+        m_resampler.row(src, y, m_rowBuffer.data());
+        bgr = m_rowBuffer.data();
+    }
+
+    if (!m_colorTransform.isIdentity()) {
+        m_colorTransform.apply(bgr, m_rowBuffer.data(), outWidth(), src.channels);
+        bgr = m_rowBuffer.data();
+    }
+
+    m_converter.convert(bgr, y, line);
+    std::fill(line + m_converter.rowBytes(), line + outBytesPerLine(), 0);
+}
+
+UInt32 SimpleDs::tileBytesPerLine(UInt32 columns) const noexcept {
+    return (columns * PixelConverter::bitsPerPixel(outFormat(false)) + 31) / 32 * 4;
+}
+
+Result SimpleDs::tileMemXfer(ImageMemXfer& data) {
+    // tiles go left to right, then top to bottom, the tiles of a row share its band of output rows
+    // 块从左到右、再从上到下传输，同一行的块共用一条输出行带
+    auto width = outWidth();
+    auto height = outHeight();
+    if (m_memXferYOff >= height) {
+        return seqError(); // 此会话中已传输图像
+    }
+
+    auto rows = std::min(TILE_SIZE, height - m_memXferYOff);
+    auto tileBytes = tileBytesPerLine(TILE_SIZE) * rows; // distance of tiles in the buffer / 块在缓冲区中的间距
+    if (m_memXferXOff == 0) {
+        if (m_memXferYOff == 0) {
+            prepareOutput(false);
+        }
+
+        waitPageRows(m_frameRects[m_frameIndex].top - m_pageGeometry.top + m_resampler.sourceRows(m_memXferYOff + rows - 1));
+
+        // each output row is split among the tiles, which then read as a single block
+        // 每个输出行被拆分到各个块中，之后每个块作为一个整体读取
+        auto tiles = (width + TILE_SIZE - 1) / TILE_SIZE;
+        std::vector<char> line(outBytesPerLine());
+        m_tileBuffer.resize(static_cast<std::size_t>(tileBytes) * tiles);
+        for (UInt32 y = 0; y < rows; y++) {
+            outputRow(m_memXferYOff + y, line.data());
+            for (UInt32 t = 0; t < tiles; t++) {
+                auto tileBpl = tileBytesPerLine(std::min(TILE_SIZE, width - t * TILE_SIZE));
+                std::copy_n(line.data() + t * tileBytesPerLine(TILE_SIZE), tileBpl,
+                            m_tileBuffer.data() + t * tileBytes + y * tileBpl);
+            }
+        }
+    }
+
+    auto columns = std::min(TILE_SIZE, width - m_memXferXOff);
+    auto bpl = tileBytesPerLine(columns);
+    auto tile = m_tileBuffer.data() + (m_memXferXOff / TILE_SIZE) * tileBytes;
+
+    data.setBytesPerRow(bpl);
+    data.setColumns(columns);
+    data.setRows(rows);
+    data.setBytesWritten(bpl * rows);
+    data.setXOffset(m_memXferXOff);
+    data.setYOffset(m_memXferYOff);
+    data.setCompression(Compression::None);
+
+    auto lock = data.memory().data();
+    std::copy_n(tile, bpl * rows, lock.data());
+
+    m_memXferXOff += columns;
+    if (m_memXferXOff >= width) {
+        m_memXferXOff = 0;
+        m_memXferYOff += rows;
+    }
+
+    if (m_memXferYOff >= height) {
+        return { ReturnCode::XferDone, ConditionCode::Success };
+    }
+
+    return success();
+}
+
 #if TWPP_DETAIL_OS_WIN
 BOOL WINAPI DllMain(HINSTANCE, DWORD reason, LPVOID) {
     switch (reason) {
@@ -3,6 +3,15 @@
 
 #include <twpp.hpp>
 #include <unordered_map>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include "resampler.hpp"
+#include "pixelconverter.hpp"
+#include "blankpage.hpp"
+#include "deskew.hpp"
+#include "barcode.hpp"
+#include "colortransform.hpp"
 
 namespace std {
 
@@ -41,7 +50,13 @@ protected:
     virtual Twpp::Result userInterfaceDisable(const Twpp::Identity& origin, Twpp::UserInterface& data) override;
     virtual Twpp::Result userInterfaceEnable(const Twpp::Identity& origin, Twpp::UserInterface& data) override;
     virtual Twpp::Result userInterfaceEnableUiOnly(const Twpp::Identity& origin, Twpp::UserInterface& data) override;
+    virtual Twpp::Result extImageInfoGet(const Twpp::Identity& origin, Twpp::ExtImageInfo& data) override;
     virtual Twpp::Result imageInfoGet(const Twpp::Identity& origin, Twpp::ImageInfo& data) override;
+    virtual Twpp::Result grayResponseSet(const Twpp::Identity& origin, Twpp::GrayResponse& data) override;
+    virtual Twpp::Result grayResponseReset(const Twpp::Identity& origin, Twpp::GrayResponse& data) override;
+    virtual Twpp::Result rgbResponseSet(const Twpp::Identity& origin, Twpp::RgbResponse& data) override;
+    virtual Twpp::Result rgbResponseReset(const Twpp::Identity& origin, Twpp::RgbResponse& data) override;
+    virtual Twpp::Result iccProfileGet(const Twpp::Identity& origin, Twpp::IccProfileMemory& data) override;
     virtual Twpp::Result imageLayoutGet(const Twpp::Identity& origin, Twpp::ImageLayout& data) override;
     virtual Twpp::Result imageLayoutGetDefault(const Twpp::Identity& origin, Twpp::ImageLayout& data) override;
     virtual Twpp::Result imageLayoutSet(const Twpp::Identity& origin, Twpp::ImageLayout& data) override;
@@ -59,6 +74,49 @@ private:
     const char* bmpBegin() const noexcept;
     const char* bmpEnd() const noexcept;
 
+    //纠偏和边框裁剪，页面就绪时执行一次
+    ImageView bmpView() const noexcept;
+    void preparePage();
+
+    //多帧提取，每帧是页面的一个裁剪视图，作为单独的传输
+    struct FrameRect {
+        Twpp::UInt32 left;
+        Twpp::UInt32 top;
+        Twpp::UInt32 width;
+        Twpp::UInt32 height;
+    };
+
+    ImageView pageView() const noexcept;
+    void prepareFrames();
+    Twpp::Result setFrames(std::vector<Twpp::Frame>& frames);
+
+    //IUndefinedImageSize：页面在后台线程中逐条带变换，内存传输只等待当前条带所需的行
+    bool streaming() const noexcept;
+    void publishPageRows(Twpp::UInt32 rows);
+    void waitPageRows(Twpp::UInt32 rows);
+
+    //条码和分隔码检测在后台线程中与传输并行进行
+    void waitPageCodes();
+
+    //输出图像相关辅助功能，按协商的分辨率重采样
+    ImageView sourceView() const noexcept;
+    Twpp::UInt32 outWidth() const noexcept;
+    Twpp::UInt32 outHeight() const noexcept;
+    Twpp::UInt32 outBytesPerLine() const noexcept;
+    PixelConverter::Format outFormat(bool native) const noexcept;
+    void prepareOutput(bool native);
+    void outputRow(Twpp::UInt32 y, char* out);
+
+    //ITiles：按块传输，每行块先输出一次并按块重排，使每个块在内存中连续
+    Twpp::UInt32 tileBytesPerLine(Twpp::UInt32 columns) const noexcept;
+    Twpp::Result tileMemXfer(Twpp::ImageMemXfer& data);
+
+    //空白页检测，被丢弃的页面不会编码也不会传输
+    bool discardBlankPage(const ImageView& page) const;
+
+    //输出色彩空间，RGB 以外的像素类型保持摄像头色彩空间
+    const ColorSpace& outColorSpace() const noexcept;
+
     //消息对应函数
     Twpp::Result capCommon(const Twpp::Identity& origin, Twpp::Msg msg, Twpp::Capability& data);
 
@@ -66,12 +124,57 @@ private:
     std::unordered_map<Twpp::CapType, std::function<Twpp::Result(Twpp::Msg msg, Twpp::Capability& data)>> m_caps;
     //消息类型
     std::unordered_map<Twpp::CapType, Twpp::MsgSupport> m_query;
+    //所有能力，即 m_caps 的键，打开数据源时生成
+    std::vector<Twpp::CapType> m_supportedCaps;
 
     Twpp::UInt32 m_memXferYOff;
+    Twpp::UInt32 m_memXferXOff = 0;
     Twpp::UInt16 m_pendingXfers;
 
     Twpp::Int16 m_capXferCount = -1;
     Twpp::XferMech m_capXferMech = Twpp::XferMech::Native;
+    Twpp::Bool m_capUndefinedImageSize = false;
+    Twpp::Bool m_capTiles = false;
+    Twpp::Fix32 m_capXRes;
+    Twpp::Fix32 m_capYRes;
+    Twpp::PixelType m_capPixelType = Twpp::PixelType::Rgb;
+    Twpp::BitDepthReduction m_capBitDepthReduction = Twpp::BitDepthReduction::Threshold;
+    Twpp::Fix32 m_capThreshold = Twpp::Fix32(128);
+    Twpp::Str32 m_capHalftone = Twpp::Str32("Bayer 4x4");
+    Twpp::Fix32 m_capBrightness = Twpp::Fix32(0);
+    Twpp::Fix32 m_capContrast = Twpp::Fix32(0);
+    Twpp::Fix32 m_capGamma = Twpp::Fix32(1);
+    ToneCurve m_grayResponse;
+    ToneCurve m_rgbResponse[3]; // B, G, R
+    Twpp::UInt16 m_capColorSpace = 0;
+    Twpp::DiscardBlankPages m_capDiscardBlank = Twpp::DiscardBlankPages::Disabled;
+    Twpp::Bool m_capDeskew = false;
+    Twpp::Bool m_capBorderDetection = false;
+    Twpp::Bool m_capExtImageInfo = false;
+    Twpp::Bool m_capBarCodeDetection = false;
+    std::vector<Twpp::BarCodeType> m_capBarCodePriorities = supportedBarCodeTypes();
+    Twpp::Bool m_capPatchCodeDetection = false;
+    std::vector<FrameRect> m_capFrames; // capture pixels, empty for the whole page / 采集图像像素，空表示整页
+    Twpp::UInt16 m_capMaxFrames;
+
+    PageGeometry m_pageGeometry;
+    ImageView m_pageView;
+    std::vector<unsigned char> m_pageBuffer;
+    std::vector<FrameRect> m_frameRects; // frames clipped to the page / 裁剪到页面的帧
+    Twpp::UInt32 m_frameIndex = 0;
+    Twpp::UInt32 m_documentNumber = 0;
+    PageCodes m_pageCodes;
+    Twpp::UInt32 m_pageRows = 0; // rows of the page view ready for transfers / 页面视图中可供传输的行数
+    std::mutex m_pageRowsMutex;
+    std::condition_variable m_pageRowsCond;
+    std::future<PageCodes> m_pageCodesTask; // reads the page, must be destroyed first / 读取页面，必须最先销毁
+
+    Resampler m_resampler;
+    PixelConverter m_converter;
+    ColorTransform m_colorTransform;
+    const ColorSpace* m_colorTransformSpace = nullptr; // output space of the table / 查找表的输出色彩空间
+    std::vector<unsigned char> m_rowBuffer;
+    std::vector<char> m_tileBuffer; // current row of tiles, tile after tile / 当前一行块，逐块存放
 };
 
 #endif // SIMPLEDS_HPP
@@ -18,11 +18,31 @@ DEF_FILE = exports.def
 
 SOURCES += simpleds.cpp \
     camerasever.cpp \
-    imageprovider.cpp
+    imageprovider.cpp \
+    blankpage.cpp \
+    thumbnail.cpp \
+    deskew.cpp \
+    barcode.cpp \
+    pixelconverter.cpp \
+    tonecurve.cpp \
+    colortransform.cpp \
+    resampler.cpp \
+    frameconverter.cpp
 HEADERS += simpleds.hpp \
     twglue.hpp \
     camerasever.h \
-    imageprovider.h
+    imageprovider.h \
+    imageview.hpp \
+    blankpage.hpp \
+    thumbnail.hpp \
+    deskew.hpp \
+    barcode.hpp \
+    pixelconverter.hpp \
+    tonecurve.hpp \
+    colortransform.hpp \
+    resampler.hpp \
+    frameconverter.hpp \
+    ../common/caphelpers.hpp
 
 DISTFILES += \
     exports.def
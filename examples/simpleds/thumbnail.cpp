@@ -0,0 +1,44 @@
+﻿#include <algorithm>
+#include "thumbnail.hpp"
+using namespace Twpp;
+
+Thumbnail makeThumbnail(const ImageView& page, UInt32 maxSize) {
+    Thumbnail thumb;
+    if (page.channels != 3 && page.channels != 4) {
+        return thumb;
+    }
+
+    const auto factor = std::max<UInt32>(1, (std::max(page.width, page.height) + maxSize - 1) / maxSize);
+    const auto w = page.width / factor;
+    const auto h = page.height / factor;
+
+    thumb.width = w;
+    thumb.height = h;
+    thumb.factor = factor;
+    thumb.pixels.resize(static_cast<std::size_t>(w) * h);
+
+    std::vector<UInt32> sums(w);
+    const auto ch = page.channels;
+    const auto area = factor * factor;
+    for (UInt32 by = 0; by < h; by++) {
+        std::fill(sums.begin(), sums.end(), 0);
+        for (UInt32 r = 0; r < factor; r++) {
+            const unsigned char* px = page.row(by * factor + r);
+            for (UInt32 bx = 0; bx < w; bx++) {
+                UInt32 sum = 0;
+                for (UInt32 i = 0; i < factor; i++, px += ch) {
+                    sum += 29 * px[0] + 150 * px[1] + 77 * px[2];
+                }
+
+                sums[bx] += sum;
+            }
+        }
+
+        unsigned char* out = thumb.pixels.data() + static_cast<std::size_t>(by) * w;
+        for (UInt32 bx = 0; bx < w; bx++) {
+            out[bx] = static_cast<unsigned char>(sums[bx] / area >> 8);
+        }
+    }
+
+    return thumb;
+}
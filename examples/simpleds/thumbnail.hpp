@@ -0,0 +1,25 @@
+﻿#ifndef THUMBNAIL_HPP
+#define THUMBNAIL_HPP
+
+#include <vector>
+#include "imageview.hpp"
+
+// Downsampled gray copy of a page, used by the page analysis stages.
+// 页面的缩小灰度副本，供页面分析使用
+struct Thumbnail {
+    std::vector<unsigned char> pixels;
+    Twpp::UInt32 width = 0;
+    Twpp::UInt32 height = 0;
+    Twpp::UInt32 factor = 1; // page pixels per thumbnail pixel / 每个缩略图像素对应的页面像素
+
+    const unsigned char* row(Twpp::UInt32 y) const noexcept {
+        return pixels.data() + static_cast<std::size_t>(y) * width;
+    }
+};
+
+// Box-filters BGR or BGRA pixels (3 or 4 channels) into BT.601 gray,
+// at most `maxSize` pixels on the longer side. Partial blocks at the edges are dropped.
+// 将 BGR 或 BGRA 像素（3 或 4 通道）盒式滤波为 BT.601 灰度，长边最多 maxSize 像素，边缘不完整的块被丢弃
+Thumbnail makeThumbnail(const ImageView& page, Twpp::UInt32 maxSize);
+
+#endif // THUMBNAIL_HPP
@@ -0,0 +1,41 @@
+﻿#include <algorithm>
+#include <cmath>
+#include "tonecurve.hpp"
+
+ToneCurve identityToneCurve() noexcept {
+    ToneCurve curve;
+    for (int i = 0; i < 256; i++) {
+        curve[i] = static_cast<unsigned char>(i);
+    }
+
+    return curve;
+}
+
+bool isIdentity(const ToneCurve& curve) noexcept {
+    for (int i = 0; i < 256; i++) {
+        if (curve[i] != i) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+ToneCurve compileToneCurve(const ToneCurve& response, float brightness, float contrast, float gamma) {
+    // contrast scales around the middle gray, -1000 flattens the image, 1000 is a step
+    // 对比度以中灰为中心缩放，-1000 使图像变平，1000 为阶跃
+    const float c = std::min(std::max(contrast, -1000.0f), 999.0f);
+    const float slope = (1000.0f + c) / (1000.0f - c);
+    const float offset = brightness / 1000.0f;
+    const float exponent = 1.0f / std::max(gamma, 0.01f);
+
+    ToneCurve curve;
+    for (int i = 0; i < 256; i++) {
+        float v = std::pow(i / 255.0f, exponent);
+        v = (v - 0.5f) * slope + 0.5f + offset;
+        v = std::min(std::max(v, 0.0f), 1.0f);
+        curve[i] = response[static_cast<int>(v * 255.0f + 0.5f)];
+    }
+
+    return curve;
+}
@@ -0,0 +1,22 @@
+﻿#ifndef TONECURVE_HPP
+#define TONECURVE_HPP
+
+#include <array>
+#include <twpp.hpp>
+
+// Maps 8-bit sample values of a single channel.
+// 映射单个通道的 8 位采样值
+typedef std::array<unsigned char, 256> ToneCurve;
+
+ToneCurve identityToneCurve() noexcept;
+
+bool isIdentity(const ToneCurve& curve) noexcept;
+
+// Compiles brightness and contrast (-1000 to 1000, 0 = unchanged), gamma (1 = unchanged)
+// and the response curve set by the application into a single curve.
+// Brightness, contrast and gamma are applied first, the response last.
+// 将亮度和对比度（-1000 到 1000，0 = 不变）、伽马（1 = 不变）以及应用程序设置的响应曲线编译为一条曲线
+// 先应用亮度、对比度和伽马，最后应用响应曲线
+ToneCurve compileToneCurve(const ToneCurve& response, float brightness, float contrast, float gamma);
+
+#endif // TONECURVE_HPP
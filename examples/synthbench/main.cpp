@@ -0,0 +1,512 @@
+﻿#include <twpp.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+#include "../common/benchutil.hpp"
+#if defined(TWPP_DETAIL_OS_WIN)
+#   include <psapi.h>
+#   define popen _popen
+#   define pclose _pclose
+#else
+#   include <sys/resource.h>
+#endif
+using namespace Twpp;
+using namespace BenchUtil;
+
+// DS_Entry of the synthetic source, see synthentry.cpp
+// 合成数据源的 DS_Entry，见 synthentry.cpp
+extern "C" ReturnCode TWPP_DETAIL_CALLSTYLE DS_Entry(Identity* origin, DataGroup dg, Dat dat, Msg msg, void* data);
+
+static constexpr CapType CAP_PAGE_RATE = static_cast<CapType>(static_cast<UInt16>(CapType::CustomBase) + 1);
+
+static const Str32 SOURCE_NAME("Synthetic TWPP data source");
+
+static const char* MECHANISMS[] = { "native", "file", "memory" };
+static const char* PIXEL_TYPES[] = { "bw", "gray", "rgb" };
+
+// allocations of the whole process, both the application and the linked source
+// the DSM memory functions allocate TWAIN handles, e.g. native images and memory transfer blocks
+// 整个进程的分配次数，包括应用程序和链接进来的数据源
+// DSM 内存函数分配 TWAIN 句柄，例如原生图像和内存传输块
+static std::atomic<std::uint64_t> g_heapAllocs(0);
+static std::atomic<std::uint64_t> g_dsmAllocs(0);
+static Detail::MemAlloc g_dsmAlloc = nullptr;
+
+void* operator new(std::size_t size) {
+    g_heapAllocs++;
+    if (auto ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+static Handle::Raw TWPP_DETAIL_CALLSTYLE countingAlloc(UInt32 size) {
+    g_dsmAllocs++;
+    return g_dsmAlloc(size);
+}
+
+// wraps the memory functions obtained from the DSM, a linked source shares them with the application
+// 包装从 DSM 获得的内存函数，链接进来的数据源与应用程序共享这些函数
+static void countDsmAllocs() {
+    typedef Detail::GlobalMemFuncs<void> Funcs;
+    if (Funcs::alloc && Funcs::alloc != countingAlloc) {
+        g_dsmAlloc = Funcs::alloc;
+        Detail::setMemFuncs(countingAlloc, Funcs::free, Funcs::lock, Funcs::unlock);
+    }
+}
+
+// peak resident set size of the process in kB
+// 进程的峰值常驻内存，单位为 kB
+static std::uint64_t peakRssKb() {
+#if defined(TWPP_DETAIL_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    return GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) ? counters.PeakWorkingSetSize / 1024 : 0;
+#else
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#   if defined(TWPP_DETAIL_OS_MAC)
+    return static_cast<std::uint64_t>(usage.ru_maxrss) / 1024; // bytes on Mac OS
+#   else
+    return static_cast<std::uint64_t>(usage.ru_maxrss);
+#   endif
+#endif
+}
+
+struct Options {
+    XferMech mech = XferMech::Memory;
+    PixelType pixelType = PixelType::Rgb;
+    UInt16 bitDepth = 0; // default of the pixel type / 像素类型的默认位深
+    float dpi = 300.0f;
+    float width = 8.5f;
+    float height = 11.0f;
+    Int16 pages = 10;
+    int batches = 1;
+    float rate = 0.0f;
+    UInt32 strip = 0; // preferred size of the source / 数据源的首选大小
+    std::string file = "synthbench.bmp";
+    bool dsm = false;
+    bool json = false;
+    bool matrix = false;
+};
+
+struct Metrics {
+    UInt32 pages = 0;
+    UInt16 bitDepth = 0;
+    UInt32 stripSize = 0;
+    double bytes = 0.0;
+    double seconds = 0.0;
+    std::uint64_t heapAllocs = 0;
+    std::uint64_t dsmAllocs = 0;
+    Latency xfer;
+    Latency page;
+};
+
+static void usage() {
+    std::puts("usage: synthbench [options]\n"
+              "  --mech native|memory|file  transfer mechanism (memory)\n"
+              "  --pixel bw|gray|rgb        pixel type (rgb)\n"
+              "  --depth N                  bit depth, default of the pixel type\n"
+              "  --dpi N                    resolution (300)\n"
+              "  --size W H                 page size in inches (8.5 11)\n"
+              "  --pages N                  CAP_XFERCOUNT of a batch (10)\n"
+              "  --batches N                enable/disable cycles (1)\n"
+              "  --rate N                   pages per second the source generates, 0 = unlimited (0)\n"
+              "  --strip N                  memory transfer size in bytes, source preferred by default\n"
+              "  --file PATH                file transfer destination (synthbench.bmp)\n"
+              "  --dsm                      use the installed DSM instead of the in-process one\n"
+              "  --json                     print the results as JSON\n"
+              "  --matrix                   run every mechanism, memory transfer size, page size and pixel type,\n"
+              "                             each in a child process; --dpi, --pages, --batches and --dsm apply");
+}
+
+static bool parse(int argc, char** argv, Options& opt) {
+    Args args(argc, argv);
+    while (args.next()) {
+        auto& arg = args.arg();
+        const char* v = nullptr;
+        const char* v2 = nullptr;
+        if (arg == "--mech" && args.value(v)) {
+            std::string s = v;
+            if (s == "native") opt.mech = XferMech::Native;
+            else if (s == "memory") opt.mech = XferMech::Memory;
+            else if (s == "file") opt.mech = XferMech::File;
+            else return false;
+        }
+        else if (arg == "--pixel" && args.value(v)) {
+            std::string s = v;
+            if (s == "bw") opt.pixelType = PixelType::BlackWhite;
+            else if (s == "gray") opt.pixelType = PixelType::Gray;
+            else if (s == "rgb") opt.pixelType = PixelType::Rgb;
+            else return false;
+        }
+        else if (arg == "--depth" && args.value(v)) opt.bitDepth = static_cast<UInt16>(std::atoi(v));
+        else if (arg == "--dpi" && args.value(v)) opt.dpi = static_cast<float>(std::atof(v));
+        else if (arg == "--size" && args.value(v) && args.value(v2)) {
+            opt.width = static_cast<float>(std::atof(v));
+            opt.height = static_cast<float>(std::atof(v2));
+        }
+        else if (arg == "--pages" && args.value(v)) opt.pages = static_cast<Int16>(std::atoi(v));
+        else if (arg == "--batches" && args.value(v)) opt.batches = std::atoi(v);
+        else if (arg == "--rate" && args.value(v)) opt.rate = static_cast<float>(std::atof(v));
+        else if (arg == "--strip" && args.value(v)) opt.strip = static_cast<UInt32>(std::atol(v));
+        else if (arg == "--file" && args.value(v)) opt.file = v;
+        else if (arg == "--dsm") opt.dsm = true;
+        else if (arg == "--json") opt.json = true;
+        else if (arg == "--matrix") opt.matrix = true;
+        else return false;
+    }
+
+    return opt.pages > 0 && opt.batches > 0;
+}
+
+template<typename T>
+static bool setCap(Source& src, CapType type, const T& value, const char* name) {
+    auto cap = Capability::createOneValue(type, value);
+    auto rc = src.capability(Msg::Set, cap);
+    if (!success(rc) && rc != ReturnCode::CheckStatus) {
+        std::fprintf(stderr, "could not set %s\n", name);
+        return false;
+    }
+
+    return true;
+}
+
+static bool configure(Source& src, const Options& opt) {
+    if (!setCap(src, CapType::IXferMech, opt.mech, "ICAP_XFERMECH") ||
+            !setCap(src, CapType::IPixelType, opt.pixelType, "ICAP_PIXELTYPE") ||
+            (opt.bitDepth && !setCap(src, CapType::IBitDepth, opt.bitDepth, "ICAP_BITDEPTH")) ||
+            !setCap(src, CapType::IXResolution, Fix32(opt.dpi), "ICAP_XRESOLUTION") ||
+            !setCap(src, CapType::IYResolution, Fix32(opt.dpi), "ICAP_YRESOLUTION") ||
+            !setCap(src, CapType::XferCount, opt.pages, "CAP_XFERCOUNT") ||
+            !setCap(src, CAP_PAGE_RATE, Fix32(opt.rate), "page rate")) {
+        return false;
+    }
+
+    ImageLayout layout(Frame(0, 0, opt.width, opt.height));
+    auto rc = src.imageLayout(Msg::Set, layout);
+    if (!success(rc) && rc != ReturnCode::CheckStatus) {
+        std::fprintf(stderr, "could not set DAT_IMAGELAYOUT\n");
+        return false;
+    }
+
+    if (opt.mech == XferMech::File) {
+        Str255 path;
+        path.setData(opt.file.data(), static_cast<UInt32>(opt.file.size()));
+        SetupFileXfer setup(path, ImageFileFormat::Bmp);
+        if (!success(src.setupFileXfer(Msg::Set, setup))) {
+            std::fprintf(stderr, "could not set DAT_SETUPFILEXFER\n");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// transfers a single page, timing every transfer call
+// 传输单个页面，并为每次传输调用计时
+static bool transferPage(Source& src, const Options& opt, Metrics& m) {
+    ImageInfo info;
+    if (!success(src.imageInfo(info))) {
+        return false;
+    }
+
+    ReturnCode rc;
+    switch (opt.mech) {
+    case XferMech::Native: {
+        ImageNativeXfer xfer;
+        auto start = Clock::now();
+        rc = src.imageNativeXfer(xfer);
+        m.xfer.add(Clock::now() - start);
+        break;
+    }
+
+    case XferMech::File: {
+        auto start = Clock::now();
+        rc = src.imageFileXfer();
+        m.xfer.add(Clock::now() - start);
+        break;
+    }
+
+    default: {
+        SetupMemXfer setup;
+        if (!success(src.setupMemXfer(setup))) {
+            return false;
+        }
+
+        auto size = opt.strip ? std::min(std::max(opt.strip, setup.minSize()), setup.maxSize()) : setup.preferredSize();
+        ImageMemXfer xfer(Compression::None, 0, 0, 0, 0, 0, 0, Memory(size));
+        m.stripSize = size;
+        do {
+            auto start = Clock::now();
+            rc = src.imageMemXfer(xfer);
+            m.xfer.add(Clock::now() - start);
+        } while (rc == ReturnCode::Success);
+        break;
+    }
+    }
+
+    if (rc != ReturnCode::XferDone) {
+        Status status;
+        src.status(status);
+        std::fprintf(stderr, "transfer failed, rc %d, cc %d\n", static_cast<int>(rc), static_cast<int>(status.condition()));
+        return false;
+    }
+
+    // image payload, the same for all mechanisms / 图像有效数据量，所有传输方式相同
+    auto rowBytes = (static_cast<UInt32>(info.width()) * static_cast<UInt32>(info.bitsPerPixel()) + 7) / 8;
+    m.bytes += static_cast<double>(rowBytes) * info.height();
+    m.bitDepth = static_cast<UInt16>(info.bitsPerPixel());
+    m.pages++;
+    return true;
+}
+
+static bool runBatch(Source& src, const Options& opt, Metrics& m) {
+    auto rc = src.enable(UserInterface(false, false));
+    if (!success(rc) || !success(src.waitReady())) {
+        std::fprintf(stderr, "could not enable the source\n");
+        return false;
+    }
+
+    while (src.state() == DsState::XferReady) {
+        auto start = Clock::now();
+        if (!transferPage(src, opt, m)) {
+            PendingXfers reset;
+            src.pendingXfers(Msg::Reset, reset);
+            src.disable();
+            return false;
+        }
+
+        PendingXfers pending;
+        src.pendingXfers(Msg::EndXfer, pending);
+        m.page.add(Clock::now() - start);
+    }
+
+    src.disable();
+    return true;
+}
+
+static void printText(const Options& opt, Metrics& m) {
+    std::printf("mechanism   %s", MECHANISMS[static_cast<int>(opt.mech)]);
+    if (opt.mech == XferMech::Memory) {
+        std::printf(", %u B blocks", m.stripSize);
+    }
+
+    std::printf("\nimage       %s %u bit, %g x %g in at %g DPI\n", PIXEL_TYPES[static_cast<int>(opt.pixelType)],
+                m.bitDepth, opt.width, opt.height, opt.dpi);
+    std::printf("pages       %u in %.3f s\n", m.pages, m.seconds);
+    std::printf("throughput  %.2f pages/s, %.2f MB/s\n", m.pages / m.seconds, m.bytes / 1e6 / m.seconds);
+    std::printf("memory      %.1f MB peak RSS, %llu heap and %llu DSM allocations\n", peakRssKb() / 1024.0,
+                static_cast<unsigned long long>(m.heapAllocs), static_cast<unsigned long long>(m.dsmAllocs));
+    printLatencyTable("calls", { std::make_pair("xfer call", &m.xfer), std::make_pair("page", &m.page) });
+}
+
+static void printJson(const Options& opt, Metrics& m) {
+    std::printf("{\"mechanism\":\"%s\",\"stripBytes\":%u,\"pixelType\":\"%s\",\"bitDepth\":%u,"
+                "\"dpi\":%g,\"width\":%g,\"height\":%g,"
+                "\"pages\":%u,\"seconds\":%.6f,\"pagesPerSecond\":%.3f,\"megabytesPerSecond\":%.3f,"
+                "\"peakRssKb\":%llu,\"heapAllocs\":%llu,\"dsmAllocs\":%llu",
+                MECHANISMS[static_cast<int>(opt.mech)], m.stripSize, PIXEL_TYPES[static_cast<int>(opt.pixelType)], m.bitDepth,
+                opt.dpi, opt.width, opt.height, m.pages, m.seconds, m.pages / m.seconds, m.bytes / 1e6 / m.seconds,
+                static_cast<unsigned long long>(peakRssKb()), static_cast<unsigned long long>(m.heapAllocs),
+                static_cast<unsigned long long>(m.dsmAllocs));
+
+    printLatencyJson("calls", { std::make_pair("xferLatencyUs", &m.xfer), std::make_pair("pageLatencyUs", &m.page) });
+
+    std::puts("}");
+}
+
+// number printed by printJson, at the top level or inside the named object
+// 读取 printJson 输出的数值，位于顶层或指定名称的对象内
+static double jsonNumber(const std::string& json, const char* key, const char* object = nullptr) {
+    std::size_t from = 0;
+    if (object) {
+        from = json.find(std::string("\"") + object + "\":{");
+        if (from == std::string::npos) {
+            return 0.0;
+        }
+    }
+
+    auto pos = json.find(std::string("\"") + key + "\":", from);
+    return pos == std::string::npos ? 0.0 : std::atof(json.c_str() + pos + std::strlen(key) + 3);
+}
+
+// every combination runs in its own process, so that the peak RSS belongs to that combination only
+// 每种组合都在单独的进程中运行，使峰值常驻内存只属于该组合
+static int runMatrix(const char* self, const Options& opt) {
+    static const char* sizes[][2] = { { "4", "6" }, { "8.5", "11" }, { "11", "17" } };
+    static const char* memStrips[] = { "1", "65536", "1048576", "4294967295" }; // one row ... whole page / 一行 ... 整页
+    std::vector<std::string> mechs = { "--mech native", "--mech file" };
+    for (auto strip : memStrips) {
+        mechs.push_back(std::string("--mech memory --strip ") + strip);
+    }
+
+    if (opt.json) {
+        std::puts("[");
+    }
+    else {
+        std::printf("%-7s %10s %-5s %3s %-9s %10s %10s %12s %9s %12s %11s\n", "mech", "block B", "pixel", "bpp", "size in",
+                    "pages/s", "MB/s", "xfer p50 us", "RSS MB", "heap/page", "DSM/page");
+    }
+
+    bool first = true;
+    int failed = 0;
+    for (const auto& mech : mechs) {
+        for (auto size : sizes) {
+            for (auto pixel : PIXEL_TYPES) {
+                char args[512];
+                std::snprintf(args, sizeof(args), " %s --pixel %s --size %s %s --dpi %g --pages %d --batches %d%s --json",
+                              mech.c_str(), pixel, size[0], size[1], opt.dpi, opt.pages, opt.batches, opt.dsm ? " --dsm" : "");
+
+                std::string command = std::string("\"") + self + "\"" + args;
+                std::string out;
+                if (auto pipe = popen(command.c_str(), "r")) {
+                    char buffer[1024];
+                    while (std::fgets(buffer, sizeof(buffer), pipe)) {
+                        out += buffer;
+                    }
+
+                    if (pclose(pipe) != 0) {
+                        out.clear();
+                    }
+                }
+
+                while (!out.empty() && (out.back() == '\n' || out.back() == '\r')) {
+                    out.pop_back();
+                }
+
+                if (out.empty()) {
+                    std::fprintf(stderr, "failed:%s\n", args);
+                    failed++;
+                    continue;
+                }
+
+                if (opt.json) {
+                    std::printf("%s%s", first ? "" : ",\n", out.c_str());
+                }
+                else {
+                    auto pages = std::max(1.0, jsonNumber(out, "pages"));
+                    auto strip = static_cast<unsigned long>(jsonNumber(out, "stripBytes"));
+                    std::printf("%-7s %10s %-5s %3d %4s x %-3s %10.1f %10.1f %12.1f %9.1f %12.1f %11.1f\n",
+                                MECHANISMS[mech.find("native") != std::string::npos ? 0 : mech.find("file") != std::string::npos ? 1 : 2],
+                                strip ? std::to_string(strip).c_str() : "-", pixel, static_cast<int>(jsonNumber(out, "bitDepth")),
+                                size[0], size[1], jsonNumber(out, "pagesPerSecond"), jsonNumber(out, "megabytesPerSecond"),
+                                jsonNumber(out, "p50", "xferLatencyUs"), jsonNumber(out, "peakRssKb") / 1024.0,
+                                jsonNumber(out, "heapAllocs") / pages, jsonNumber(out, "dsmAllocs") / pages);
+                }
+
+                first = false;
+            }
+        }
+    }
+
+    if (opt.json) {
+        std::puts("\n]");
+    }
+
+    return failed ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse(argc, argv, opt)) {
+        usage();
+        return 2;
+    }
+
+    if (opt.matrix) {
+        return runMatrix(argv[0], opt);
+    }
+
+    Manager mgr(Identity(Version(1, 0, Language::English, Country::CzechRepublic, "v1.0"),
+                         DataGroup::Image, "Martin Richter", "Examples", "Synthetic source benchmark"));
+
+    if (opt.dsm) {
+        mgr.load();
+    }
+    else {
+        LoopbackDsm::addSource(DS_Entry);
+        mgr.load(LoopbackDsm::entry());
+    }
+
+    if (!success(mgr.open())) {
+        std::fprintf(stderr, "could not open the DSM\n");
+        return 1;
+    }
+
+    std::vector<Source> sources;
+    mgr.sources(sources);
+    auto it = std::find_if(sources.begin(), sources.end(), [](Source& s) {
+        return s.identity().productName() == SOURCE_NAME;
+    });
+
+    if (it == sources.end()) {
+        std::fprintf(stderr, "the synthetic source is not available\n");
+        return 1;
+    }
+
+    Source src = std::move(*it);
+    if (!success(src.open())) {
+        std::fprintf(stderr, "could not open the source\n");
+        return 1;
+    }
+
+    countDsmAllocs();
+
+    Metrics m;
+    bool ok = configure(src, opt);
+
+    // the samples must not grow while allocations are counted, a memory transfer
+    // takes at most one call per row, plus the one that ends the page
+    // 计数分配期间样本不能增长，内存传输每行最多一次调用，另加结束页面的一次
+    auto pages = static_cast<std::size_t>(opt.pages) * static_cast<std::size_t>(opt.batches);
+    auto callsPerPage = opt.mech == XferMech::Memory ? static_cast<std::size_t>(opt.height * opt.dpi) + 2 : 1;
+    m.page.samples.reserve(pages);
+    m.xfer.samples.reserve(pages * callsPerPage);
+
+    auto heapAllocs = g_heapAllocs.load();
+    auto dsmAllocs = g_dsmAllocs.load();
+    auto start = Clock::now();
+    for (int i = 0; ok && i < opt.batches; i++) {
+        ok = runBatch(src, opt, m);
+    }
+
+    m.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    m.heapAllocs = g_heapAllocs.load() - heapAllocs;
+    m.dsmAllocs = g_dsmAllocs.load() - dsmAllocs;
+    src.close();
+    mgr.close();
+
+    if (!ok) {
+        return 1;
+    }
+
+    if (opt.json) {
+        printJson(opt, m);
+    }
+    else {
+        printText(opt, m);
+    }
+
+    return 0;
+}
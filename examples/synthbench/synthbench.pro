@@ -0,0 +1,21 @@
+# benchmark driver of the synthetic data source
+# the source is linked in and driven through the in-process DSM, run with --dsm to use the installed one
+
+QT = core
+
+TARGET = synthbench
+TEMPLATE = app
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+INCLUDEPATH += $$PWD/../../
+
+# synthentry.cpp compiles the source with TWPP_IS_DS, do not define it here
+SOURCES += main.cpp \
+    synthentry.cpp
+HEADERS += ../synthds/synthds.hpp \
+    ../common/benchutil.hpp \
+    ../common/caphelpers.hpp
+
+unix: LIBS += -ldl
+win32: LIBS += -lpsapi
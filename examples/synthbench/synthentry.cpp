@@ -0,0 +1,6 @@
+﻿// the synthetic source linked into the benchmark, driven through LoopbackDsm
+// the source part of TWPP must be compiled separately from the application part
+// 链接到基准程序中的合成数据源，通过 LoopbackDsm 驱动
+// TWPP 的数据源部分必须与应用程序部分分开编译
+#define TWPP_IS_DS
+#include "../synthds/synthds.cpp"
@@ -0,0 +1,653 @@
+﻿#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include "synthds.hpp"
+#include "../common/caphelpers.hpp"
+using namespace Twpp;
+using namespace CapHelpers;
+using namespace std::placeholders;
+
+TWPP_ENTRY(SynthDs)
+
+static constexpr const Identity srcIdent(
+    Version(1, 0, Language::English, Country::CzechRepublic, "v1.0"),
+    DataGroup::Image,
+    "Martin Richter",
+    "Examples",
+    "Synthetic TWPP data source"
+);
+
+// resolutions the pages can be generated at
+// 可生成页面的分辨率范围
+static constexpr UInt32 RESOLUTION_MIN = 50;
+static constexpr UInt32 RESOLUTION_MAX = 1200;
+static constexpr UInt32 RESOLUTION = 300;
+
+// largest page, and the default US Letter page, in inches
+// 最大页面和默认的 US Letter 页面，单位为英寸
+static constexpr float MAX_WIDTH = 17.0f;
+static constexpr float MAX_HEIGHT = 44.0f;
+static constexpr float PAGE_WIDTH = 8.5f;
+static constexpr float PAGE_HEIGHT = 11.0f;
+
+// distinct rows of the generated pattern, the pages repeat them
+// 生成图案中不同行的数量，页面重复使用这些行
+static constexpr UInt32 PATTERN_ROWS = 64;
+
+// preferred size of a memory transfer strip
+// 内存传输条带的首选大小
+static constexpr UInt32 PREFERRED_STRIP = 1024 * 1024;
+
+// custom capability, pages per second the source generates at most, 0 = as fast as possible
+// 自定义能力，数据源每秒最多生成的页数，0 = 尽可能快
+static constexpr CapType CAP_PAGE_RATE = static_cast<CapType>(static_cast<UInt16>(CapType::CustomBase) + 1);
+
+static const char* DEFAULT_FILE = "synthds.bmp";
+
+// DIB structures, independent of windows.h so that the source builds anywhere
+// DIB 结构，不依赖 windows.h，以便数据源可在任何平台构建
+#pragma pack(push, 2)
+struct DibFileHeader {
+    UInt16 type;
+    UInt32 size;
+    UInt16 reserved1;
+    UInt16 reserved2;
+    UInt32 offBits;
+};
+#pragma pack(pop)
+
+struct DibInfoHeader {
+    UInt32 size;
+    Int32 width;
+    Int32 height;
+    UInt16 planes;
+    UInt16 bitCount;
+    UInt32 compression;
+    UInt32 sizeImage;
+    Int32 xPelsPerMeter;
+    Int32 yPelsPerMeter;
+    UInt32 clrUsed;
+    UInt32 clrImportant;
+};
+
+const Identity& SynthDs::defaultIdentity() noexcept {
+    return srcIdent;
+}
+
+// bit depths of each pixel type, the last one is the default
+// 每种像素类型的位深，最后一个为默认值
+static std::vector<UInt16> bitDepths(PixelType type) {
+    switch (type) {
+    case PixelType::BlackWhite:
+        return { 1 };
+
+    case PixelType::Gray:
+        return { 4, 8 };
+
+    default:
+        return { 24 };
+    }
+}
+
+Result SynthDs::capCommon(const Identity&, Msg msg, Capability& data) {
+    auto it = m_caps.find(data.type());
+    if (it != m_caps.end()) {
+        return (it->second)(msg, data);
+    }
+
+    return capUnsupported();
+}
+
+Result SynthDs::capabilityGet(const Identity& origin, Capability& data) {
+    return capCommon(origin, Msg::Get, data);
+}
+
+Result SynthDs::capabilityGetCurrent(const Identity& origin, Capability& data) {
+    return capCommon(origin, Msg::GetCurrent, data);
+}
+
+Result SynthDs::capabilityGetDefault(const Identity& origin, Capability& data) {
+    return capCommon(origin, Msg::GetDefault, data);
+}
+
+Result SynthDs::capabilityQuerySupport(const Identity&, Capability& data) {
+    auto it = m_query.find(data.type());
+    MsgSupport sup = it != m_query.end() ? it->second : msgSupportEmpty;
+    data = Capability::createOneValue(data.type(), sup);
+    return success();
+}
+
+Result SynthDs::capabilityReset(const Identity& origin, Capability& data) {
+    return capCommon(origin, Msg::Reset, data);
+}
+
+Result SynthDs::capabilityResetAll(const Identity& origin) {
+    for (auto& pair : m_query) {
+        if ((pair.second & MsgSupport::Reset) != msgSupportEmpty) {
+            Capability dummyCap(pair.first);
+            capCommon(origin, Msg::Reset, dummyCap);
+        }
+    }
+
+    return success();
+}
+
+Result SynthDs::capabilitySet(const Identity& origin, Capability& data) {
+    // read-only caps and disallowed containers are rejected before any handler runs
+    // 只读能力与不允许的容器在调用处理函数之前即被拒绝
+    auto cc = capSetCondition(data);
+    if (cc != ConditionCode::Success) {
+        return { ReturnCode::Failure, cc };
+    }
+
+    return capCommon(origin, Msg::Set, data);
+}
+
+Result SynthDs::eventProcess(const Identity&, Event& event) {
+    // no GUI, no events / 没有界面，也就没有事件
+    event.setMessage(Msg::Null);
+    return { ReturnCode::NotDsEvent, ConditionCode::Success };
+}
+
+Result SynthDs::identityOpenDs(const Identity&) {
+    m_query[CapType::SupportedCaps] = msgSupportGetAll;
+    m_caps[CapType::SupportedCaps] = [this](Msg msg, Capability& data) {
+        switch (msg) {
+        case Msg::Get:
+        case Msg::GetCurrent:
+        case Msg::GetDefault: {
+            data = Capability::createArray<CapType::SupportedCaps>(m_supportedCaps.data(),
+                                                                   m_supportedCaps.data() + m_supportedCaps.size());
+
+            return success();
+        }
+
+        default:
+            return capBadOperation();
+        }
+    };
+
+    m_query[CapType::UiControllable] = msgSupportGetAll;
+    m_caps[CapType::UiControllable] = std::bind(enmGet<Bool>, _1, _2, Bool(true));
+
+    m_query[CapType::DeviceOnline] = msgSupportGetAll;
+    m_caps[CapType::DeviceOnline] = std::bind(enmGet<Bool>, _1, _2, Bool(true));
+
+    // -1 generates pages until the application resets the transfers
+    // -1 表示持续生成页面，直到应用程序重置传输
+    m_query[CapType::XferCount] = msgSupportGetAllSetReset;
+    m_caps[CapType::XferCount] = [this](Msg msg, Capability& data) -> Result {
+        if (msg == Msg::Set) {
+            auto item = data.tryCurrentItem<Int16>();
+            if (!item || item.value() < -1 || item.value() == 0) {
+                return badValue();
+            }
+        }
+
+        return oneValGetSet<Int16>(msg, data, m_capXferCount, -1);
+    };
+
+    m_query[CapType::ICompression] = msgSupportGetAllSetReset;
+    m_caps[CapType::ICompression] = std::bind(enmGetSetConst<Compression>, _1, _2, Compression::None);
+
+    m_query[CapType::IXferMech] = msgSupportGetAllSetReset;
+    m_caps[CapType::IXferMech] = std::bind(enmGetSet<XferMech>, _1, _2, std::ref(m_capXferMech),
+        std::vector<XferMech>{ XferMech::Native, XferMech::File, XferMech::Memory }, 0);
+
+    m_query[CapType::IImageFileFormat] = msgSupportGetAllSetReset;
+    m_caps[CapType::IImageFileFormat] = std::bind(enmGetSetConst<ImageFileFormat>, _1, _2, ImageFileFormat::Bmp);
+
+    // a new pixel type selects its default bit depth / 切换像素类型时选择其默认位深
+    m_query[CapType::IPixelType] = msgSupportGetAllSetReset;
+    m_caps[CapType::IPixelType] = [this](Msg msg, Capability& data) -> Result {
+        auto rc = enmGetSet<PixelType>(msg, data, m_capPixelType,
+            std::vector<PixelType>{ PixelType::BlackWhite, PixelType::Gray, PixelType::Rgb }, 2);
+        if (Twpp::success(rc) && (msg == Msg::Set || msg == Msg::Reset)) {
+            m_capBitDepth = bitDepths(m_capPixelType).back();
+        }
+
+        return rc;
+    };
+
+    m_query[CapType::IBitDepth] = msgSupportGetAllSetReset;
+    m_caps[CapType::IBitDepth] = [this](Msg msg, Capability& data) {
+        auto depths = bitDepths(m_capPixelType);
+        return enmGetSet<UInt16>(msg, data, m_capBitDepth, depths, depths.size() - 1);
+    };
+
+    m_query[CapType::IBitOrder] = msgSupportGetAllSetReset;
+    m_caps[CapType::IBitOrder] = std::bind(enmGetSetConst<BitOrder>, _1, _2, BitOrder::MsbFirst);
+
+    m_query[CapType::IPlanarChunky] = msgSupportGetAllSetReset;
+    m_caps[CapType::IPlanarChunky] = std::bind(enmGetSetConst<PlanarChunky>, _1, _2, PlanarChunky::Chunky);
+
+    m_query[CapType::IPixelFlavor] = msgSupportGetAllSetReset;
+    m_caps[CapType::IPixelFlavor] = std::bind(enmGetSetConst<PixelFlavor>, _1, _2, PixelFlavor::Chocolate);
+
+    m_query[CapType::IUnits] = msgSupportGetAllSetReset;
+    m_caps[CapType::IUnits] = std::bind(enmGetSetConst<Unit>, _1, _2, Unit::Inches);
+
+    m_query[CapType::IPhysicalWidth] = msgSupportGetAll;
+    m_caps[CapType::IPhysicalWidth] = std::bind(oneValGet<Fix32>, _1, _2, Fix32(MAX_WIDTH));
+
+    m_query[CapType::IPhysicalHeight] = msgSupportGetAll;
+    m_caps[CapType::IPhysicalHeight] = std::bind(oneValGet<Fix32>, _1, _2, Fix32(MAX_HEIGHT));
+
+    m_capXRes = Fix32(RESOLUTION);
+    m_capYRes = Fix32(RESOLUTION);
+
+    m_query[CapType::IXResolution] = msgSupportGetAllSetReset;
+    m_caps[CapType::IXResolution] = std::bind(rngGetSet, _1, _2, std::ref(m_capXRes),
+        Fix32(RESOLUTION_MIN), Fix32(RESOLUTION_MAX), Fix32(1), Fix32(RESOLUTION));
+
+    m_query[CapType::IYResolution] = msgSupportGetAllSetReset;
+    m_caps[CapType::IYResolution] = std::bind(rngGetSet, _1, _2, std::ref(m_capYRes),
+        Fix32(RESOLUTION_MIN), Fix32(RESOLUTION_MAX), Fix32(1), Fix32(RESOLUTION));
+
+    m_capPageRate = Fix32(0);
+
+    m_query[CAP_PAGE_RATE] = msgSupportGetAllSetReset;
+    m_caps[CAP_PAGE_RATE] = [this](Msg msg, Capability& data) -> Result {
+        if (msg == Msg::Set) {
+            auto item = data.tryCurrentItem<Fix32>();
+            if (!item || item.value() < Fix32(0)) {
+                return badValue();
+            }
+        }
+
+        return oneValGetSet<Fix32>(msg, data, m_capPageRate, Fix32(0));
+    };
+
+    m_frame = Frame(0, 0, PAGE_WIDTH, PAGE_HEIGHT);
+    m_filePath.setData(DEFAULT_FILE, static_cast<UInt32>(std::strlen(DEFAULT_FILE)));
+
+    // the capabilities do not change while the source is open, SupportedCaps copies this list at once
+    // 数据源打开期间能力集合不变，SupportedCaps 一次性复制此列表
+    m_supportedCaps.clear();
+    for (const auto& kv : m_caps) {
+        m_supportedCaps.push_back(kv.first);
+    }
+
+    return success();
+}
+
+Result SynthDs::identityCloseDs(const Identity&) {
+    return success();
+}
+
+Result SynthDs::pendingXfersGet(const Identity&, PendingXfers& data) {
+    data.setCount(m_pendingXfers);
+    return success();
+}
+
+Result SynthDs::pendingXfersEnd(const Identity&, PendingXfers& data) {
+    // 0xFFFF (-1) stays until the application resets the transfers
+    // 0xFFFF (-1) 保持不变，直到应用程序重置传输
+    if (m_pendingXfers && m_pendingXfers != 0xFFFF) {
+        m_pendingXfers--;
+    }
+
+    if (m_pendingXfers) {
+        m_pageNumber++;
+        m_memXferYOff = 0;
+        preparePage();
+        waitNextPage();
+    }
+
+    data.setCount(m_pendingXfers);
+    return success();
+}
+
+Result SynthDs::pendingXfersReset(const Identity&, PendingXfers& data) {
+    m_pendingXfers = 0;
+    data.setCount(0);
+    return success();
+}
+
+Result SynthDs::setupFileXferGet(const Identity&, SetupFileXfer& data) {
+    data = SetupFileXfer(m_filePath, ImageFileFormat::Bmp);
+    return success();
+}
+
+Result SynthDs::setupFileXferGetDefault(const Identity&, SetupFileXfer& data) {
+    Str255 path;
+    path.setData(DEFAULT_FILE, static_cast<UInt32>(std::strlen(DEFAULT_FILE)));
+    data = SetupFileXfer(path, ImageFileFormat::Bmp);
+    return success();
+}
+
+Result SynthDs::setupFileXferSet(const Identity&, SetupFileXfer& data) {
+    // the path must be null terminated, it is passed to fopen
+    // 路径必须以空字符结尾，它会被传给 fopen
+    auto length = data.filePath().size();
+    if (data.format() != ImageFileFormat::Bmp || length == 0 || length > Str255::maxSize()) {
+        return badValue();
+    }
+
+    m_filePath = data.filePath();
+    return success();
+}
+
+Result SynthDs::setupFileXferReset(const Identity& origin, SetupFileXfer& data) {
+    m_filePath.setData(DEFAULT_FILE, static_cast<UInt32>(std::strlen(DEFAULT_FILE)));
+    return setupFileXferGet(origin, data);
+}
+
+Result SynthDs::setupMemXferGet(const Identity&, SetupMemXfer& data) {
+    auto bpl = outBytesPerLine();
+    auto max = bpl * outHeight();
+
+    data.setMinSize(bpl);
+    data.setPreferredSize(std::min(max, std::max(bpl, PREFERRED_STRIP / bpl * bpl)));
+    data.setMaxSize(max);
+    return success();
+}
+
+Result SynthDs::userInterfaceDisable(const Identity&, UserInterface&) {
+    return success();
+}
+
+Result SynthDs::userInterfaceEnable(const Identity&, UserInterface&) {
+    // there is no GUI, the first page is ready right away
+    // with or without UI, DsState::Enabled -> notifyXferReady() -> DsState::XferReady is a single step
+    // 没有界面，第一页立即就绪；无论是否显示界面，Enabled -> XferReady 都是一步完成
+    m_pendingXfers = static_cast<UInt16>(m_capXferCount);
+    m_pageNumber = 0;
+    m_memXferYOff = 0;
+    m_nextPage = std::chrono::steady_clock::now();
+    preparePage();
+    waitNextPage();
+
+    setState(DsState::Enabled);
+    auto notified = notifyXferReady();
+    return Twpp::success(notified) ? success() : bummer();
+}
+
+Result SynthDs::userInterfaceEnableUiOnly(const Identity&, UserInterface&) {
+    // 没有可显示的设置界面
+    return badProtocol();
+}
+
+Result SynthDs::imageInfoGet(const Identity&, ImageInfo& data) {
+    data.setBitsPerPixel(static_cast<Int16>(m_capBitDepth));
+    data.setHeight(static_cast<Int32>(outHeight()));
+    data.setPixelType(m_capPixelType);
+    data.setPlanar(false);
+    data.setWidth(static_cast<Int32>(outWidth()));
+    data.setXResolution(m_capXRes);
+    data.setYResolution(m_capYRes);
+
+    if (m_capPixelType == PixelType::Rgb) {
+        data.setSamplesPerPixel(3);
+        data.bitsPerSample()[0] = 8;
+        data.bitsPerSample()[1] = 8;
+        data.bitsPerSample()[2] = 8;
+    }
+    else {
+        data.setSamplesPerPixel(1);
+        data.bitsPerSample()[0] = static_cast<Int16>(m_capBitDepth);
+    }
+
+    return success();
+}
+
+Result SynthDs::imageLayoutGet(const Identity&, ImageLayout& data) {
+    data.setDocumentNumber(1);
+    data.setFrameNumber(1);
+    data.setPageNumber(m_pageNumber + 1);
+    data.setFrame(m_frame);
+    return success();
+}
+
+Result SynthDs::imageLayoutGetDefault(const Identity&, ImageLayout& data) {
+    data.setDocumentNumber(1);
+    data.setFrameNumber(1);
+    data.setPageNumber(1);
+    data.setFrame(Frame(0, 0, PAGE_WIDTH, PAGE_HEIGHT));
+    return success();
+}
+
+Result SynthDs::imageLayoutSet(const Identity&, ImageLayout& lay) {
+    // clipped to the largest page, reported by CheckStatus
+    // 裁剪到最大页面，并通过 CheckStatus 通知应用程序
+    auto frame = lay.frame();
+    auto left = std::max(Fix32(0), frame.left());
+    auto top = std::max(Fix32(0), frame.top());
+    auto right = std::min(Fix32(MAX_WIDTH), frame.right());
+    auto bottom = std::min(Fix32(MAX_HEIGHT), frame.bottom());
+    if (right <= left || bottom <= top) {
+        return badValue();
+    }
+
+    m_frame = Frame(left, top, right, bottom);
+    lay.setFrame(m_frame);
+    return m_frame == frame ? success() : Result(ReturnCode::CheckStatus, ConditionCode::Success);
+}
+
+Result SynthDs::imageLayoutReset(const Identity& origin, ImageLayout& data) {
+    m_frame = Frame(0, 0, PAGE_WIDTH, PAGE_HEIGHT);
+    return imageLayoutGet(origin, data);
+}
+
+Result SynthDs::imageFileXferGet(const Identity&) {
+    if (!m_pendingXfers || m_capXferMech != XferMech::File) {
+        return seqError();
+    }
+
+    auto bpl = outBytesPerLine();
+    auto height = outHeight();
+    auto headerSize = dibHeaderSize();
+
+    DibFileHeader file;
+    file.type = 0x4d42; // "BM"
+    file.size = static_cast<UInt32>(sizeof(DibFileHeader)) + headerSize + bpl * height;
+    file.reserved1 = 0;
+    file.reserved2 = 0;
+    file.offBits = static_cast<UInt32>(sizeof(DibFileHeader)) + headerSize;
+
+    std::vector<char> header(headerSize);
+    writeDibHeader(header.data());
+
+    auto out = std::fopen(m_filePath.data(), "wb");
+    if (!out) {
+        return { ReturnCode::Failure, ConditionCode::FileWriteError };
+    }
+
+    bool ok = std::fwrite(&file, sizeof(file), 1, out) == 1 &&
+            std::fwrite(header.data(), header.size(), 1, out) == 1;
+
+    // bottom-up rows / 自底向上的行
+    for (UInt32 y = height; ok && y > 0; y--) {
+        ok = std::fwrite(patternRow(y - 1), bpl, 1, out) == 1;
+    }
+
+    ok = std::fclose(out) == 0 && ok;
+    if (!ok) {
+        return { ReturnCode::Failure, ConditionCode::FileWriteError };
+    }
+
+    return { ReturnCode::XferDone, ConditionCode::Success };
+}
+
+Result SynthDs::imageMemXferGet(const Identity& origin, ImageMemXfer& data) {
+    if (!m_pendingXfers || m_capXferMech != XferMech::Memory) {
+        return seqError();
+    }
+
+    SetupMemXfer setup;
+    setupMemXferGet(origin, setup);
+
+    auto bpl = outBytesPerLine();
+    auto height = outHeight();
+    auto memSize = data.memory().size();
+    if (memSize > setup.maxSize() || memSize < setup.minSize()) {
+        return badValue();
+    }
+
+    auto rows = std::min<UInt32>(memSize / bpl, height - m_memXferYOff);
+    if (rows == 0) {
+        return seqError(); // 此会话中已传输图像
+    }
+
+    data.setBytesPerRow(bpl);
+    data.setColumns(outWidth());
+    data.setRows(rows);
+    data.setBytesWritten(rows * bpl);
+    data.setXOffset(0);
+    data.setYOffset(m_memXferYOff);
+    data.setCompression(Compression::None);
+
+    auto lock = data.memory().data();
+    char* out = lock.data();
+    for (UInt32 i = 0; i < rows; i++) {
+        auto row = patternRow(m_memXferYOff + i);
+        std::copy(row, row + bpl, out);
+        out += bpl;
+    }
+
+    m_memXferYOff += rows;
+
+    if (m_memXferYOff >= height) {
+        return { ReturnCode::XferDone, ConditionCode::Success };
+    }
+
+    return success();
+}
+
+Result SynthDs::imageNativeXferGet(const Identity&, ImageNativeXfer& data) {
+    if (!m_pendingXfers || m_capXferMech != XferMech::Native) {
+        return seqError();
+    }
+
+    // a DIB on every platform / 在所有平台上都是 DIB
+    auto bpl = outBytesPerLine();
+    auto height = outHeight();
+    auto headerSize = dibHeaderSize();
+    data = ImageNativeXfer(headerSize + bpl * height);
+
+    auto lock = data.data<char>();
+    writeDibHeader(lock.data());
+
+    char* pixels = lock.data() + headerSize;
+    for (UInt32 y = 0; y < height; y++) {
+        auto row = patternRow(y);
+        std::copy(row, row + bpl, pixels + bpl * (height - 1 - y));
+    }
+
+    return { ReturnCode::XferDone, ConditionCode::Success };
+}
+
+UInt32 SynthDs::outWidth() const noexcept {
+    auto inches = static_cast<float>(m_frame.width());
+    return std::max<UInt32>(1, static_cast<UInt32>(inches * static_cast<float>(m_capXRes) + 0.5f));
+}
+
+UInt32 SynthDs::outHeight() const noexcept {
+    auto inches = static_cast<float>(m_frame.height());
+    return std::max<UInt32>(1, static_cast<UInt32>(inches * static_cast<float>(m_capYRes) + 0.5f));
+}
+
+UInt32 SynthDs::outBytesPerLine() const noexcept {
+    // DWORD-aligned rows, the same for memory transfers and DIBs
+    // 行按 DWORD 对齐，内存传输和 DIB 相同
+    return (outWidth() * m_capBitDepth + 31) / 32 * 4;
+}
+
+UInt32 SynthDs::dibHeaderSize() const noexcept {
+    auto colors = m_capBitDepth <= 8 ? UInt32(1) << m_capBitDepth : 0;
+    return static_cast<UInt32>(sizeof(DibInfoHeader)) + colors * 4;
+}
+
+void SynthDs::writeDibHeader(char* out) const noexcept {
+    auto colors = m_capBitDepth <= 8 ? UInt32(1) << m_capBitDepth : 0;
+
+    DibInfoHeader dib;
+    dib.size = sizeof(DibInfoHeader);
+    dib.width = static_cast<Int32>(outWidth());
+    dib.height = static_cast<Int32>(outHeight());
+    dib.planes = 1;
+    dib.bitCount = m_capBitDepth;
+    dib.compression = 0; // BI_RGB
+    dib.sizeImage = outBytesPerLine() * outHeight();
+    dib.xPelsPerMeter = static_cast<Int32>(static_cast<float>(m_capXRes) / 0.0254f + 0.5f);
+    dib.yPelsPerMeter = static_cast<Int32>(static_cast<float>(m_capYRes) / 0.0254f + 0.5f);
+    dib.clrUsed = colors;
+    dib.clrImportant = 0;
+    std::memcpy(out, &dib, sizeof(dib));
+
+    // gray palette, black & white is a gray palette of two levels
+    // 灰度调色板，黑白是两级的灰度调色板
+    auto palette = reinterpret_cast<unsigned char*>(out + sizeof(dib));
+    for (UInt32 i = 0; i < colors; i++) {
+        auto level = static_cast<unsigned char>(i * 255 / (colors - 1));
+        palette[i * 4] = level;
+        palette[i * 4 + 1] = level;
+        palette[i * 4 + 2] = level;
+        palette[i * 4 + 3] = 0;
+    }
+}
+
+void SynthDs::preparePage() {
+    auto width = outWidth();
+    auto bpl = outBytesPerLine();
+    if (width == m_patternWidth && m_capBitDepth == m_patternBpp && bpl == m_patternBpl) {
+        return;
+    }
+
+    // diagonal gradients, symmetric RGB pixels read the same as BGR in DIBs
+    // 对角渐变，对称的 RGB 像素在 DIB 中按 BGR 读取也相同
+    m_pattern.assign(static_cast<std::size_t>(bpl) * PATTERN_ROWS, 0);
+    for (UInt32 r = 0; r < PATTERN_ROWS; r++) {
+        auto row = reinterpret_cast<unsigned char*>(m_pattern.data() + static_cast<std::size_t>(bpl) * r);
+        for (UInt32 x = 0; x < width; x++) {
+            auto level = static_cast<unsigned char>(x + r * 4);
+            switch (m_capBitDepth) {
+            case 1:
+                if (((x >> 3) + (r >> 3)) & 1) {
+                    row[x / 8] |= static_cast<unsigned char>(0x80 >> (x % 8));
+                }
+                break;
+
+            case 4:
+                row[x / 2] |= static_cast<unsigned char>((level >> 4) << (x % 2 ? 0 : 4));
+                break;
+
+            case 8:
+                row[x] = level;
+                break;
+
+            default:
+                row[x * 3] = level;
+                row[x * 3 + 1] = static_cast<unsigned char>(x ^ (r * 4));
+                row[x * 3 + 2] = level;
+                break;
+            }
+        }
+    }
+
+    m_patternWidth = width;
+    m_patternBpp = m_capBitDepth;
+    m_patternBpl = bpl;
+}
+
+const char* SynthDs::patternRow(UInt32 y) const noexcept {
+    // pages differ from each other by the rows they start with
+    // 各页从不同的行开始，因此彼此不同
+    auto r = (y + m_pageNumber) % PATTERN_ROWS;
+    return m_pattern.data() + static_cast<std::size_t>(m_patternBpl) * r;
+}
+
+void SynthDs::waitNextPage() {
+    auto rate = static_cast<float>(m_capPageRate);
+    if (rate <= 0.0f) {
+        return;
+    }
+
+    std::this_thread::sleep_until(m_nextPage);
+
+    // no bursts to catch up after the application has been late
+    // 应用程序迟到后不会突发追赶
+    auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(1.0f / rate));
+    m_nextPage = std::max(m_nextPage, std::chrono::steady_clock::now()) + period;
+}
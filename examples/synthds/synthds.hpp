@@ -0,0 +1,106 @@
+﻿#ifndef SYNTHDS_HPP
+#define SYNTHDS_HPP
+
+#include <twpp.hpp>
+#include <unordered_map>
+#include <chrono>
+
+namespace std {
+
+template<>
+struct hash<Twpp::CapType> {
+    size_t operator()(Twpp::CapType cap) const{
+        return hash<Twpp::UInt16>()(static_cast<Twpp::UInt16>(cap));
+    }
+};
+
+}
+
+// synthetic data source, generates pages of the negotiated size, pixel type and rate without any device
+// 合成数据源，无需任何设备即可按协商的尺寸、像素类型和速率生成页面
+class SynthDs : public Twpp::SourceFromThis<SynthDs> {
+
+public:
+    static const Twpp::Identity& defaultIdentity() noexcept;
+
+    // SourceFromThis interface
+protected:
+    typedef Twpp::SourceFromThis<SynthDs> Base;
+
+    virtual Twpp::Result capabilityGet(const Twpp::Identity& origin, Twpp::Capability& data) override;
+    virtual Twpp::Result capabilityGetCurrent(const Twpp::Identity& origin, Twpp::Capability& data) override;
+    virtual Twpp::Result capabilityGetDefault(const Twpp::Identity& origin, Twpp::Capability& data) override;
+    virtual Twpp::Result capabilityQuerySupport(const Twpp::Identity& origin, Twpp::Capability& data) override;
+    virtual Twpp::Result capabilityReset(const Twpp::Identity& origin, Twpp::Capability& data) override;
+    virtual Twpp::Result capabilityResetAll(const Twpp::Identity& origin) override;
+    virtual Twpp::Result capabilitySet(const Twpp::Identity& origin, Twpp::Capability& data) override;
+    virtual Twpp::Result eventProcess(const Twpp::Identity& origin, Twpp::Event& data) override;
+    virtual Twpp::Result identityOpenDs(const Twpp::Identity& origin) override;
+    virtual Twpp::Result identityCloseDs(const Twpp::Identity& origin) override;
+    virtual Twpp::Result pendingXfersGet(const Twpp::Identity& origin, Twpp::PendingXfers& data) override;
+    virtual Twpp::Result pendingXfersEnd(const Twpp::Identity& origin, Twpp::PendingXfers& data) override;
+    virtual Twpp::Result pendingXfersReset(const Twpp::Identity& origin, Twpp::PendingXfers& data) override;
+    virtual Twpp::Result setupFileXferGet(const Twpp::Identity& origin, Twpp::SetupFileXfer& data) override;
+    virtual Twpp::Result setupFileXferGetDefault(const Twpp::Identity& origin, Twpp::SetupFileXfer& data) override;
+    virtual Twpp::Result setupFileXferSet(const Twpp::Identity& origin, Twpp::SetupFileXfer& data) override;
+    virtual Twpp::Result setupFileXferReset(const Twpp::Identity& origin, Twpp::SetupFileXfer& data) override;
+    virtual Twpp::Result setupMemXferGet(const Twpp::Identity& origin, Twpp::SetupMemXfer& data) override;
+    virtual Twpp::Result userInterfaceDisable(const Twpp::Identity& origin, Twpp::UserInterface& data) override;
+    virtual Twpp::Result userInterfaceEnable(const Twpp::Identity& origin, Twpp::UserInterface& data) override;
+    virtual Twpp::Result userInterfaceEnableUiOnly(const Twpp::Identity& origin, Twpp::UserInterface& data) override;
+    virtual Twpp::Result imageInfoGet(const Twpp::Identity& origin, Twpp::ImageInfo& data) override;
+    virtual Twpp::Result imageLayoutGet(const Twpp::Identity& origin, Twpp::ImageLayout& data) override;
+    virtual Twpp::Result imageLayoutGetDefault(const Twpp::Identity& origin, Twpp::ImageLayout& data) override;
+    virtual Twpp::Result imageLayoutSet(const Twpp::Identity& origin, Twpp::ImageLayout& data) override;
+    virtual Twpp::Result imageLayoutReset(const Twpp::Identity& origin, Twpp::ImageLayout& data) override;
+    virtual Twpp::Result imageFileXferGet(const Twpp::Identity& origin) override;
+    virtual Twpp::Result imageMemXferGet(const Twpp::Identity& origin, Twpp::ImageMemXfer& data) override;
+    virtual Twpp::Result imageNativeXferGet(const Twpp::Identity& origin, Twpp::ImageNativeXfer& data) override;
+
+private:
+    Twpp::Result capCommon(const Twpp::Identity& origin, Twpp::Msg msg, Twpp::Capability& data);
+
+    // page geometry at the negotiated resolution / 按协商分辨率计算的页面几何
+    Twpp::UInt32 outWidth() const noexcept;
+    Twpp::UInt32 outHeight() const noexcept;
+    Twpp::UInt32 outBytesPerLine() const noexcept;
+
+    // DIB header and palette of native and file transfers / 原生和文件传输的 DIB 头和调色板
+    Twpp::UInt32 dibHeaderSize() const noexcept;
+    void writeDibHeader(char* out) const noexcept;
+
+    // pattern rows of the next page, rebuilt only when the geometry changes
+    // 下一页的图案行，仅在几何变化时重建
+    void preparePage();
+    const char* patternRow(Twpp::UInt32 y) const noexcept;
+
+    // blocks until the next page is due according to the page rate
+    // 按页面速率阻塞到下一页应当就绪的时间
+    void waitNextPage();
+
+    std::unordered_map<Twpp::CapType, std::function<Twpp::Result(Twpp::Msg msg, Twpp::Capability& data)>> m_caps;
+    std::unordered_map<Twpp::CapType, Twpp::MsgSupport> m_query;
+    std::vector<Twpp::CapType> m_supportedCaps; // keys of m_caps, listed when the source opens / m_caps 的键，打开数据源时生成
+
+    Twpp::Int16 m_capXferCount = -1;
+    Twpp::XferMech m_capXferMech = Twpp::XferMech::Native;
+    Twpp::PixelType m_capPixelType = Twpp::PixelType::Rgb;
+    Twpp::UInt16 m_capBitDepth = 24;
+    Twpp::Fix32 m_capXRes;
+    Twpp::Fix32 m_capYRes;
+    Twpp::Fix32 m_capPageRate;
+    Twpp::Frame m_frame;
+    Twpp::Str255 m_filePath;
+
+    Twpp::UInt16 m_pendingXfers = 0;
+    Twpp::UInt32 m_pageNumber = 0;
+    Twpp::UInt32 m_memXferYOff = 0;
+
+    std::vector<char> m_pattern;
+    Twpp::UInt32 m_patternBpl = 0;
+    Twpp::UInt32 m_patternWidth = 0;
+    Twpp::UInt16 m_patternBpp = 0;
+    std::chrono::steady_clock::time_point m_nextPage;
+};
+
+#endif // SYNTHDS_HPP
@@ -0,0 +1,22 @@
+# synthetic data source for throughput benchmarks, no device or GUI needed
+# place the resulting file "synthds.ds" into \Windows\twain_32 (\Windows\twain_64 for 64bit builds)
+# or use the synthbench example, which links the source directly
+
+QT = core
+
+TARGET = synthds
+TARGET_EXT = .ds
+TEMPLATE = lib
+
+CONFIG += c++11
+DEFINES += TWPP_IS_DS
+INCLUDEPATH += $$PWD/../../
+
+DEF_FILE = exports.def
+
+SOURCES += synthds.cpp
+HEADERS += synthds.hpp \
+    ../common/caphelpers.hpp
+
+DISTFILES += \
+    exports.def
@@ -29,6 +29,7 @@ SOFTWARE.
 
 #include "twpp/env.hpp"
 
+#include <algorithm>
 #include <cstdint>
 #include <cstdlib>
 #include <initializer_list>
@@ -40,6 +41,12 @@ SOFTWARE.
 #include <stdexcept>
 #include <mutex>
 #include <condition_variable>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <deque>
+#include <vector>
 #include <map>
 #include <string>
 #include <list>
@@ -48,6 +55,11 @@ SOFTWARE.
 #include <utility>
 #include <cassert>
 
+#if defined(__cpp_impl_coroutine) && !defined(TWPP_NO_COROUTINES)
+#   define TWPP_DETAIL_COROUTINES
+#   include <coroutine>
+#endif
+
 #include "twpp/utils.hpp"
 
 #include "twpp/types.hpp"
@@ -67,9 +79,11 @@ SOFTWARE.
 #include "twpp/imagelayout.hpp"
 #include "twpp/deviceevent.hpp"
 #include "twpp/element8.hpp"
+#include "twpp/supporteddat.hpp"
 
 #include "twpp/audio.hpp"
 #include "twpp/capability.hpp"
+#include "twpp/capinfo.hpp"
 #include "twpp/customdata.hpp"
 #include "twpp/cie.hpp"
 #include "twpp/curveresponse.hpp"
@@ -79,6 +93,7 @@ SOFTWARE.
 #include "twpp/imagememxfer.hpp"
 #include "twpp/imagenativexfer.hpp"
 #include "twpp/internal.hpp"
+#include "twpp/loopback.hpp"
 #include "twpp/jpegcompression.hpp"
 #include "twpp/palette8.hpp"
 #include "twpp/passthrough.hpp"
@@ -89,6 +104,9 @@ SOFTWARE.
 
 #if !defined(TWPP_IS_DS)
 #   include "twpp/application.hpp"
+#   include "twpp/memxferring.hpp"
+#   include "twpp/xferengine.hpp"
+#   include "twpp/coroutine.hpp"
 #else
 #   include "twpp/datasource.hpp"
 #endif
@@ -56,11 +56,44 @@ struct ManagerData {
 
 struct SourceData {
 
+#if defined(TWPP_DETAIL_OS_LINUX)
+    SourceData(ManagerData* mgr, const Identity& srcIdent) noexcept :
+        m_mgr(mgr), m_srcId(srcIdent), m_eventFd(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)){}
+
+    ~SourceData(){
+        if (m_eventFd >= 0){
+            ::close(m_eventFd);
+        }
+    }
+
+    SourceData(const SourceData&) = delete;
+    SourceData& operator=(const SourceData&) = delete;
+
+    /// Signals the event descriptor, m_cbMutex must be held.
+    void signalEvent() noexcept{
+        if (m_eventFd >= 0){
+            ::eventfd_t one = 1;
+            auto written = ::write(m_eventFd, &one, sizeof(one));
+            Detail::unused(written);
+        }
+    }
+
+    /// Resets the event descriptor, m_cbMutex must be held.
+    void drainEvent() noexcept{
+        if (m_eventFd >= 0){
+            ::eventfd_t count;
+            auto read = ::read(m_eventFd, &count, sizeof(count));
+            Detail::unused(read);
+        }
+    }
+#else
     SourceData(ManagerData* mgr, const Identity& srcIdent) noexcept :
         m_mgr(mgr), m_srcId(srcIdent){}
+#endif
 
     ManagerData* m_mgr;
     std::function<void()> m_devEvent;
+    std::function<void()> m_readyCallBack;
     Handle m_uiHandle;
     Identity m_srcId;
     DsState m_state = DsState::Closed;
@@ -69,6 +102,7 @@ struct SourceData {
 #if defined(TWPP_DETAIL_OS_LINUX)
     std::mutex m_cbMutex;
     std::condition_variable m_cbCond;
+    int m_eventFd;
 #elif !defined(TWPP_DETAIL_OS_WIN) && !defined(TWPP_DETAIL_OS_MAC)
 #   error "SourceData for your platform here"
 #endif
@@ -186,6 +220,32 @@ public:
         d()->m_devEvent = std::move(devEvent);
     }
 
+    /// Sets function (object) to be notified once the source has a message for the application.
+    ///
+    /// {Called from the TWAIN callback, whenever the source posts a message (e.g. SCAN or CANCEL
+    /// button was pressed) in state 5 (enabled). The function should return immediately,
+    /// the message is then obtained by `pollReady()`. Requires the source to use callbacks (DSM2).}
+    void setReadyCallBack(EventCallBack ready){
+        assert(isValid());
+
+        d()->m_readyCallBack = std::move(ready);
+    }
+
+#if defined(TWPP_DETAIL_OS_LINUX)
+    /// Pollable file descriptor of this source, Linux only.
+    /// Becomes readable (POLLIN, EPOLLIN) once the source has a message
+    /// for the application, e.g. the SCAN or CANCEL button was pressed.
+    /// Call `processEvent()` to obtain the message, which also resets the descriptor.
+    /// Allows waiting on the source from an existing event loop instead of `waitReady()`.
+    /// The descriptor is owned by the source, do not close it.
+    /// \return The descriptor, -1 if it could not be created.
+    int eventFd() const noexcept{
+        assert(isValid());
+
+        return d()->m_eventFd;
+    }
+#endif
+
 
     // Control ->
 
@@ -340,6 +400,8 @@ public:
         while (d()->m_readyMsg == Msg::Null){
             d()->m_cbCond.wait(lock);
         }
+
+        d()->drainEvent();
 #else
 #   error "waitReady for your platform here"
 #endif
@@ -367,6 +429,7 @@ public:
     /// Processes a single GUI event without blocking.
     /// Can be used instead of `waitReady()` to process a single event.
     /// Windows users must pass events from GUI loop to this method to be sent to DS.
+    /// Linux users may call this whenever `eventFd()` becomes readable, the descriptor is reset here.
     /// \return {Failure on error, Cancel on CANCEL button, Success on SAVE or SCAN button,
     ///          CheckStatus on device event. NotDsEvent OR DsEvent when not ready yet.}
 #if defined (TWPP_DETAIL_OS_WIN)
@@ -401,6 +464,7 @@ public:
         std::unique_lock<std::mutex> lock(d()->m_cbMutex);
         auto msg = d()->m_readyMsg;
         d()->m_readyMsg = Msg::Null;
+        d()->drainEvent();
         lock.unlock();
 #   endif
 
@@ -428,6 +492,48 @@ public:
         }
     }
 
+    /// Obtains the message the source posted through the TWAIN callback.
+    /// Does not block, and does not process any GUI events.
+    /// Meant to be called once the ready callback fired, see `setReadyCallBack()`.
+    /// \return {Failure on error, Cancel on CANCEL button, Success on SAVE or SCAN button,
+    ///          CheckStatus on device event. NotDsEvent when not ready yet.}
+    ReturnCode pollReady(){
+        assert(isValid());
+
+#if defined(TWPP_DETAIL_OS_LINUX)
+        std::unique_lock<std::mutex> lock(d()->m_cbMutex);
+        auto msg = d()->m_readyMsg;
+        d()->m_readyMsg = Msg::Null;
+        d()->drainEvent();
+        lock.unlock();
+#elif defined(TWPP_DETAIL_OS_WIN) || defined(TWPP_DETAIL_OS_MAC)
+        auto msg = d()->m_readyMsg;
+        d()->m_readyMsg = Msg::Null;
+#else
+#   error "pollReady for your platform here"
+#endif
+
+        switch (msg){
+            case Msg::XferReady: // ok/scan button <=> Msg::EnableDs
+                d()->m_state = DsState::XferReady;
+                // fallthrough
+            case Msg::CloseDsOk: // ok/scan button <=> Msg::EnableDsUiOnly
+                return ReturnCode::Success;
+
+            case Msg::CloseDsReq: // cancel button
+                return ReturnCode::Cancel;
+
+            case Msg::DeviceEvent:
+                return ReturnCode::CheckStatus;
+
+            case Msg::Null:
+                return ReturnCode::NotDsEvent;
+
+            default:
+                return ReturnCode::Failure;
+        }
+    }
+
     /// Sends custom, user-defined data to the source.
     /// This operation is unsafe, there is no way to discover
     /// possible connection state changes.
@@ -860,12 +966,22 @@ private:
 #if defined(TWPP_DETAIL_OS_WIN)
             ::PostMessageA(static_cast<HWND>(src->m_mgr->m_rootWindow.raw()), WM_NULL, 0, 0);
 #elif defined(TWPP_DETAIL_OS_LINUX)
+            src->signalEvent();
             src->m_cbCond.notify_one();
 #elif defined(TWPP_DETAIL_OS_MAC)
             Detail::NSLoop::postDummy();
 #else
 #   error "callBack for your platform here"
 #endif
+
+#if defined(TWPP_DETAIL_OS_LINUX)
+            if (lock.owns_lock()){ // released above if the state was different then
+                lock.unlock(); // the ready callback may call pollReady
+            }
+#endif
+            if (src->m_readyCallBack){
+                src->m_readyCallBack();
+            }
         }
 
 
@@ -957,6 +1073,22 @@ public:
         return resolved;
     }
 
+    /// Uses an in-process manager instead of loading the library, e.g. `LoopbackDsm::entry()`.
+    /// Not a TWAIN call.
+    /// \param entry Entry of the manager.
+    /// \return Whether the manager was set.
+    bool load(Detail::DsmEntry entry) noexcept{
+        assert(isValid());
+
+        if (d()->m_state != DsmState::PreSession || !entry){
+            return false;
+        }
+
+        d()->m_entry = entry;
+        d()->m_state = DsmState::Loaded;
+        return true;
+    }
+
     /// Unloads the manager library.
     /// Not a TWAIN call.
     /// \return Whether this call unloaded the library.
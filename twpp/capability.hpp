@@ -192,7 +192,7 @@ template<> struct Cap<CapType::Segmented> {static constexpr const Type twty = Ty
 template<> struct Cap<CapType::SerialNumber> {static constexpr const Type twty = Type::Str255; typedef Str255 DataType;};
 template<> struct Cap<CapType::SupportedCaps> {static constexpr const Type twty = Type::UInt16; typedef CapType DataType;};
 template<> struct Cap<CapType::SupportedCapsSegmentUnique> {static constexpr const Type twty = Type::UInt16; typedef CapType DataType;};
-//template<> struct Cap<CapType::SupportedDats> {static constexpr const Type twty = Type::UInt32; typedef SupportedDat DataType;};
+template<> struct Cap<CapType::SupportedDats> {static constexpr const Type twty = Type::UInt32; typedef SupportedDat DataType;};
 template<> struct Cap<CapType::ThumbnailsEnabled> {static constexpr const Type twty = Type::Bool; typedef Bool DataType;};
 template<> struct Cap<CapType::TimeBeforeFirstCapture> {static constexpr const Type twty = Type::Int32; typedef Int32 DataType;};
 template<> struct Cap<CapType::TimeBetweenCaptures> {static constexpr const Type twty = Type::Int32; typedef Int32 DataType;};
@@ -346,6 +346,127 @@ struct IsNumeric {
     static constexpr bool value = std::is_integral<DataType>::value || std::is_same<DataType, Fix32>::value;
 };
 
+/// Range value widened to 64 bits, Fix32 in units of 1/65536.
+/// Range arithmetic is done in this type, values sent by applications may not overflow it.
+template<typename DataType>
+static constexpr inline std::int64_t rangeRaw(DataType val) noexcept{
+    return static_cast<std::int64_t>(val);
+}
+
+static constexpr inline std::int64_t rangeRaw(Fix32 val) noexcept{
+    return val.raw();
+}
+
+/// Converts widened range value back to its data type.
+template<typename DataType>
+struct RangeRawCast {
+    static constexpr DataType cast(std::int64_t raw) noexcept{
+        return static_cast<DataType>(raw);
+    }
+};
+
+template<>
+struct RangeRawCast<Fix32> {
+    static constexpr Fix32 cast(std::int64_t raw) noexcept{
+        return Fix32::fromRaw(static_cast<Int32>(raw));
+    }
+};
+
+/// Values `min + N * step` not exceeding `max`, widened range values.
+/// No values if the step is not positive or the bounds are inverted.
+///
+/// Fix32 ranges are usually decimal values rounded to 1/65536, min and step
+/// by up to half a unit each, so the N-th value drifts by up to (N + 1) / 2 units.
+/// A maximum within that drift, and below half a step, of a range value is taken
+/// as the last value, and the values are then interpolated from min to max
+/// and rounded to Fix32, e.g. 0.1 to 5.0 by 0.1 has 50 values including 1.0 and 5.0.
+/// Fix32 values match range values up to a single unit, the rounding error of a value,
+/// unless the step is that small.
+class RangeGrid {
+
+public:
+    RangeGrid(std::int64_t min, std::int64_t max, std::int64_t step, bool quantised) noexcept :
+        m_min(min), m_max(max), m_step(step), m_count(0), m_interpolated(false), m_tolerance(quantised && step > 2 ? 1 : 0){
+
+        if (step <= 0 || max < min){
+            return;
+        }
+
+        auto span = max - min;
+        auto rem = span % step;
+        m_count = span / step + 1;
+        if (quantised && rem != 0){
+            auto drift = std::min((m_count + 2) / 2, (step - 1) / 2);
+            if (step - rem <= drift){
+                m_count++;
+                m_interpolated = true;
+            } else if (rem <= drift){
+                m_interpolated = true;
+            }
+        }
+    }
+
+    /// Number of values.
+    std::int64_t count() const noexcept{
+        return m_count;
+    }
+
+    /// Value at the index, which must be below the count.
+    std::int64_t value(std::int64_t index) const noexcept{
+        return m_interpolated ? m_min + divRound(index * (m_max - m_min), m_count - 1) : m_min + index * m_step;
+    }
+
+    /// Index of the value closest to `raw`, may be outside of the grid.
+    /// Halfway values go to the value farther from the minimum.
+    std::int64_t nearestIndex(std::int64_t raw) const noexcept{
+        auto offset = raw - m_min;
+        return m_interpolated ? divRound(offset * (m_count - 1), m_max - m_min) : divRound(offset, m_step);
+    }
+
+    /// Index of the value matching `raw`, -1 if there is none.
+    std::int64_t indexOf(std::int64_t raw) const noexcept{
+        auto index = nearestIndex(raw);
+        if (index < 0 || index >= m_count){
+            return -1;
+        }
+
+        auto diff = raw - value(index);
+        return diff >= -m_tolerance && diff <= m_tolerance ? index : -1;
+    }
+
+    /// The value closest to `raw`, the grid must not be empty.
+    std::int64_t nearest(std::int64_t raw) const noexcept{
+        return value(std::max<std::int64_t>(0, std::min(nearestIndex(raw), m_count - 1)));
+    }
+
+private:
+    std::int64_t m_min;
+    std::int64_t m_max;
+    std::int64_t m_step;
+    std::int64_t m_count;
+    bool m_interpolated;
+    std::int64_t m_tolerance;
+
+};
+
+/// Copies container items, contiguous items of the same type by a single memcpy.
+template<typename InputIt, typename DataType>
+static inline void copyItems(InputIt first, InputIt last, DataType* out){
+    std::copy(first, last, out);
+}
+
+template<typename DataType>
+static inline void copyItems(const DataType* first, const DataType* last, DataType* out) noexcept{
+    if (first != last){
+        std::memcpy(out, first, static_cast<std::size_t>(last - first) * sizeof(DataType));
+    }
+}
+
+template<typename DataType>
+static inline void copyItems(DataType* first, DataType* last, DataType* out) noexcept{
+    copyItems(static_cast<const DataType*>(first), static_cast<const DataType*>(last), out);
+}
+
 }
 
 class Capability;
@@ -686,40 +807,38 @@ private:
 
     public:
         constexpr IteratorImpl() noexcept :
-            m_curr(), m_parent(nullptr){}
+            m_index(0), m_parent(nullptr){}
 
         IterDataType operator*() const noexcept{
-            return m_curr;
+            return Detail::RangeRawCast<IterDataType>::cast(m_parent->grid().value(m_index));
         }
 
         IteratorImpl& operator++() noexcept{ // prefix
-            m_curr += step();
-            checkValue();
+            m_index++;
             return *this;
         }
 
         IteratorImpl operator++(int) noexcept{ // postfix
             IteratorImpl ret(*this);
-            m_curr += step();
-            checkValue();
+            m_index++;
             return ret;
         }
 
         IteratorImpl& operator--() noexcept{ // prefix
-            m_curr -= step();
+            m_index--;
             return *this;
         }
 
         IteratorImpl operator--(int) noexcept{ // postfix
             IteratorImpl ret(*this);
-            m_curr -= step();
+            m_index--;
             return ret;
         }
 
         bool operator==(const IteratorImpl& o) const noexcept{
-            return m_curr == o.m_curr &&
+            return m_index == o.m_index &&
                     (m_parent == o.m_parent ||
-                        (m_parent && o.m_parent && step() == o.step())
+                        (m_parent && o.m_parent && m_parent->m_data.data() == o.m_parent->m_data.data())
                      );
         }
 
@@ -728,25 +847,10 @@ private:
         }
 
     private:
-        IterDataType step() const noexcept{
-            return m_parent->stepSize();
-        }
+        IteratorImpl(std::int64_t index, const Range& parent) noexcept :
+            m_index(index), m_parent(&parent){}
 
-        IterDataType max() const noexcept{
-            return m_parent->maxValue();
-        }
-
-        void checkValue() noexcept{
-            // avoid infinite loops in case no such N exists: `min + N * step == max`
-            if (m_curr > max()){
-                m_curr = max() + step();
-            }
-        }
-
-        IteratorImpl(IterDataType curr, const Range& parent) noexcept :
-            m_curr(curr), m_parent(&parent){}
-
-        IterDataType m_curr;
+        std::int64_t m_index;
         const Range* m_parent;
 
     };
@@ -816,12 +920,51 @@ public:
         return m_data;
     }
 
+    /// Number of values in the range, computed without iterating it.
+    /// Zero if the step is not positive or the maximum is below the minimum,
+    /// clamped to the largest UInt32.
+    /// Fix32 ranges of decimal values, e.g. 0.1 to 5.0 by 0.1, tolerate
+    /// the rounding of the values to 1/65536, see Detail::RangeGrid.
+    UInt32 size() const noexcept{
+        return static_cast<UInt32>(std::min<std::int64_t>(grid().count(), std::numeric_limits<UInt32>::max()));
+    }
+
+    /// Index of the value within the range, -1 if it is not one of the range values.
+    std::int64_t indexOf(DataType val) const noexcept{
+        return grid().indexOf(Detail::rangeRaw(val));
+    }
+
+    /// Whether the value is one of the range values, `min + N * step` not exceeding max.
+    bool contains(DataType val) const noexcept{
+        return indexOf(val) >= 0;
+    }
+
+    /// Whether the value is one of the values of a range with the supplied bounds and step,
+    /// no container is needed.
+    static bool contains(DataType min, DataType max, DataType step, DataType val) noexcept{
+        return grid(min, max, step).indexOf(Detail::rangeRaw(val)) >= 0;
+    }
+
+    /// The range value closest to `val`, values outside of the range are clamped.
+    /// Halfway values go to the value farther from the minimum.
+    /// Returns the minimum if the range has no values.
+    DataType nearest(DataType val) const noexcept{
+        return nearest(minValue(), maxValue(), stepSize(), val);
+    }
+
+    /// The value closest to `val` of a range with the supplied bounds and step,
+    /// no container is needed.
+    static DataType nearest(DataType min, DataType max, DataType step, DataType val) noexcept{
+        auto g = grid(min, max, step);
+        return g.count() == 0 ? min : Detail::RangeRawCast<DataType>::cast(g.nearest(Detail::rangeRaw(val)));
+    }
+
     const_iterator begin() const noexcept{
         return cbegin();
     }
 
     const_iterator cbegin() const noexcept{
-        return const_iterator(m_data->m_minValue, *this);
+        return const_iterator(0, *this);
     }
 
     const_iterator end() const noexcept{
@@ -829,17 +972,21 @@ public:
     }
 
     const_iterator cend() const noexcept{
-        auto step = m_data->m_stepSize;
-        if (step != DataType()){
-            return const_iterator(m_data->m_maxValue + step, *this);
-        } else {
-            return cbegin(); // no items with step equal to zero
-        }
+        return const_iterator(grid().count(), *this); // no items with non-positive step, or inverted bounds
     }
 
 private:
     Range(Handle h) : m_data(h){}
 
+    Detail::RangeGrid grid() const noexcept{
+        return grid(minValue(), maxValue(), stepSize());
+    }
+
+    static Detail::RangeGrid grid(DataType min, DataType max, DataType step) noexcept{
+        return Detail::RangeGrid(Detail::rangeRaw(min), Detail::rangeRaw(max), Detail::rangeRaw(step),
+                                 std::is_same<DataType, Fix32>::value);
+    }
+
     Detail::Lock<Detail::RangeData<DataType> > m_data;
 
 };
@@ -864,6 +1011,63 @@ template<typename DataType>
 class Range<Type::Str255, DataType>;
 
 
+/// Reason why a non-throwing capability access failed.
+/// Mirrors the exceptions thrown by the throwing counterparts.
+enum class CapError {
+    None,      ///< No error, value is present.
+    NoData,    ///< Capability does not contain any data, see DataException.
+    Container, ///< Unexpected or invalid container, see ContainerException.
+    ItemType   ///< Item type does not match, see ItemTypeException.
+};
+
+/// Result of a non-throwing capability access.
+/// Holds either a value, or the reason why it could not be retrieved.
+/// \tparam DataType Exported data type.
+template<typename DataType>
+class CapResult {
+
+public:
+    /// Creates a successful result.
+    CapResult(const DataType& value) noexcept :
+        m_value(value), m_error(CapError::None){}
+
+    /// Creates a failed result.
+    CapResult(CapError error) noexcept :
+        m_value(), m_error(error){}
+
+    /// Whether the value is present.
+    bool hasValue() const noexcept{
+        return m_error == CapError::None;
+    }
+
+    /// Whether the value is present.
+    explicit operator bool() const noexcept{
+        return hasValue();
+    }
+
+    /// Reason of the failure, CapError::None on success.
+    CapError error() const noexcept{
+        return m_error;
+    }
+
+    /// The contained value.
+    /// Default-constructed value on failure.
+    const DataType& value() const noexcept{
+        return m_value;
+    }
+
+    /// The contained value, or `def` on failure.
+    DataType valueOr(const DataType& def) const noexcept{
+        return hasValue() ? m_value : def;
+    }
+
+private:
+    DataType m_value;
+    CapError m_error;
+
+};
+
+
 namespace Detail {
 
 template<Type type, bool, typename DataType>
@@ -1152,12 +1356,8 @@ public:
             case ConType::OneValue:
                 return 1;
             case ConType::Range: {
-                auto& rng = *reinterpret_cast<Detail::RangeData<DataType>*>(m_data.data());
-                if (rng.m_stepSize != DataType()){
-                    return static_cast<UInt32>(static_cast<float>(Detail::abs(rng.m_maxValue - rng.m_minValue) / rng.m_stepSize)) + 1;
-                } else {
-                    return 0;
-                }
+                // same number of items as iterated, see Range::cend
+                return Detail::alias_cast<const Range<type, DataType>*>(&m_data)->size();
             }
             default:
                 return 0; // should not happen
@@ -1207,6 +1407,7 @@ public:
 template<Type type, typename DataType, bool isNumeric> // false
 struct CurrentItemImpl {
     static DataType item(Capability& cap);
+    static CapResult<DataType> tryItem(Capability& cap) noexcept;
 };
 
 /// Capability current item implementation.
@@ -1215,6 +1416,7 @@ struct CurrentItemImpl {
 template<Type type, typename DataType>
 struct CurrentItemImpl<type, DataType, true> {
     static DataType item(Capability& cap);
+    static CapResult<DataType> tryItem(Capability& cap) noexcept;
 };
 
 /// Capability current item implementation.
@@ -1223,6 +1425,7 @@ struct CurrentItemImpl<type, DataType, true> {
 template<typename DataType>
 struct CurrentItemImpl<Type::Handle, DataType, false> {
     static DataType item(Capability& cap);
+    static CapResult<DataType> tryItem(Capability& cap) noexcept;
 };
 
 /// Capability current item.
@@ -1283,6 +1486,9 @@ class Capability {
     template<Type, bool, typename>
     friend class Detail::CapDataImpl;
 
+    template<Type, typename, bool>
+    friend struct Detail::CurrentItemImpl;
+
 public:
     /// Creates capability holding OneValue container.
     /// \tparam type ID of the internal data type.
@@ -1360,16 +1566,7 @@ public:
     /// \throw std::bad_alloc
     template<Type type, typename DataType>
     static Capability createArray(CapType cap, std::initializer_list<DataType> values){
-        Capability ret = createArray<type, DataType>(cap, static_cast<UInt32>(values.size()));
-        auto arr = ret.array<type, DataType>();
-
-        UInt32 i = 0;
-        for (const auto& val : values){
-            arr[i] = val;
-            i++;
-        }
-
-        return ret;
+        return createArray<type, DataType>(cap, values.begin(), values.end());
     }
 
     /// Creates capability holding Array container.
@@ -1420,6 +1617,55 @@ public:
         return createArray<Detail::Cap<cap>::twty, typename Detail::Cap<cap>::DataType>(cap, values);
     }
 
+    /// Creates capability holding Array container.
+    /// The container is allocated once, items of a contiguous range of DataType, e.g. a pointer range,
+    /// are copied by a single memcpy.
+    /// \tparam type ID of the internal data type.
+    /// \tparam DataType Exported data type.
+    /// \tparam InputIt Forward iterator of values convertible to DataType.
+    /// \param cap Capability type.
+    /// \param first Iterator to the first value.
+    /// \param last Iterator past the last value.
+    /// \throw std::bad_alloc
+    template<Type type, typename DataType, typename InputIt, typename = typename std::enable_if<!std::is_integral<InputIt>::value>::type>
+    static Capability createArray(CapType cap, InputIt first, InputIt last){
+        Capability ret = createArray<type, DataType>(cap, static_cast<UInt32>(std::distance(first, last)));
+        Detail::copyItems(first, last, ret.array<type, DataType>().begin());
+        return ret;
+    }
+
+    /// Creates capability holding Array container, see `createArray(CapType, InputIt, InputIt)`.
+    /// \tparam type ID of the internal data type.
+    /// \param cap Capability type.
+    /// \param first Iterator to the first value.
+    /// \param last Iterator past the last value.
+    /// \throw std::bad_alloc
+    template<Type type, typename InputIt, typename = typename std::enable_if<!std::is_integral<InputIt>::value>::type>
+    static Capability createArray(CapType cap, InputIt first, InputIt last){
+        return createArray<type, typename Detail::Twty<type>::Type>(cap, first, last);
+    }
+
+    /// Creates capability holding Array container, see `createArray(CapType, InputIt, InputIt)`.
+    /// \tparam T Data type.
+    /// \param cap Capability type.
+    /// \param first Iterator to the first value.
+    /// \param last Iterator past the last value.
+    /// \throw std::bad_alloc
+    template<typename T, typename InputIt, typename = typename std::enable_if<!std::is_integral<InputIt>::value>::type>
+    static Capability createArray(CapType cap, InputIt first, InputIt last){
+        return createArray<Detail::Tytw<T>::twty, T>(cap, first, last);
+    }
+
+    /// Creates capability holding Array container, see `createArray(CapType, InputIt, InputIt)`.
+    /// \tparam cap Capability type. Data types are set accordingly.
+    /// \param first Iterator to the first value.
+    /// \param last Iterator past the last value.
+    /// \throw std::bad_alloc
+    template<CapType cap, typename InputIt, typename = typename std::enable_if<!std::is_integral<InputIt>::value>::type>
+    static Capability createArray(InputIt first, InputIt last){
+        return createArray<Detail::Cap<cap>::twty, typename Detail::Cap<cap>::DataType>(cap, first, last);
+    }
+
 
     /// Creates capability holding Enumeration container.
     /// \tparam type ID of the internal data type.
@@ -1461,16 +1707,7 @@ public:
     /// \throw std::bad_alloc
     template<Type type, typename DataType>
     static Capability createEnumeration(CapType cap, std::initializer_list<DataType> values, UInt32 currIndex = 0, UInt32 defIndex = 0){
-        Capability ret = createEnumeration<type, DataType>(cap, static_cast<UInt32>(values.size()), currIndex, defIndex);
-        auto enm = ret.enumeration<type, DataType>();
-
-        UInt32 i = 0;
-        for (const auto& val : values){
-            enm[i] = val;
-            i++;
-        }
-
-        return ret;
+        return createEnumeration<type, DataType>(cap, values.begin(), values.end(), currIndex, defIndex);
     }
 
     /// Creates capability holding Enumeration container.
@@ -1531,6 +1768,63 @@ public:
         return createEnumeration<Detail::Cap<cap>::twty, typename Detail::Cap<cap>::DataType>(cap, values, currIndex, defIndex);
     }
 
+    /// Creates capability holding Enumeration container.
+    /// The container is allocated once, items of a contiguous range of DataType, e.g. a pointer range,
+    /// are copied by a single memcpy.
+    /// \tparam type ID of the internal data type.
+    /// \tparam DataType Exported data type.
+    /// \tparam InputIt Forward iterator of values convertible to DataType.
+    /// \param cap Capability type.
+    /// \param first Iterator to the first value.
+    /// \param last Iterator past the last value.
+    /// \param currIndex Index of the currently selected item.
+    /// \param defIndex Index of the default item.
+    /// \throw std::bad_alloc
+    template<Type type, typename DataType, typename InputIt, typename = typename std::enable_if<!std::is_integral<InputIt>::value>::type>
+    static Capability createEnumeration(CapType cap, InputIt first, InputIt last, UInt32 currIndex = 0, UInt32 defIndex = 0){
+        Capability ret = createEnumeration<type, DataType>(cap, static_cast<UInt32>(std::distance(first, last)), currIndex, defIndex);
+        Detail::copyItems(first, last, ret.enumeration<type, DataType>().begin());
+        return ret;
+    }
+
+    /// Creates capability holding Enumeration container, see `createEnumeration(CapType, InputIt, InputIt, UInt32, UInt32)`.
+    /// \tparam type ID of the internal data type.
+    /// \param cap Capability type.
+    /// \param first Iterator to the first value.
+    /// \param last Iterator past the last value.
+    /// \param currIndex Index of the currently selected item.
+    /// \param defIndex Index of the default item.
+    /// \throw std::bad_alloc
+    template<Type type, typename InputIt, typename = typename std::enable_if<!std::is_integral<InputIt>::value>::type>
+    static Capability createEnumeration(CapType cap, InputIt first, InputIt last, UInt32 currIndex = 0, UInt32 defIndex = 0){
+        return createEnumeration<type, typename Detail::Twty<type>::Type>(cap, first, last, currIndex, defIndex);
+    }
+
+    /// Creates capability holding Enumeration container, see `createEnumeration(CapType, InputIt, InputIt, UInt32, UInt32)`.
+    /// \tparam T Data type.
+    /// \param cap Capability type.
+    /// \param first Iterator to the first value.
+    /// \param last Iterator past the last value.
+    /// \param currIndex Index of the currently selected item.
+    /// \param defIndex Index of the default item.
+    /// \throw std::bad_alloc
+    template<typename T, typename InputIt, typename = typename std::enable_if<!std::is_integral<InputIt>::value>::type>
+    static Capability createEnumeration(CapType cap, InputIt first, InputIt last, UInt32 currIndex = 0, UInt32 defIndex = 0){
+        return createEnumeration<Detail::Tytw<T>::twty, T>(cap, first, last, currIndex, defIndex);
+    }
+
+    /// Creates capability holding Enumeration container, see `createEnumeration(CapType, InputIt, InputIt, UInt32, UInt32)`.
+    /// \tparam cap Capability type. Data types are set accordingly.
+    /// \param first Iterator to the first value.
+    /// \param last Iterator past the last value.
+    /// \param currIndex Index of the currently selected item.
+    /// \param defIndex Index of the default item.
+    /// \throw std::bad_alloc
+    template<CapType cap, typename InputIt, typename = typename std::enable_if<!std::is_integral<InputIt>::value>::type>
+    static Capability createEnumeration(InputIt first, InputIt last, UInt32 currIndex = 0, UInt32 defIndex = 0){
+        return createEnumeration<Detail::Cap<cap>::twty, typename Detail::Cap<cap>::DataType>(cap, first, last, currIndex, defIndex);
+    }
+
 
     /// Creates capability holding Range container.
     /// \tparam type ID of the internal data type.
@@ -1924,6 +2218,41 @@ public:
         return currentItem<Detail::Cap<cap>::twty, typename Detail::Cap<cap>::DataType>();
     }
 
+    /// Returns a copy of the current item of this capability, does not throw.
+    /// Can be used only with Enumeration, OneValue, and Range containers.
+    /// Malformed containers (e.g. current index out of bounds) are reported
+    /// as CapError::Container instead of being accessed.
+    /// \tparam type ID of the internal data type.
+    /// \tparam DataType Exported data type.
+    template<Type type, typename DataType>
+    CapResult<DataType> tryCurrentItem() noexcept{
+        return Detail::CurrentItem<type, DataType>::tryItem(*this);
+    }
+
+    /// Returns a copy of the current item of this capability, does not throw.
+    /// Can be used only with Enumeration, OneValue, and Range containers.
+    /// \tparam type ID of the internal data type.
+    template<Type type>
+    CapResult<typename Detail::Twty<type>::Type> tryCurrentItem() noexcept{
+        return tryCurrentItem<type, typename Detail::Twty<type>::Type>();
+    }
+
+    /// Returns a copy of the current item of this capability, does not throw.
+    /// Can be used only with Enumeration, OneValue, and Range containers.
+    /// \tparam T Data type.
+    template<typename T>
+    CapResult<T> tryCurrentItem() noexcept{
+        return tryCurrentItem<Detail::Tytw<T>::twty, T>();
+    }
+
+    /// Returns a copy of the current item of this capability, does not throw.
+    /// Can be used only with Enumeration, OneValue, and Range containers.
+    /// \tparam cap Capability type. Data types are set accordingly.
+    template<CapType cap>
+    CapResult<typename Detail::Cap<cap>::DataType> tryCurrentItem() noexcept{
+        return tryCurrentItem<Detail::Cap<cap>::twty, typename Detail::Cap<cap>::DataType>();
+    }
+
 private:
     /// \throw DataException
     /// \throw ContainerException
@@ -1955,6 +2284,33 @@ private:
         return std::move(ret);
     }
 
+    /// Non-throwing variant of containerCheck.
+    /// Returns an invalid container and sets `err` on failure.
+    template<template<Type, typename> class Container, Type type, typename DataType>
+    Container<type, DataType> containerTry(CapError& err) noexcept{
+        static_assert(type != Type::DontCare, "type may not be DontCare");
+        static_assert(sizeof(typename Detail::Twty<type>::Type) == sizeof(DataType), "type sizes dont match");
+
+        if (!m_cont){
+            err = CapError::NoData;
+            return Container<type, DataType>();
+        }
+
+        if (Container<type, DataType>::contype != container()){
+            err = CapError::Container;
+            return Container<type, DataType>();
+        }
+
+        Container<type, DataType> ret(m_cont.get());
+        if (type != ret.type()){
+            err = CapError::ItemType;
+            return Container<type, DataType>();
+        }
+
+        err = CapError::None;
+        return ret;
+    }
+
     CapType m_cap;
     ConType m_conType;
     Detail::UniqueHandle m_cont;
@@ -2197,6 +2553,12 @@ public:
         return m_cap.currentItem<cap>();
     }
 
+    /// Returns a copy of the current item of this capability, does not throw.
+    /// Can be used only with Enumeration, OneValue, and Range containers.
+    CapResult<DataType> tryCurrentItem() noexcept{
+        return m_cap.tryCurrentItem<cap>();
+    }
+
     /// Moves out the contained Capability instance.
     /// This instance becomes empty.
     Capability toCapability() noexcept{
@@ -2290,8 +2652,14 @@ inline CapDataImpl<type, true, DataType>::CapDataImpl(const Capability& cap) :
 template<Type type, typename DataType, bool isNumeric> // false
 DataType CurrentItemImpl<type, DataType, isNumeric>::item(Capability& cap){
     switch (cap.container()){
-        case ConType::Enumeration:
-            return cap.enumeration<type, DataType>().currentItem();
+        case ConType::Enumeration: {
+            auto enm = cap.enumeration<type, DataType>();
+            if (enm.currentIndex() >= enm.size()){
+                throw ContainerException();
+            }
+
+            return enm.currentItem();
+        }
 
         case ConType::OneValue:
             return cap.oneValue<type, DataType>().item();
@@ -2307,8 +2675,14 @@ DataType CurrentItemImpl<type, DataType, isNumeric>::item(Capability& cap){
 template<Type type, typename DataType>
 DataType CurrentItemImpl<type, DataType, true>::item(Capability& cap){
     switch (cap.container()){
-        case ConType::Enumeration:
-            return cap.enumeration<type, DataType>().currentItem();
+        case ConType::Enumeration: {
+            auto enm = cap.enumeration<type, DataType>();
+            if (enm.currentIndex() >= enm.size()){
+                throw ContainerException();
+            }
+
+            return enm.currentItem();
+        }
 
         case ConType::OneValue:
             return cap.oneValue<type, DataType>().item();
@@ -2329,6 +2703,88 @@ DataType CurrentItemImpl<Type::Handle, DataType, false>::item(Capability& cap){
     return cap.oneValue<Type::Handle, DataType>().item();
 }
 
+template<Type type, typename DataType, bool isNumeric> // false
+CapResult<DataType> CurrentItemImpl<type, DataType, isNumeric>::tryItem(Capability& cap) noexcept{
+    CapError err;
+    switch (cap.container()){
+        case ConType::Enumeration: {
+            auto enm = cap.containerTry<Enumeration, type, DataType>(err);
+            if (err != CapError::None){
+                return err;
+            }
+
+            if (enm.currentIndex() >= enm.size()){
+                return CapError::Container;
+            }
+
+            return enm.currentItem();
+        }
+
+        case ConType::OneValue: {
+            auto ov = cap.containerTry<OneValue, type, DataType>(err);
+            if (err != CapError::None){
+                return err;
+            }
+
+            return ov.item();
+        }
+
+        default:
+            return cap ? CapError::Container : CapError::NoData;
+    }
+}
+
+template<Type type, typename DataType>
+CapResult<DataType> CurrentItemImpl<type, DataType, true>::tryItem(Capability& cap) noexcept{
+    CapError err;
+    switch (cap.container()){
+        case ConType::Enumeration: {
+            auto enm = cap.containerTry<Enumeration, type, DataType>(err);
+            if (err != CapError::None){
+                return err;
+            }
+
+            if (enm.currentIndex() >= enm.size()){
+                return CapError::Container;
+            }
+
+            return enm.currentItem();
+        }
+
+        case ConType::OneValue: {
+            auto ov = cap.containerTry<OneValue, type, DataType>(err);
+            if (err != CapError::None){
+                return err;
+            }
+
+            return ov.item();
+        }
+
+        case ConType::Range: {
+            auto rng = cap.containerTry<Range, type, DataType>(err);
+            if (err != CapError::None){
+                return err;
+            }
+
+            return rng.currentValue();
+        }
+
+        default:
+            return cap ? CapError::Container : CapError::NoData;
+    }
+}
+
+template<typename DataType>
+CapResult<DataType> CurrentItemImpl<Type::Handle, DataType, false>::tryItem(Capability& cap) noexcept{
+    CapError err;
+    auto ov = cap.containerTry<OneValue, Type::Handle, DataType>(err);
+    if (err != CapError::None){
+        return err;
+    }
+
+    return ov.item();
+}
+
 }
 
 }
@@ -0,0 +1,372 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2015-2020 Martin Richter
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#ifndef TWPP_DETAIL_FILE_CAPINFO_HPP
+#define TWPP_DETAIL_FILE_CAPINFO_HPP
+
+#include "../twpp.hpp"
+
+namespace Twpp {
+
+namespace Detail {
+
+/// Bit of a container type in CapInfo, 0 for DontCare and invalid values.
+static constexpr UInt8 conBit(ConType con) noexcept{
+    return con >= ConType::Array && con <= ConType::Range ?
+                static_cast<UInt8>(1 << (static_cast<UInt16>(con) - static_cast<UInt16>(ConType::Array))) : 0;
+}
+
+}
+
+/// Static description of a standard capability:
+/// type and size of its items, containers allowed by the specification
+/// for MSG_GET and MSG_SET, and whether it is read-only.
+///
+/// Descriptions are generated from `Detail::Cap` at compile time, see `capInfo`.
+class CapInfo {
+
+public:
+    /// Creates invalid description, used for custom and unknown capabilities.
+    constexpr CapInfo() noexcept :
+        m_cap(static_cast<CapType>(0)), m_type(Type::DontCare), m_itemSize(0),
+        m_containers(0), m_readOnly(false){}
+
+    /// Creates description of a capability.
+    /// \param containers Allowed containers, bitwise OR of `Detail::conBit` values.
+    constexpr CapInfo(CapType cap, Type type, UInt32 itemSize, UInt8 containers, bool readOnly) noexcept :
+        m_cap(cap), m_type(type), m_itemSize(itemSize),
+        m_containers(containers), m_readOnly(readOnly){}
+
+    /// Whether this describes a standard capability.
+    constexpr bool isValid() const noexcept{
+        return m_type != Type::DontCare;
+    }
+
+    /// Capability type.
+    constexpr CapType cap() const noexcept{
+        return m_cap;
+    }
+
+    /// Type of items, DontCare if invalid.
+    constexpr Type itemType() const noexcept{
+        return m_type;
+    }
+
+    /// Size of a single item in bytes, equal to `typeSize(itemType())`.
+    constexpr UInt32 itemSize() const noexcept{
+        return m_itemSize;
+    }
+
+    /// Whether the capability may use the container.
+    constexpr bool allows(ConType con) const noexcept{
+        return (m_containers & Detail::conBit(con)) != 0;
+    }
+
+    /// Whether the capability can not be set or reset by the application.
+    constexpr bool readOnly() const noexcept{
+        return m_readOnly;
+    }
+
+private:
+    CapType m_cap;
+    Type m_type;
+    UInt32 m_itemSize;
+    UInt8 m_containers;
+    bool m_readOnly;
+
+};
+
+namespace Detail {
+
+static constexpr const UInt8 conOne = conBit(ConType::OneValue);
+static constexpr const UInt8 conArray = conBit(ConType::Array);
+static constexpr const UInt8 conOneEnum = conOne | conBit(ConType::Enumeration);
+static constexpr const UInt8 conOneEnumRange = conOneEnum | conBit(ConType::Range);
+static constexpr const UInt8 conOneEnumArray = conOneEnum | conArray;
+static constexpr const UInt8 conOneArrayRange = conOne | conArray | conBit(ConType::Range);
+
+/// Whether `Cap` is specialized for the capability.
+template<CapType cap>
+struct HasCap {
+    template<typename C>
+    static constexpr bool test(decltype(C::twty)*) noexcept{
+        return true;
+    }
+
+    template<typename C>
+    static constexpr bool test(...) noexcept{
+        return false;
+    }
+
+    static constexpr const bool value = test<Cap<cap> >(nullptr);
+};
+
+/// Number of capabilities in `Cap` with type in [begin, end), halves the interval
+/// to keep the template recursion shallow.
+template<UInt16 begin, UInt16 end, bool single = end - begin == 1>
+struct CapCount {
+    static constexpr const std::size_t value = CapCount<begin, (begin + end) / 2>::value +
+            CapCount<(begin + end) / 2, end>::value;
+};
+
+template<UInt16 begin, UInt16 end>
+struct CapCount<begin, end, true> {
+    static constexpr const std::size_t value = HasCap<static_cast<CapType>(begin)>::value ? 1 : 0;
+};
+
+template<CapType cap>
+static constexpr CapInfo makeCapInfo(UInt8 containers, bool readOnly) noexcept{
+    return CapInfo(cap, Cap<cap>::twty, sizeof(typename Twty<Cap<cap>::twty>::Type), containers, readOnly);
+}
+
+static constexpr bool capInfoSorted(const CapInfo* info, std::size_t size) noexcept{
+    return size < 2 || (info[0].cap() < info[1].cap() && capInfoSorted(info + 1, size - 1));
+}
+
+// templates behave as if they were defined in at most one module
+// ideal for storing static data
+template<typename Dummy>
+struct CapInfoTable {
+    /// Descriptions of all capabilities in `Cap`, sorted by capability type.
+    /// Containers are those listed by TWAIN 2.4 specification.
+    static constexpr const CapInfo table[] = {
+        makeCapInfo<CapType::XferCount>(conOne, false),
+        makeCapInfo<CapType::ICompression>(conOneEnum, false),
+        makeCapInfo<CapType::IPixelType>(conOneEnum, false),
+        makeCapInfo<CapType::IUnits>(conOneEnum, false),
+        makeCapInfo<CapType::IXferMech>(conOneEnum, false),
+        makeCapInfo<CapType::Author>(conOne, false),
+        makeCapInfo<CapType::Caption>(conOne, false),
+        makeCapInfo<CapType::FeederEnabled>(conOneEnum, false),
+        makeCapInfo<CapType::FeederLoaded>(conOne, true),
+        makeCapInfo<CapType::TimeDate>(conOne, false),
+        makeCapInfo<CapType::SupportedCaps>(conArray, true),
+        makeCapInfo<CapType::ExtendedCaps>(conArray, false),
+        makeCapInfo<CapType::AutoFeed>(conOneEnum, false),
+        makeCapInfo<CapType::ClearPage>(conOne, false),
+        makeCapInfo<CapType::FeedPage>(conOne, false),
+        makeCapInfo<CapType::RewindPage>(conOne, false),
+        makeCapInfo<CapType::Indicators>(conOneEnum, false),
+        makeCapInfo<CapType::PaperDetectable>(conOne, true),
+        makeCapInfo<CapType::UiControllable>(conOne, true),
+        makeCapInfo<CapType::DeviceOnline>(conOne, true),
+        makeCapInfo<CapType::AutoScan>(conOneEnum, false),
+        makeCapInfo<CapType::ThumbnailsEnabled>(conOneEnum, false),
+        makeCapInfo<CapType::Duplex>(conOne, true),
+        makeCapInfo<CapType::DuplexEnabled>(conOneEnum, false),
+        makeCapInfo<CapType::EnableDsUiOnly>(conOne, true),
+        makeCapInfo<CapType::CustomDsData>(conOne, true),
+        makeCapInfo<CapType::Endorser>(conOneEnumRange, false),
+        makeCapInfo<CapType::JobControl>(conOneEnum, false),
+        makeCapInfo<CapType::Alarms>(conArray, false),
+        makeCapInfo<CapType::AlarmVolume>(conOneEnumRange, false),
+        makeCapInfo<CapType::AutomaticCapture>(conOneEnumRange, false),
+        makeCapInfo<CapType::TimeBeforeFirstCapture>(conOneEnumRange, false),
+        makeCapInfo<CapType::TimeBetweenCaptures>(conOneEnumRange, false),
+        makeCapInfo<CapType::ClearBuffers>(conOneEnum, false),
+        makeCapInfo<CapType::MaxBatchBuffers>(conOneEnumRange, false),
+        makeCapInfo<CapType::DeviceTimeDate>(conOne, false),
+        makeCapInfo<CapType::PowerSupply>(conOneEnum, true),
+        makeCapInfo<CapType::CameraPreviewUi>(conOne, true),
+        makeCapInfo<CapType::DeviceEvent>(conArray, false),
+        makeCapInfo<CapType::SerialNumber>(conOne, true),
+        makeCapInfo<CapType::Printer>(conOneEnum, false),
+        makeCapInfo<CapType::PrinterEnabled>(conOneEnum, false),
+        makeCapInfo<CapType::PrinterIndex>(conOneEnumRange, false),
+        makeCapInfo<CapType::PrinterMode>(conOneEnum, false),
+        makeCapInfo<CapType::PrinterString>(conOneEnumArray, false),
+        makeCapInfo<CapType::PrinterSuffix>(conOne, false),
+        makeCapInfo<CapType::Language>(conOneEnum, false),
+        makeCapInfo<CapType::FeederAlignment>(conOneEnum, false),
+        makeCapInfo<CapType::FeederOrder>(conOneEnum, false),
+        makeCapInfo<CapType::ReacquireAllowed>(conOne, true),
+        makeCapInfo<CapType::BatteryMinutes>(conOne, true),
+        makeCapInfo<CapType::BatteryPercentage>(conOne, true),
+        makeCapInfo<CapType::CameraSide>(conOneEnum, false),
+        makeCapInfo<CapType::Segmented>(conOneEnum, false),
+        makeCapInfo<CapType::CameraEnabled>(conOneEnum, false),
+        makeCapInfo<CapType::CameraOrder>(conArray, false),
+        makeCapInfo<CapType::MicrEnabled>(conOneEnum, false),
+        makeCapInfo<CapType::FeederPrep>(conOneEnum, false),
+        makeCapInfo<CapType::FeederPocket>(conOneEnumArray, false),
+        makeCapInfo<CapType::AutomaticSenseMedium>(conOneEnum, false),
+        makeCapInfo<CapType::CustomInterfaceGuid>(conOne, true),
+        makeCapInfo<CapType::SupportedCapsSegmentUnique>(conArray, true),
+        makeCapInfo<CapType::SupportedDats>(conArray, true),
+        makeCapInfo<CapType::DoubleFeedDetection>(conOneEnumArray, false),
+        makeCapInfo<CapType::DoubleFeedDetectionLength>(conOneEnumRange, false),
+        makeCapInfo<CapType::DoubleFeedDetectionSensitivity>(conOneEnum, false),
+        makeCapInfo<CapType::DoubleFeedDetectionResponse>(conOneEnumArray, false),
+        makeCapInfo<CapType::PaperHandling>(conOneEnum, false),
+        makeCapInfo<CapType::IndicatorsMode>(conArray, false),
+        makeCapInfo<CapType::PrinterVerticalOffset>(conOneEnumRange, false),
+        makeCapInfo<CapType::PowerSaveTime>(conOneEnumRange, false),
+        makeCapInfo<CapType::PrinterCharRotation>(conOneEnum, false),
+        makeCapInfo<CapType::PrinterFontStyle>(conOneEnum, false),
+        makeCapInfo<CapType::PrinterIndexLeadChar>(conOneEnum, false),
+        makeCapInfo<CapType::PrinterIndexMaxValue>(conOneEnumRange, false),
+        makeCapInfo<CapType::PrinterIndexNumDigits>(conOneEnumRange, false),
+        makeCapInfo<CapType::PrinterIndexStep>(conOneEnumRange, false),
+        makeCapInfo<CapType::PrinterIndexTrigger>(conOneEnumArray, false),
+        makeCapInfo<CapType::PrinterStringPreview>(conOne, true),
+        makeCapInfo<CapType::IAutoBright>(conOneEnum, false),
+        makeCapInfo<CapType::IBrightness>(conOneEnumRange, false),
+        makeCapInfo<CapType::IContrast>(conOneEnumRange, false),
+        makeCapInfo<CapType::ICustHalfTone>(conArray, false),
+        makeCapInfo<CapType::IExposureTime>(conOneEnumRange, false),
+        makeCapInfo<CapType::IFilter>(conOneEnumArray, false),
+        makeCapInfo<CapType::IFlashUsed>(conOneEnum, false),
+        makeCapInfo<CapType::IGamma>(conOneEnumRange, false),
+        makeCapInfo<CapType::IHalfTones>(conOneEnum, false),
+        makeCapInfo<CapType::IHighLight>(conOneEnumRange, false),
+        makeCapInfo<CapType::IImageFileFormat>(conOneEnum, false),
+        makeCapInfo<CapType::ILampState>(conOneEnum, false),
+        makeCapInfo<CapType::ILightSource>(conOneEnum, false),
+        makeCapInfo<CapType::IOrientation>(conOneEnum, false),
+        makeCapInfo<CapType::IPhysicalWidth>(conOne, true),
+        makeCapInfo<CapType::IPhysicalHeight>(conOne, true),
+        makeCapInfo<CapType::IShadow>(conOneEnumRange, false),
+        makeCapInfo<CapType::IFrames>(conOneEnum, false),
+        makeCapInfo<CapType::IXNativeResolution>(conOne, true),
+        makeCapInfo<CapType::IYNativeResolution>(conOne, true),
+        makeCapInfo<CapType::IXResolution>(conOneEnumRange, false),
+        makeCapInfo<CapType::IYResolution>(conOneEnumRange, false),
+        makeCapInfo<CapType::IMaxFrames>(conOneEnumRange, false),
+        makeCapInfo<CapType::ITiles>(conOneEnum, false),
+        makeCapInfo<CapType::IBitOrder>(conOneEnum, false),
+        makeCapInfo<CapType::ICcittKFactor>(conOne, false),
+        makeCapInfo<CapType::ILightPath>(conOneEnum, false),
+        makeCapInfo<CapType::IPixelFlavor>(conOneEnum, false),
+        makeCapInfo<CapType::IPlanarChunky>(conOneEnum, false),
+        makeCapInfo<CapType::IRotation>(conOneEnumRange, false),
+        makeCapInfo<CapType::ISupportedSizes>(conOneEnum, false),
+        makeCapInfo<CapType::IThreshold>(conOneEnumRange, false),
+        makeCapInfo<CapType::IXScaling>(conOneEnumRange, false),
+        makeCapInfo<CapType::IYScaling>(conOneEnumRange, false),
+        makeCapInfo<CapType::IBitOrderCodes>(conOneEnum, false),
+        makeCapInfo<CapType::IPixelFlavorCodes>(conOneEnum, false),
+        makeCapInfo<CapType::IJpegPixelType>(conOneEnum, false),
+        makeCapInfo<CapType::ITimeFill>(conOne, false),
+        makeCapInfo<CapType::IBitDepth>(conOneEnumRange, false),
+        makeCapInfo<CapType::IBitDepthReduction>(conOneEnum, false),
+        makeCapInfo<CapType::IUndefinedImageSize>(conOneEnum, false),
+        makeCapInfo<CapType::IImageDataSet>(conOneArrayRange, false),
+        makeCapInfo<CapType::IExtImageInfo>(conOneEnum, false),
+        makeCapInfo<CapType::IMinimumHeight>(conOne, true),
+        makeCapInfo<CapType::IMinimumWidth>(conOne, true),
+        makeCapInfo<CapType::IAutoDiscardBlankPages>(conOneEnumRange, false),
+        makeCapInfo<CapType::IFlipRotation>(conOneEnum, false),
+        makeCapInfo<CapType::IBarCodeDetectionEnabled>(conOneEnum, false),
+        makeCapInfo<CapType::ISupportedBarCodeTypes>(conArray, true),
+        makeCapInfo<CapType::IBarCodeMaxSearchPriorities>(conOneEnumRange, true),
+        makeCapInfo<CapType::IBarCodeSearchPriorities>(conArray, false),
+        makeCapInfo<CapType::IBarCodeSearchMode>(conOneEnum, false),
+        makeCapInfo<CapType::IBarCodeMaxRetries>(conOneEnumRange, false),
+        makeCapInfo<CapType::IBarCodeTimeOut>(conOneEnumRange, false),
+        makeCapInfo<CapType::IZoomFactor>(conOneEnumRange, false),
+        makeCapInfo<CapType::IPatchCodeDetectionEnabled>(conOneEnum, false),
+        makeCapInfo<CapType::ISupportedPatchCodeTypes>(conArray, true),
+        makeCapInfo<CapType::IPatchCodeMaxSearchPriorities>(conOneEnumRange, true),
+        makeCapInfo<CapType::IPatchCodeSearchPriorities>(conArray, false),
+        makeCapInfo<CapType::IPatchCodeSearchMode>(conOneEnum, false),
+        makeCapInfo<CapType::IPatchCodeMaxRetries>(conOneEnumRange, false),
+        makeCapInfo<CapType::IPatchCodeTimeOut>(conOneEnumRange, false),
+        makeCapInfo<CapType::IFlashUsed2>(conOneEnum, false),
+        makeCapInfo<CapType::IImageFilter>(conOneEnumArray, false),
+        makeCapInfo<CapType::INoiseFilter>(conOneEnumArray, false),
+        makeCapInfo<CapType::IOverScan>(conOneEnum, false),
+        makeCapInfo<CapType::IAutomaticBorderDetection>(conOneEnum, false),
+        makeCapInfo<CapType::IAutomaticDeskew>(conOneEnum, false),
+        makeCapInfo<CapType::IAutomaticRotate>(conOneEnum, false),
+        makeCapInfo<CapType::IJpegQuality>(conOneEnumRange, false),
+        makeCapInfo<CapType::IFeederType>(conOneEnum, false),
+        makeCapInfo<CapType::IIccProfile>(conOneEnum, false),
+        makeCapInfo<CapType::IAutoSize>(conOneEnum, false),
+        makeCapInfo<CapType::IAutomaticCropUsesFrame>(conOne, true),
+        makeCapInfo<CapType::IAutomaticLengthDetection>(conOneEnum, false),
+        makeCapInfo<CapType::IAutomaticColorEnabled>(conOneEnum, false),
+        makeCapInfo<CapType::IAutomaticColorNonColorPixelType>(conOneEnum, false),
+        makeCapInfo<CapType::IColorManagementEnabled>(conOneEnum, false),
+        makeCapInfo<CapType::IImageMerge>(conOneEnum, false),
+        makeCapInfo<CapType::IImageMergeHeightThreshold>(conOneEnumRange, false),
+        makeCapInfo<CapType::ISupportedExtImageInfo>(conArray, true),
+        makeCapInfo<CapType::IFilmType>(conOneEnum, false),
+        makeCapInfo<CapType::IMirror>(conOneEnum, false),
+        makeCapInfo<CapType::IJpegSubSampling>(conOneEnum, false),
+        makeCapInfo<CapType::AXferMech>(conOneEnum, false)
+    };
+
+    static constexpr const std::size_t size = sizeof(table) / sizeof(table[0]);
+};
+
+template<typename Dummy>
+constexpr const CapInfo CapInfoTable<Dummy>::table[];
+
+static_assert(capInfoSorted(CapInfoTable<void>::table, CapInfoTable<void>::size),
+              "capability descriptions must be sorted by capability type");
+
+// entries take their item type from `Cap`, so a sorted table of unique entries
+// as long as the standard capabilities in `Cap` describes every one of them
+static_assert(CapCount<0x0000, 0x0200>::value + CapCount<0x1000, 0x1300>::value == CapInfoTable<void>::size,
+              "every capability in `Cap` must be described");
+
+}
+
+/// Description of a standard capability.
+/// Binary search over a constant table, no allocation nor locking.
+/// \return Description of the capability, invalid one for custom and unknown capabilities.
+static inline const CapInfo& capInfo(CapType cap) noexcept{
+    static constexpr const CapInfo invalid;
+
+    typedef Detail::CapInfoTable<void> Table;
+    auto end = Table::table + Table::size;
+    auto it = std::lower_bound(Table::table, end, cap, [](const CapInfo& info, CapType cap){
+        return info.cap() < cap;
+    });
+
+    return it != end && it->cap() == cap ? *it : invalid;
+}
+
+/// Checks a MSG_SET request against the description of its capability.
+/// Custom and unknown capabilities are not checked.
+/// \return {CapBadOperation if the capability is read-only,
+///          BadValue if it does not allow the container, Success otherwise.}
+static inline ConditionCode capSetCondition(const Capability& data) noexcept{
+    const auto& info = capInfo(data.type());
+    if (!info.isValid()){
+        return ConditionCode::Success;
+    }
+
+    if (info.readOnly()){
+        return ConditionCode::CapBadOperation;
+    }
+
+    return info.allows(data.container()) ? ConditionCode::Success : ConditionCode::BadValue;
+}
+
+}
+
+#endif // TWPP_DETAIL_FILE_CAPINFO_HPP
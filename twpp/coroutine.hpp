@@ -0,0 +1,322 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2015-2020 Martin Richter
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#ifndef TWPP_DETAIL_FILE_COROUTINE_HPP
+#define TWPP_DETAIL_FILE_COROUTINE_HPP
+
+#include "../twpp.hpp"
+
+#if defined(TWPP_DETAIL_COROUTINES)
+
+namespace Twpp {
+
+/// Fire-and-forget coroutine return type.
+/// The coroutine starts immediately, and destroys itself when finished.
+/// Exceptions escaping the coroutine call std::terminate.
+struct AsyncTask {
+
+    struct promise_type {
+        AsyncTask get_return_object() noexcept{
+            return {};
+        }
+
+        std::suspend_never initial_suspend() noexcept{
+            return {};
+        }
+
+        std::suspend_never final_suspend() noexcept{
+            return {};
+        }
+
+        void return_void() noexcept{}
+
+        void unhandled_exception() noexcept{
+            std::terminate();
+        }
+    };
+
+};
+
+/// Coroutine interface of an enabled source.
+///
+/// The source is driven by awaiting `nextPage`, followed by `readStrip` (memory transfer)
+/// or `readNative` (native transfer), until `nextPage` returns EndOfList:
+///
+///     AsyncTask acquire(AsyncSource& src){
+///         ImageInfo info;
+///         while (success(co_await src.nextPage(info))){
+///             ImageMemXfer strip = ...;
+///             for (;;){
+///                 auto rc = co_await src.readStrip(strip);
+///                 if (rc != ReturnCode::Success && rc != ReturnCode::XferDone){
+///                     break;
+///                 }
+///
+///                 ... // the last strip comes with XferDone
+///                 if (rc == ReturnCode::XferDone){
+///                     break;
+///                 }
+///             }
+///         }
+///     }
+///
+/// Waiting for the source does not block any thread, the coroutine is suspended
+/// until the source notifies the application through the TWAIN callback,
+/// see `Source::setReadyCallBack`. The coroutine is then resumed by the executor,
+/// a function that runs the passed function object, e.g. posts it to an event loop.
+/// DSM calls of `readStrip` and `readNative` are made from the executor as well.
+/// TWAIN operations must be done from a single thread, so the executor should run
+/// everything in the thread that opened the source.
+///
+/// Requires the source to use callbacks (DSM2), see `Manager::open`.
+/// On Windows and Mac OS, the executor thread must keep processing GUI events.
+/// TWPP allows only a single open source, hence only a single AsyncSource at a time.
+class AsyncSource {
+
+public:
+    typedef std::function<void(std::function<void()>)> Executor;
+
+    /// Result of an awaited operation, converts to ReturnCode.
+    class Awaitable;
+
+    /// Creates coroutine interface of the source, using the executor to resume coroutines.
+    /// Replaces the ready callback of the source.
+    /// Must be created before the source is enabled, and must not outlive the source.
+    AsyncSource(Source& src, Executor exec) :
+        m_src(src), m_waiter(std::make_shared<Waiter>()){
+
+        m_waiter->m_exec = std::move(exec);
+
+        auto waiter = m_waiter;
+        m_src.setReadyCallBack([waiter](){
+            waiter->notify();
+        });
+    }
+
+    ~AsyncSource(){
+        m_src.setReadyCallBack(nullptr);
+    }
+
+    AsyncSource(const AsyncSource&) = delete;
+    AsyncSource& operator=(const AsyncSource&) = delete;
+
+    /// The source.
+    Source& source() noexcept{
+        return m_src;
+    }
+
+    /// Waits until the source posts a message, must be in Enabled state.
+    /// \return {Failure on error, Cancel on CANCEL button, Success on SAVE or SCAN button,
+    ///          CheckStatus on device event.}
+    Awaitable ready() noexcept;
+
+    /// Moves to the next page, and obtains information about its image.
+    ///
+    /// In Enabled state, waits until the source is ready to transfer the first page.
+    /// In Xferring state, ends the current transfer, and moves to the next pending page.
+    /// \param info Information about the next page.
+    /// \return {Success if the next page is ready (XferReady state),
+    ///          EndOfList if there are no more pages (Enabled state),
+    ///          Cancel on CANCEL button, CheckStatus on device event, Failure on error.}
+    Awaitable nextPage(ImageInfo& info) noexcept;
+
+    /// Transfers a single strip of the current page, must be in XferReady or Xferring state.
+    /// The DSM call is made from the executor.
+    /// \param strip Memory transfer, e.g. obtained by `MemXferRing::acquire`.
+    /// \return {Success if more strips follow, XferDone after the last one, Cancel, Failure.}
+    Awaitable readStrip(ImageMemXfer& strip) noexcept;
+
+    /// Transfers the current page as a native image, must be in XferReady state.
+    /// The DSM call is made from the executor.
+    /// \return {XferDone on success, Cancel, Failure.}
+    Awaitable readNative(ImageNativeXfer& out) noexcept;
+
+private:
+    enum class Op {
+        Ready,
+        NextPage,
+        Strip,
+        Native
+    };
+
+    struct Waiter {
+        void notify(){
+            std::unique_lock<std::mutex> lock(m_mutex);
+            auto handle = m_handle;
+            m_handle = nullptr;
+            lock.unlock();
+
+            if (handle){
+                m_exec([handle](){
+                    handle.resume();
+                });
+            }
+        }
+
+        Executor m_exec;
+        std::mutex m_mutex;
+        std::coroutine_handle<> m_handle;
+    };
+
+    Source& m_src;
+    std::shared_ptr<Waiter> m_waiter;
+
+};
+
+class AsyncSource::Awaitable {
+
+public:
+    bool await_ready(){
+        switch (m_op){
+            case Op::Ready:
+                return false;
+
+            case Op::NextPage:
+                switch (m_src->m_src.state()){
+                    case DsState::Enabled:
+                        return false;
+
+                    case DsState::XferReady:
+                        m_rc = m_src->m_src.imageInfo(*m_info);
+                        return true;
+
+                    case DsState::Xferring: {
+                        PendingXfers xfers;
+                        m_rc = m_src->m_src.pendingXfers(Msg::EndXfer, xfers);
+                        if (success(m_rc)){
+                            m_rc = m_src->m_src.state() == DsState::XferReady ?
+                                        m_src->m_src.imageInfo(*m_info) : ReturnCode::EndOfList;
+                        }
+
+                        return true;
+                    }
+
+                    default:
+                        m_rc = ReturnCode::Failure;
+                        return true;
+                }
+
+            default:
+                return false;
+        }
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle){
+        switch (m_op){
+            case Op::Ready:
+            case Op::NextPage: {
+                // the source sets its message before notifying the waiter,
+                // polling under the lock can not miss the notification
+                auto& waiter = *m_src->m_waiter;
+                std::lock_guard<std::mutex> lock(waiter.m_mutex);
+                m_waited = true;
+                m_rc = m_src->m_src.pollReady();
+                if (m_rc != ReturnCode::NotDsEvent){
+                    return false;
+                }
+
+                waiter.m_handle = handle;
+                return true;
+            }
+
+            case Op::Strip:
+            case Op::Native: {
+                auto self = this;
+                m_src->m_waiter->m_exec([self, handle](){
+                    auto& src = self->m_src->m_src;
+                    self->m_rc = self->m_op == Op::Strip ?
+                                src.imageMemXfer(*self->m_strip) :
+                                src.imageNativeXfer(*self->m_native);
+
+                    handle.resume();
+                });
+
+                return true;
+            }
+
+            default:
+                return false;
+        }
+    }
+
+    ReturnCode await_resume(){
+        if (m_waited){ // otherwise the result, and image info, come from await_ready
+            if (m_rc == ReturnCode::NotDsEvent){ // notified, the message is available now
+                m_rc = m_src->m_src.pollReady();
+            }
+
+            if (m_op == Op::NextPage && success(m_rc) && m_src->m_src.state() == DsState::XferReady){
+                m_rc = m_src->m_src.imageInfo(*m_info);
+            }
+        }
+
+        return m_rc;
+    }
+
+private:
+    friend class AsyncSource;
+
+    Awaitable(AsyncSource* src, Op op) noexcept :
+        m_src(src), m_op(op), m_rc(ReturnCode::NotDsEvent), m_waited(false),
+        m_info(nullptr), m_strip(nullptr), m_native(nullptr){}
+
+    AsyncSource* m_src;
+    Op m_op;
+    ReturnCode m_rc;
+    bool m_waited;
+    ImageInfo* m_info;
+    ImageMemXfer* m_strip;
+    ImageNativeXfer* m_native;
+
+};
+
+inline AsyncSource::Awaitable AsyncSource::ready() noexcept{
+    return Awaitable(this, Op::Ready);
+}
+
+inline AsyncSource::Awaitable AsyncSource::nextPage(ImageInfo& info) noexcept{
+    Awaitable a(this, Op::NextPage);
+    a.m_info = &info;
+    return a;
+}
+
+inline AsyncSource::Awaitable AsyncSource::readStrip(ImageMemXfer& strip) noexcept{
+    Awaitable a(this, Op::Strip);
+    a.m_strip = &strip;
+    return a;
+}
+
+inline AsyncSource::Awaitable AsyncSource::readNative(ImageNativeXfer& out) noexcept{
+    Awaitable a(this, Op::Native);
+    a.m_native = &out;
+    return a;
+}
+
+}
+
+#endif // TWPP_DETAIL_COROUTINES
+
+#endif // TWPP_DETAIL_FILE_COROUTINE_HPP
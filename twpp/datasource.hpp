@@ -272,7 +272,7 @@ protected:
     /// 设置当前的 TWAIN 状态，小心使用。
     void setState(DsState state) noexcept {
         m_state = state;
-        qDebug()<<UINT16(m_state);
+        qDebug()<<static_cast<UInt16>(m_state);
     }
 
     /// Sets current source identity, use with care.
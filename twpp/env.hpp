@@ -288,6 +288,8 @@ static void postDummy() noexcept{
 extern "C" {
 #   include <dlfcn.h>
 #   include <endian.h>
+#   include <sys/eventfd.h>
+#   include <unistd.h>
 }
 #   if __BYTE_ORDER == __LITTLE_ENDIAN
 #       define TWPP_DETAIL_ENDIAN_LITTLE
@@ -33,12 +33,10 @@ namespace Twpp {
 
 namespace Detail {
 
+/// Packed fixed point value of a float, rounded to nearest, halves away from zero.
+/// The rounding offset is selected arithmetically, so that loops over floats vectorize.
 static constexpr inline Int32 floatToValue(float val){
-    return static_cast<Int32>(
-        (val >= 0.0f) ?
-        (val * 65536.0f + 0.5f) :
-        (val * 65536.0f - 0.5f)
-    );
+    return static_cast<Int32>(val * 65536.0f + (0.5f - static_cast<float>(val < 0.0f)));
 }
 
 static constexpr inline Int16 floatToWhole(float val){
@@ -54,6 +52,9 @@ static constexpr inline UInt16 floatToFrac(float val){
 TWPP_DETAIL_PACK_BEGIN
 /// TWAIN fixed point fractional type.
 /// The fractional part has resolution of 1/65536.
+///
+/// Comparisons and arithmetic work on the packed value, see `raw`.
+/// Results out of the representable range wrap around.
 class Fix32 {
 
 public:
@@ -70,6 +71,11 @@ public:
     constexpr Fix32(Int16 whole, UInt16 frac) noexcept :
         m_whole(whole), m_frac(frac){}
 
+    /// Creates fixed type from its packed value, see `raw`.
+    static constexpr Fix32 fromRaw(Int32 raw) noexcept{
+        return Fix32(static_cast<Int16>(raw >> 16), static_cast<UInt16>(raw & 0xFFFF));
+    }
+
 
     /// Whole part of this fixed type.
     constexpr Int16 whole() const noexcept{
@@ -93,16 +99,22 @@ public:
         m_frac = frac;
     }
 
+    /// Packed value of this fixed type, the number of 1/65536 units.
+    /// Unlike whole and fractional parts, it can be compared and added directly.
+    constexpr Int32 raw() const noexcept{
+        return static_cast<Int32>(m_whole) * 65536 + m_frac;
+    }
+
     explicit constexpr operator float() const noexcept{
         return toFloat();
     }
 
     constexpr float toFloat() const noexcept{
-        return m_whole + m_frac / 65536.0f;
+        return static_cast<float>(raw()) * (1.0f / 65536.0f);
     }
 
     constexpr Fix32 operator-() const noexcept{
-        return -toFloat();
+        return fromRaw(static_cast<Int32>(-static_cast<std::int64_t>(raw())));
     }
 
 private:
@@ -114,54 +126,62 @@ TWPP_DETAIL_PACK_END
 
 namespace Detail {
 
-static inline constexpr Fix32 fix32AddHelper(Int32 frac, Int16 whole){
-    return frac < 65536 ? Fix32(whole, frac) : Fix32(whole + 1, frac - 65536);
+/// Fixed type from a packed value computed in 64 bits, wraps around like Int32.
+static inline constexpr Fix32 fix32Wrap(std::int64_t raw) noexcept{
+    return Fix32::fromRaw(static_cast<Int32>(raw));
 }
 
-static inline constexpr Fix32 fix32SubHelper(Int32 frac, Int16 whole){
-    return frac >= 0 ? Fix32(whole, frac) : Fix32(whole - 1, frac + 65536);
+/// Division rounded to nearest, halves away from zero.
+static inline constexpr std::int64_t divRound(std::int64_t num, std::int64_t den) noexcept{
+    return ((num < 0) == (den < 0) ? num + den / 2 : num - den / 2) / den;
 }
 
 }
 
 static inline constexpr bool operator>(Fix32 a, Fix32 b) noexcept{
-    return a.whole() > b.whole() || (a.whole() == b.whole() && a.frac() > b.frac());
+    return a.raw() > b.raw();
 }
 
 static inline constexpr bool operator<(Fix32 a, Fix32 b) noexcept{
-    return a.whole() < b.whole() || (a.whole() == b.whole() && a.frac() < b.frac());
+    return a.raw() < b.raw();
 }
 
 static inline constexpr bool operator>=(Fix32 a, Fix32 b) noexcept{
-    return !(a < b);
+    return a.raw() >= b.raw();
 }
 
 static inline constexpr bool operator<=(Fix32 a, Fix32 b) noexcept{
-    return !(a > b);
+    return a.raw() <= b.raw();
 }
 
 static inline constexpr bool operator==(Fix32 a, Fix32 b) noexcept{
-    return a.whole() == b.whole() && a.frac() == b.frac();
+    return a.raw() == b.raw();
 }
 
 static inline constexpr bool operator!=(Fix32 a, Fix32 b) noexcept{
-    return !(a == b);
+    return a.raw() != b.raw();
 }
 
 static inline constexpr Fix32 operator+(Fix32 a, Fix32 b) noexcept{
-    return Detail::fix32AddHelper(static_cast<Int32>(a.frac()) + b.frac(), a.whole() + b.whole());
+    return Detail::fix32Wrap(static_cast<std::int64_t>(a.raw()) + b.raw());
 }
 
 static inline constexpr Fix32 operator-(Fix32 a, Fix32 b) noexcept{
-    return Detail::fix32SubHelper(static_cast<Int32>(a.frac()) - b.frac(), a.whole() - b.whole());
+    return Detail::fix32Wrap(static_cast<std::int64_t>(a.raw()) - b.raw());
 }
 
+/// Exact product rounded to 1/65536.
 static inline constexpr Fix32 operator*(Fix32 a, Fix32 b) noexcept{
-    return Fix32(static_cast<float>(a) * static_cast<float>(b));
+    return Detail::fix32Wrap(Detail::divRound(static_cast<std::int64_t>(a.raw()) * b.raw(), 65536));
 }
 
-static inline constexpr Fix32 operator/(Fix32 a, Fix32 b) noexcept{ // wonder about zero b
-    return Fix32(static_cast<float>(a) / static_cast<float>(b));
+/// Exact quotient rounded to 1/65536.
+/// Division by zero saturates to the largest or the smallest value, by the sign of `a`.
+static inline constexpr Fix32 operator/(Fix32 a, Fix32 b) noexcept{
+    return b.raw() == 0 ?
+                (a.raw() < 0 ? Fix32::fromRaw(std::numeric_limits<Int32>::min()) :
+                               Fix32::fromRaw(std::numeric_limits<Int32>::max())) :
+                Detail::fix32Wrap(Detail::divRound(static_cast<std::int64_t>(a.raw()) * 65536, b.raw()));
 }
 
 static inline Fix32& operator+=(Fix32& a, Fix32 b) noexcept{
@@ -176,10 +196,27 @@ static inline Fix32& operator*=(Fix32& a, Fix32 b) noexcept{
     return a = a * b;
 }
 
-static inline Fix32& operator/=(Fix32& a, Fix32 b) noexcept{ // wonder about zero b
+static inline Fix32& operator/=(Fix32& a, Fix32 b) noexcept{
     return a = a / b;
 }
 
+/// Converts `count` fixed point values to floats.
+/// The loop has no branches and no calls, so that compilers vectorize it.
+static inline void fix32ToFloat(const Fix32* in, std::size_t count, float* out) noexcept{
+    for (std::size_t i = 0; i < count; i++){
+        out[i] = in[i].toFloat();
+    }
+}
+
+/// Converts `count` floats to fixed point values, rounded to nearest.
+/// The values must lie within the range of Fix32.
+/// Vectorized by compilers like `fix32ToFloat`.
+static inline void floatToFix32(const float* in, std::size_t count, Fix32* out) noexcept{
+    for (std::size_t i = 0; i < count; i++){
+        out[i] = Fix32::fromRaw(Detail::floatToValue(in[i]));
+    }
+}
+
 namespace Literals {
 
 static inline constexpr Fix32 operator "" _fix(long double val) noexcept{
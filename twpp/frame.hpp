@@ -83,6 +83,16 @@ public:
         m_bottom = bottom;
     }
 
+    /// Width of the image frame, computed exactly in fixed point.
+    constexpr Fix32 width() const noexcept{
+        return m_right - m_left;
+    }
+
+    /// Height of the image frame, computed exactly in fixed point.
+    constexpr Fix32 height() const noexcept{
+        return m_bottom - m_top;
+    }
+
 private:
     Fix32 m_left;
     Fix32 m_top;
@@ -0,0 +1,478 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2015-2020 Martin Richter
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#ifndef TWPP_DETAIL_FILE_LOOPBACK_HPP
+#define TWPP_DETAIL_FILE_LOOPBACK_HPP
+
+#include "../twpp.hpp"
+
+namespace Twpp {
+
+/// In-process data source manager.
+/// Routes calls between an application (`Manager` and `Source`) and data sources
+/// linked into the same process, without loading any TWAIN DSM library.
+/// Meant for headless testing and benchmarking of application-source transfer loops.
+///
+/// The application and the data sources must be compiled in different translation units,
+/// one with TWPP_IS_DS defined, the other without it:
+///
+///     // ds.cpp, TWPP_IS_DS
+///     TWPP_ENTRY(MySource)
+///
+///     // app.cpp
+///     extern "C" ReturnCode TWPP_DETAIL_CALLSTYLE DS_Entry(Identity*, DataGroup, Dat, Msg, void*);
+///
+///     LoopbackDsm::addSource(DS_Entry);
+///     Manager mgr(appIdentity);
+///     mgr.load(LoopbackDsm::entry());
+///     mgr.open();
+///
+/// The manager supports a single open application, each source may be opened once.
+/// Memory functions are provided through DAT_ENTRYPOINT to both sides,
+/// callbacks registered by DAT_CALLBACK2 or DAT_CALLBACK receive the messages of the source.
+/// There is no source-selection dialog, MSG_USERSELECT returns the default source.
+class LoopbackDsm {
+
+public:
+    /// Entry of a data source, `DS_Entry` created by TWPP_ENTRY, or `SourceFromThis::entry`.
+    typedef ReturnCode (TWPP_DETAIL_CALLSTYLE* DsEntry)(
+            Identity* origin,
+            DataGroup dg,
+            Dat dat,
+            Msg msg,
+            void* data
+    );
+
+    /// Registers a data source, the first one becomes the default source.
+    /// The identity of the source is obtained immediately.
+    /// \param entry Entry of the source.
+    /// \param ident Optional output, identity of the source as listed by the manager.
+    /// \return Whether the source was registered.
+    /// \throw std::bad_alloc
+    static bool addSource(DsEntry entry, Identity* ident = nullptr){
+        if (!entry){
+            return false;
+        }
+
+        Identity id;
+        if (!success(entry(nullptr, DataGroup::Control, Dat::Identity, Msg::Get, &id))){
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(Static<void>::g_mutex);
+        auto& d = Static<void>::g_data;
+        d.m_sources.push_back(SourceRec(entry, withId(id, nextId(d), id.dataGroupsRaw())));
+        if (ident){
+            *ident = d.m_sources.back().m_ident;
+        }
+
+        return true;
+    }
+
+    /// Removes all registered sources, none of them may be open.
+    /// \return Whether the sources were removed.
+    static bool clear(){
+        std::lock_guard<std::mutex> lock(Static<void>::g_mutex);
+        auto& d = Static<void>::g_data;
+        for (auto& src : d.m_sources){
+            if (src.m_open){
+                return false;
+            }
+        }
+
+        d.m_sources.clear();
+        d.m_default = 0;
+        return true;
+    }
+
+    /// DSM entry to be passed to `Manager::load`.
+    static Detail::DsmEntry entry() noexcept{
+        return dsmEntry;
+    }
+
+private:
+    struct SourceRec {
+        SourceRec(DsEntry entry, const Identity& ident) noexcept :
+            m_entry(entry), m_ident(ident), m_open(false), m_cb(nullptr){}
+
+        DsEntry m_entry;
+        Identity m_ident;
+        bool m_open;
+        Detail::CallBackFunc m_cb;
+    };
+
+    struct Data {
+        Data() noexcept :
+            m_open(false), m_lastId(0), m_default(0), m_next(0){}
+
+        bool m_open;
+        Identity m_app;
+        Identity::Id m_lastId;
+        Status m_status;
+        std::vector<SourceRec> m_sources;
+        std::size_t m_default;
+        std::size_t m_next;
+    };
+
+    // header-only, yet we need static variables
+    // templates behave as if defined in at most one source file
+    template<typename>
+    struct Static {
+        static Data g_data;
+        static std::mutex g_mutex;
+    };
+
+    static Identity::Id nextId(Data& d) noexcept{
+        return ++d.m_lastId;
+    }
+
+    static Identity withId(const Identity& id, Identity::Id newId, UInt32 groups) noexcept{
+        return Identity(newId, id.version(), id.protocolMajor(), id.protocolMinor(),
+                        groups, id.manufacturer(), id.productFamily(), id.productName());
+    }
+
+    static Handle::Raw TWPP_DETAIL_CALLSTYLE memAlloc(UInt32 size){
+        return static_cast<Handle::Raw>(std::calloc(size, 1));
+    }
+
+    static void TWPP_DETAIL_CALLSTYLE memFree(Handle::Raw handle){
+        std::free(handle);
+    }
+
+    static void* TWPP_DETAIL_CALLSTYLE memLock(Handle::Raw handle){
+        return handle;
+    }
+
+    static void TWPP_DETAIL_CALLSTYLE memUnlock(Handle::Raw){
+        // noop
+    }
+
+    static Detail::EntryPoint entryPoint() noexcept{
+        Detail::EntryPoint e;
+        e.m_entry = dsmEntry;
+        e.m_alloc = memAlloc;
+        e.m_free = memFree;
+        e.m_lock = memLock;
+        e.m_unlock = memUnlock;
+        return e;
+    }
+
+    static SourceRec* findSource(Data& d, const Identity* ident) noexcept{
+        if (ident){
+            for (auto& src : d.m_sources){
+                if (src.m_ident.id() == ident->id()){
+                    return &src;
+                }
+            }
+        }
+
+        return nullptr;
+    }
+
+    static ReturnCode fail(Data& d, CC cc) noexcept{
+        d.m_status = cc;
+        return ReturnCode::Failure;
+    }
+
+    static ReturnCode done(Data& d, ReturnCode rc = ReturnCode::Success) noexcept{
+        d.m_status = CC::Success;
+        return rc;
+    }
+
+    /// Condition of a failed source operation as reported by the source, Bummer if it reports none.
+    /// Must be called without holding the lock, the source may call back.
+    static CC sourceCondition(DsEntry entry, Identity* app) noexcept{
+        Status status;
+        if (success(entry(app, DataGroup::Control, Dat::Status, Msg::Get, &status)) &&
+                status.condition() != CC::Success){
+            return status.condition();
+        }
+
+        return CC::Bummer;
+    }
+
+    static ReturnCode TWPP_DETAIL_CALLSTYLE dsmEntry(
+            Identity* origin,
+            Identity* dest,
+            DataGroup dg,
+            Dat dat,
+            Msg msg,
+            void* data
+    ) noexcept{
+        std::unique_lock<std::mutex> lock(Static<void>::g_mutex);
+        auto& d = Static<void>::g_data;
+
+        if (!origin){
+            return fail(d, CC::BadProtocol);
+        }
+
+        // source -> application, only DAT_NULL messages
+        auto fromSrc = findSource(d, origin);
+        if (fromSrc && d.m_open && dest && dest->id() == d.m_app.id()){
+            if (dg != DataGroup::Control || dat != Dat::Null || !fromSrc->m_open){
+                return fail(d, CC::BadProtocol);
+            }
+
+            auto cb = fromSrc->m_cb;
+            if (!cb){
+                return fail(d, CC::OperationError);
+            }
+
+            lock.unlock();
+            return cb(origin, dest, dg, dat, msg, data);
+        }
+
+        if (dest){
+            return toSource(lock, d, origin, dest, dg, dat, msg, data);
+        }
+
+        if (dg != DataGroup::Control){
+            return fail(d, CC::BadProtocol);
+        }
+
+        switch (dat){
+            case Dat::Parent:
+                return parent(d, *origin, msg);
+
+            case Dat::EntryPoint:
+                if (msg != Msg::Get || !data){
+                    return fail(d, CC::BadProtocol);
+                }
+
+                if (!d.m_open || origin->id() != d.m_app.id()){
+                    return fail(d, CC::SeqError);
+                }
+
+                *static_cast<Detail::EntryPoint*>(data) = entryPoint();
+                return done(d);
+
+            case Dat::Status:
+                if (msg != Msg::Get || !data){
+                    return fail(d, CC::BadProtocol);
+                }
+
+                *static_cast<Status*>(data) = d.m_status;
+                d.m_status = CC::Success;
+                return ReturnCode::Success;
+
+            case Dat::Identity:
+                if (!data){
+                    return fail(d, CC::BadValue);
+                }
+
+                if (!d.m_open || origin->id() != d.m_app.id()){
+                    return fail(d, CC::SeqError);
+                }
+
+                return identity(lock, d, origin, msg, *static_cast<Identity*>(data));
+
+            default:
+                return fail(d, CC::BadProtocol);
+        }
+    }
+
+    static ReturnCode parent(Data& d, Identity& app, Msg msg) noexcept{
+        switch (msg){
+            case Msg::OpenDsm:
+                if (d.m_open){
+                    return fail(d, CC::MaxConnections);
+                }
+
+                app = withId(app, nextId(d), app.dataGroupsRaw() | Detail::Dsm2);
+                d.m_app = app;
+                d.m_open = true;
+                d.m_next = 0;
+                return done(d);
+
+            case Msg::CloseDsm:
+                if (!d.m_open || app.id() != d.m_app.id()){
+                    return fail(d, CC::SeqError);
+                }
+
+                for (auto& src : d.m_sources){
+                    if (src.m_open){
+                        return fail(d, CC::SeqError);
+                    }
+                }
+
+                d.m_open = false;
+                return done(d);
+
+            default:
+                return fail(d, CC::BadProtocol);
+        }
+    }
+
+    static ReturnCode identity(std::unique_lock<std::mutex>& lock, Data& d, Identity* app,
+                               Msg msg, Identity& ident) noexcept{
+        switch (msg){
+            case Msg::GetFirst:
+                d.m_next = 0;
+                // fallthrough
+            case Msg::GetNext:
+                if (d.m_next >= d.m_sources.size()){
+                    return done(d, ReturnCode::EndOfList);
+                }
+
+                ident = d.m_sources[d.m_next++].m_ident;
+                return done(d);
+
+            case Msg::GetDefault:
+            case Msg::UserSelect:
+                if (d.m_sources.empty()){
+                    return fail(d, CC::NoDs);
+                }
+
+                ident = d.m_sources[d.m_default].m_ident;
+                return done(d);
+
+            case Msg::Set: {
+                auto src = findSource(d, &ident);
+                if (!src){
+                    return fail(d, CC::NoDs);
+                }
+
+                d.m_default = static_cast<std::size_t>(src - d.m_sources.data());
+                return done(d);
+            }
+
+            case Msg::OpenDs: {
+                SourceRec* src = nullptr;
+                if (ident.id() != 0){
+                    src = findSource(d, &ident);
+                } else if (ident.productName().size() == 0){
+                    src = d.m_sources.empty() ? nullptr : &d.m_sources[d.m_default];
+                } else {
+                    for (auto& s : d.m_sources){
+                        if (s.m_ident.productName() == ident.productName()){
+                            src = &s;
+                            break;
+                        }
+                    }
+                }
+
+                if (!src){
+                    return fail(d, CC::NoDs);
+                }
+
+                if (src->m_open){
+                    return fail(d, CC::MaxConnections);
+                }
+
+                ident = src->m_ident;
+                auto entry = src->m_entry;
+                auto e = entryPoint();
+
+                // the source may call back while being opened
+                lock.unlock();
+                auto rc = entry(app, DataGroup::Control, Dat::EntryPoint, Msg::Set, &e);
+                if (success(rc)){
+                    rc = entry(app, DataGroup::Control, Dat::Identity, Msg::OpenDs, &ident);
+                }
+
+                auto cc = success(rc) ? CC::Success : sourceCondition(entry, app);
+                lock.lock();
+                if (success(rc)){
+                    src = findSource(d, &ident);
+                    if (src){
+                        src->m_open = true;
+                        src->m_cb = nullptr;
+                    }
+                }
+
+                d.m_status = cc;
+                return rc;
+            }
+
+            case Msg::CloseDs: {
+                auto src = findSource(d, &ident);
+                if (!src || !src->m_open){
+                    return fail(d, CC::NoDs);
+                }
+
+                auto entry = src->m_entry;
+                lock.unlock();
+                auto rc = entry(app, DataGroup::Control, Dat::Identity, Msg::CloseDs, &ident);
+                auto cc = success(rc) ? CC::Success : sourceCondition(entry, app);
+                lock.lock();
+
+                if (success(rc)){
+                    src = findSource(d, &ident);
+                    if (src){
+                        src->m_open = false;
+                        src->m_cb = nullptr;
+                    }
+                }
+
+                d.m_status = cc;
+                return rc;
+            }
+
+            default:
+                return fail(d, CC::BadProtocol);
+        }
+    }
+
+    static ReturnCode toSource(std::unique_lock<std::mutex>& lock, Data& d, Identity* origin,
+                               Identity* dest, DataGroup dg, Dat dat, Msg msg, void* data) noexcept{
+        if (!d.m_open || origin->id() != d.m_app.id()){
+            return fail(d, CC::SeqError);
+        }
+
+        auto src = findSource(d, dest);
+        if (!src || !src->m_open){
+            return fail(d, CC::BadDest);
+        }
+
+        if (dg == DataGroup::Control && (dat == Dat::Callback || dat == Dat::Callback2)){
+            if (msg != Msg::RegisterCallback || !data){
+                return fail(d, CC::BadProtocol);
+            }
+
+            src->m_cb = dat == Dat::Callback2 ?
+                        static_cast<Detail::CallBack2*>(data)->m_func :
+                        static_cast<Detail::CallBack*>(data)->m_func;
+
+            return done(d);
+        }
+
+        // the source may call back from within the call
+        auto entry = src->m_entry;
+        lock.unlock();
+        return entry(origin, dg, dat, msg, data);
+    }
+
+};
+
+template<typename Dummy>
+LoopbackDsm::Data LoopbackDsm::Static<Dummy>::g_data;
+
+template<typename Dummy>
+std::mutex LoopbackDsm::Static<Dummy>::g_mutex;
+
+}
+
+#endif // TWPP_DETAIL_FILE_LOOPBACK_HPP
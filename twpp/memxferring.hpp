@@ -0,0 +1,215 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2015-2020 Martin Richter
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#ifndef TWPP_DETAIL_FILE_MEMXFERRING_HPP
+#define TWPP_DETAIL_FILE_MEMXFERRING_HPP
+
+#include "../twpp.hpp"
+
+namespace Twpp {
+
+namespace Detail {
+
+/// TWON_DONTCARE32, used to initialize memory transfer fields set by the source.
+static constexpr const UInt32 dontCare32 = 0xFFFFFFFF;
+
+}
+
+/// Fixed set of equally sized memory blocks for memory transfers.
+/// The blocks are allocated once, then rotated between the source and consumers:
+/// `acquire` lends a free block wrapped in ImageMemXfer, ready to be passed
+/// to `Source::imageMemXfer`; the filled transfer is moved to a consumer,
+/// which returns the block by `release` once done with it.
+/// No memory is allocated per strip, and the source may fill one block
+/// while consumers still process the others.
+///
+/// `acquire` and `release` may be called from different threads.
+class MemXferRing {
+
+public:
+    /// Creates an empty ring without any blocks.
+    MemXferRing() noexcept :
+        m_blockSize(0), m_count(0), m_closed(false){}
+
+    /// Creates a ring of `count` blocks, `blockSize` bytes each.
+    /// \throw std::bad_alloc
+    MemXferRing(UInt32 count, UInt32 blockSize) :
+        MemXferRing(){
+
+        allocate(count, blockSize);
+    }
+
+    MemXferRing(const MemXferRing&) = delete;
+    MemXferRing& operator=(const MemXferRing&) = delete;
+
+    /// Makes the ring hold `count` free blocks of `blockSize` bytes.
+    /// Blocks of matching size are kept, so calling this once per transfer session
+    /// allocates only when the preferred size changes.
+    /// Blocks lent out at the time of the call are forgotten, releasing them later frees them.
+    /// \throw std::bad_alloc
+    void allocate(UInt32 count, UInt32 blockSize){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = false;
+
+        if (blockSize != m_blockSize){
+            m_free.clear();
+            m_blockSize = blockSize;
+        }
+
+        if (m_free.size() > count){
+            m_free.resize(count);
+        }
+
+        m_free.reserve(count);
+        while (m_free.size() < count){
+            m_free.emplace_back(blockSize);
+        }
+
+        m_count = count;
+    }
+
+    /// Allocates `count` blocks of the size preferred by the source.
+    /// The source must be in XferReady state.
+    /// \throw std::bad_alloc
+    ReturnCode allocate(Source& src, UInt32 count){
+        SetupMemXfer setup;
+        auto rc = src.setupMemXfer(setup);
+        if (success(rc)){
+            allocate(count, setup.preferredSize());
+        }
+
+        return rc;
+    }
+
+    /// Lends a free block, blocks until one is available.
+    /// The transfer fields are reset to TWON_DONTCARE32.
+    /// \return Whether a block was acquired, false if the ring has been closed.
+    bool acquire(ImageMemXfer& out){
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_closed && m_free.empty()){
+            m_cond.wait(lock);
+        }
+
+        if (m_closed){
+            return false;
+        }
+
+        out = take();
+        return true;
+    }
+
+    /// Lends a free block, does not block.
+    /// \return Whether a block was acquired.
+    bool tryAcquire(ImageMemXfer& out){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_closed || m_free.empty()){
+            return false;
+        }
+
+        out = take();
+        return true;
+    }
+
+    /// Returns a block to the ring.
+    /// If the memory has been moved out of the transfer, a replacement block is allocated.
+    /// \throw std::bad_alloc
+    void release(ImageMemXfer& xfer){
+        release(std::move(xfer.memory()));
+    }
+
+    /// Returns a block to the ring.
+    /// Passing an empty memory allocates a replacement block.
+    /// \throw std::bad_alloc
+    void release(Memory mem){
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_free.size() >= m_count){
+            return; // forgotten block, see `allocate`
+        }
+
+        if (mem.size() != m_blockSize){
+            auto blockSize = m_blockSize;
+            lock.unlock();
+            mem = Memory(blockSize);
+            lock.lock();
+
+            if (m_free.size() >= m_count || blockSize != m_blockSize){
+                return;
+            }
+        }
+
+        m_free.push_back(std::move(mem));
+        lock.unlock();
+
+        m_cond.notify_one();
+    }
+
+    /// Wakes up all threads waiting in `acquire`, further calls fail until `allocate` is called.
+    void close() noexcept{
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_closed = true;
+        lock.unlock();
+
+        m_cond.notify_all();
+    }
+
+    /// Size of a single block in bytes.
+    UInt32 blockSize() const noexcept{
+        return m_blockSize;
+    }
+
+    /// Total number of blocks.
+    UInt32 count() const noexcept{
+        return m_count;
+    }
+
+    /// Number of blocks currently available.
+    UInt32 available() const{
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return static_cast<UInt32>(m_free.size());
+    }
+
+private:
+    ImageMemXfer take() noexcept{
+        Memory mem(std::move(m_free.back()));
+        m_free.pop_back();
+
+        return ImageMemXfer(Compression::None, Detail::dontCare32, Detail::dontCare32,
+                            Detail::dontCare32, Detail::dontCare32, Detail::dontCare32,
+                            Detail::dontCare32, std::move(mem));
+    }
+
+    UInt32 m_blockSize;
+    UInt32 m_count;
+    bool m_closed;
+    std::vector<Memory> m_free;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cond;
+
+};
+
+}
+
+#endif // TWPP_DETAIL_FILE_MEMXFERRING_HPP
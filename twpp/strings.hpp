@@ -129,11 +129,14 @@ public:
 
     /// Length of the string (number of 8-bit characters).
     /// O(1) on Mac OS, O(n) anywhere else.
+    /// Strings received from other modules are not trusted,
+    /// the length never exceeds the string buffer.
     constexpr UInt32 length() const noexcept{
 #if defined(TWPP_DETAIL_OS_MAC)
-        return static_cast<unsigned const char>(this->array()[0]);
+        return static_cast<unsigned const char>(this->array()[0]) < maxSize() ?
+                    static_cast<unsigned const char>(this->array()[0]) : maxSize();
 #elif defined(TWPP_DETAIL_OS_WIN) || defined(TWPP_DETAIL_OS_LINUX)
-        return strLen(data());
+        return static_cast<UInt32>(strLen(data(), maxSize()));
 #else
 #   error "String::length for your platform here"
 #endif
@@ -256,24 +259,18 @@ public:
 template<std::size_t sizeA, std::size_t sizeB>
 constexpr bool operator==(const Detail::Str<sizeA>& a, const Detail::Str<sizeB>& b) noexcept{
     // length() is O(1) on mac os, O(n) anywhere else
-#if defined(TWPP_DETAIL_OS_MAC)
-    return a.length() == b.length() && Detail::strCmp(a.data(), b.data()) == 0;
-#elif defined(TWPP_DETAIL_OS_WIN) || defined(TWPP_DETAIL_OS_LINUX)
-        return Detail::strCmp(a.data(), b.data()) == 0;
-#else
-#   error "String equals operator for your platform here"
-#endif
-
+    // comparing up to the lengths does not read past unterminated strings
+    return a.length() == b.length() && Detail::strCmp(a.data(), a.length(), b.data(), b.length()) == 0;
 }
 
 template<std::size_t sizeA, std::size_t sizeB>
 constexpr bool operator<(const Detail::Str<sizeA>& a, const Detail::Str<sizeB>& b) noexcept{
-    return Detail::strCmp(a.data(), b.data()) < 0;
+    return Detail::strCmp(a.data(), a.length(), b.data(), b.length()) < 0;
 }
 
 template<std::size_t sizeA, std::size_t sizeB>
 constexpr bool operator>(const Detail::Str<sizeA>& a, const Detail::Str<sizeB>& b) noexcept{
-    return Detail::strCmp(a.data(), b.data()) > 0;
+    return Detail::strCmp(a.data(), a.length(), b.data(), b.length()) > 0;
 }
 
 template<std::size_t sizeA, std::size_t sizeB>
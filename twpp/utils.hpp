@@ -379,6 +379,15 @@ static constexpr inline std::size_t strLen(const char* str) noexcept{
     return strLenImpl(str);
 }
 
+/// Compile-time C string length, at most `maxLen` characters are read.
+/// \param str The string, needn't be null terminated.
+/// \param maxLen Size of the buffer holding the string.
+/// \param len Length of the previous, already processed, part of the string.
+/// \return Length of the string, `maxLen` if there is no null terminator.
+static constexpr inline std::size_t strLen(const char* str, std::size_t maxLen, std::size_t len = 0) noexcept{
+    return len == maxLen || str[len] == '\0' ? len : strLen(str, maxLen, len + 1);
+}
+
 
 /// Unsigned to signed conversion, using static_cast.
 /// Available only if integers are represented using 2 complement.
@@ -431,6 +440,19 @@ static constexpr inline int strCmp(const char* a, const char* b) noexcept{
     return *a != *b ? (static_cast<int>(*a) - *b) : (*a == '\0' ? 0 : strCmp(a + 1, b + 1));
 }
 
+/// Compares two strings of known lengths at compile time as if strcmp was used.
+/// The strings needn't be null terminated.
+/// \param a First string.
+/// \param lenA Length of the first string.
+/// \param b Second string.
+/// \param lenB Length of the second string.
+/// \return See strcmp.
+static constexpr inline int strCmp(const char* a, std::size_t lenA, const char* b, std::size_t lenB) noexcept{
+    return lenA == 0 || lenB == 0 ?
+                static_cast<int>(lenA != 0) - static_cast<int>(lenB != 0) :
+                (*a != *b ? (static_cast<int>(*a) - *b) : strCmp(a + 1, lenA - 1, b + 1, lenB - 1));
+}
+
 /// Absolute value.
 /// Default implementation handles signed values
 /// of non-integral types.
@@ -0,0 +1,465 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2015-2020 Martin Richter
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#ifndef TWPP_DETAIL_FILE_XFERENGINE_HPP
+#define TWPP_DETAIL_FILE_XFERENGINE_HPP
+
+#include "../twpp.hpp"
+
+namespace Twpp {
+
+namespace Detail {
+
+/// Blocking FIFO queue of limited capacity.
+/// Producers block while the queue is full, that is how backpressure is applied.
+/// \tparam T Item type, must be movable.
+template<typename T>
+class BoundedQueue {
+
+public:
+    /// \param capacity Maximal number of queued items, at least 1.
+    explicit BoundedQueue(std::size_t capacity) :
+        m_capacity(capacity != 0 ? capacity : 1){}
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    /// Appends an item, blocks while the queue is full.
+    /// \return Whether the item was queued, false if the queue has been closed.
+    bool push(T&& item){
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_closed && m_items.size() >= m_capacity){
+            m_notFull.wait(lock);
+        }
+
+        if (m_closed){
+            return false;
+        }
+
+        m_items.push_back(std::move(item));
+        lock.unlock();
+
+        m_notEmpty.notify_one();
+        return true;
+    }
+
+    /// Removes the first item, blocks while the queue is empty.
+    /// \return Whether an item was removed, false if the queue has been closed and drained.
+    bool pop(T& out){
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_closed && m_items.empty()){
+            m_notEmpty.wait(lock);
+        }
+
+        if (m_items.empty()){
+            return false;
+        }
+
+        out = std::move(m_items.front());
+        m_items.pop_front();
+        lock.unlock();
+
+        m_notFull.notify_one();
+        return true;
+    }
+
+    /// Closes the queue, no more items may be pushed.
+    /// Already queued items may still be popped, unless `discard` is set.
+    void close(bool discard = false) noexcept{
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_closed = true;
+        if (discard){
+            m_items.clear();
+        }
+
+        lock.unlock();
+
+        m_notFull.notify_all();
+        m_notEmpty.notify_all();
+    }
+
+    /// Reopens a closed and drained queue.
+    void reset() noexcept{
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_items.clear();
+        m_closed = false;
+    }
+
+private:
+    std::size_t m_capacity;
+    std::deque<T> m_items;
+    bool m_closed = false;
+    std::mutex m_mutex;
+    std::condition_variable m_notFull;
+    std::condition_variable m_notEmpty;
+
+};
+
+}
+
+/// A single unit of work produced by XferEngine.
+/// Native transfers produce one item per page,
+/// memory transfers produce one item per strip.
+class XferItem {
+
+public:
+    /// Creates an empty item.
+    XferItem() noexcept :
+        m_page(0), m_mech(XferMech::Native), m_last(false){}
+
+    /// Creates an item holding a whole native page.
+    XferItem(UInt32 page, const ImageInfo& info, ImageNativeXfer native) noexcept :
+        m_page(page), m_mech(XferMech::Native), m_last(true),
+        m_info(info), m_native(std::move(native)){}
+
+    /// Creates an item holding a single strip of a page.
+    XferItem(UInt32 page, const ImageInfo& info, ImageMemXfer strip, bool last) noexcept :
+        m_page(page), m_mech(XferMech::Memory), m_last(last),
+        m_info(info), m_strip(std::move(strip)){}
+
+    /// Zero-based index of the page within the current engine run.
+    UInt32 page() const noexcept{
+        return m_page;
+    }
+
+    /// Transfer mechanism the item was produced by, either Native or Memory.
+    XferMech mech() const noexcept{
+        return m_mech;
+    }
+
+    /// Whether this is the last item of the page.
+    /// Always true for native transfers.
+    bool isLast() const noexcept{
+        return m_last;
+    }
+
+    /// Image information of the page, obtained before its transfer.
+    const ImageInfo& info() const noexcept{
+        return m_info;
+    }
+
+    /// Native page, valid only for XferMech::Native.
+    ImageNativeXfer& native() noexcept{
+        return m_native;
+    }
+
+    /// Memory strip, valid only for XferMech::Memory.
+    ImageMemXfer& strip() noexcept{
+        return m_strip;
+    }
+
+private:
+    UInt32 m_page;
+    XferMech m_mech;
+    bool m_last;
+    ImageInfo m_info;
+    ImageNativeXfer m_native;
+    ImageMemXfer m_strip;
+
+};
+
+/// Pipelined image transfer engine.
+/// Runs the transfer loop (ImageInfo, transfer, PendingXfers/EndXfer) of a source
+/// in state XferReady, and hands the transferred pages or strips over to a pool
+/// of consumer threads through a bounded queue.
+/// Device I/O and page processing overlap; when the consumers fall behind,
+/// the queue fills up and the transfer loop waits (backpressure).
+///
+/// The source must not be used by anyone else while the engine runs.
+/// Some sources require all calls to be made from the thread that enabled them,
+/// use `run()` instead of `start()` for such sources.
+///
+/// Memory transfers use a MemXferRing of `capacity + consumers + 1` blocks
+/// of the preferred size, allocated once and reused by later runs.
+/// A strip block returns to the ring when the consumer returns; consumers that
+/// need to keep the data longer may move the memory out of `XferItem::strip()`,
+/// the ring then allocates a replacement.
+class XferEngine {
+
+public:
+    typedef std::function<void(XferItem&)> Consumer;
+
+    /// Creates an idle engine.
+    /// \param source The source, must outlive the engine.
+    /// \param consumer Function (object) processing the items, called from consumer threads.
+    /// \param mech Transfer mechanism to use, Native or Memory; must match the negotiated IXferMech.
+    /// \param consumers Number of consumer threads, at least 1.
+    /// \param capacity Maximal number of transferred items waiting for a consumer.
+    XferEngine(Source& source, Consumer consumer, XferMech mech = XferMech::Native,
+               UInt32 consumers = 1, UInt32 capacity = 4) :
+        m_src(source), m_consumer(std::move(consumer)), m_mech(mech),
+        m_numConsumers(consumers != 0 ? consumers : 1),
+        m_capacity(capacity != 0 ? capacity : 1), m_queue(capacity){
+
+        assert(mech == XferMech::Native || mech == XferMech::Memory);
+    }
+
+    /// Cancels and waits for any running transfer.
+    ~XferEngine(){
+        cancel();
+        join();
+    }
+
+    XferEngine(const XferEngine&) = delete;
+    XferEngine& operator=(const XferEngine&) = delete;
+
+    /// Starts the transfer loop in a dedicated thread, does not block.
+    /// The source must be in XferReady state.
+    /// Call `wait()` to obtain the result.
+    /// \throw std::system_error When a thread could not be started.
+    void start(){
+        assert(!m_producer.joinable() && m_consumers.empty());
+
+        prepare();
+        startConsumers();
+        m_producer = std::thread([this](){
+            m_rc = produceSafe();
+            m_queue.close();
+        });
+    }
+
+    /// Runs the transfer loop in the calling thread, consumers still run in background.
+    /// Blocks until all pages are transferred and consumed.
+    /// The source must be in XferReady state.
+    /// \throw std::system_error When a thread could not be started.
+    /// \throw Anything thrown by a consumer.
+    ReturnCode run(){
+        assert(!m_producer.joinable() && m_consumers.empty());
+
+        prepare();
+        startConsumers();
+        m_rc = produceSafe();
+        m_queue.close();
+        return wait();
+    }
+
+    /// Waits until all pages are transferred and consumed.
+    /// \return {Result of the last transfer operation. Success once all pending
+    ///          transfers were finished; Cancel if cancelled.}
+    /// \throw Anything thrown by a consumer, or by the transfer loop (e.g. std::bad_alloc).
+    ReturnCode wait(){
+        join();
+
+        if (m_error){
+            std::exception_ptr err;
+            std::swap(err, m_error);
+            std::rethrow_exception(err);
+        }
+
+        return m_rc;
+    }
+
+    /// Requests the transfer loop to stop after the current transfer.
+    /// Remaining pending transfers are reset, queued items are discarded.
+    void cancel() noexcept{
+        m_cancel = true;
+        m_queue.close(true);
+        m_ring.close();
+    }
+
+    /// Number of pages transferred so far in the current run.
+    UInt32 pages() const noexcept{
+        return m_pages;
+    }
+
+private:
+    void prepare() noexcept{
+        m_queue.reset();
+        m_cancel = false;
+        m_pages = 0;
+        m_rc = ReturnCode::Success;
+        m_error = nullptr;
+    }
+
+    void startConsumers(){
+        for (UInt32 i = 0; i < m_numConsumers; i++){
+            m_consumers.emplace_back([this](){
+                consume();
+            });
+        }
+    }
+
+    void join() noexcept{
+        if (m_producer.joinable()){
+            m_producer.join();
+        }
+
+        m_queue.close();
+        for (auto& thread : m_consumers){
+            thread.join();
+        }
+
+        m_consumers.clear();
+    }
+
+    void fail(std::exception_ptr err) noexcept{
+        std::lock_guard<std::mutex> lock(m_errMutex);
+        if (!m_error){
+            m_error = err;
+        }
+    }
+
+    void consume() noexcept{
+        XferItem item;
+        while (m_queue.pop(item)){
+            try {
+                m_consumer(item);
+                if (item.mech() == XferMech::Memory){
+                    m_ring.release(item.strip());
+                }
+            } catch (...){
+                fail(std::current_exception());
+                cancel();
+            }
+
+            item = XferItem();
+        }
+    }
+
+    ReturnCode produceSafe() noexcept{
+        ReturnCode rc;
+        try {
+            rc = produce();
+        } catch (...){
+            fail(std::current_exception());
+            rc = ReturnCode::Failure;
+        }
+
+        finish();
+        return m_cancel && success(rc) ? ReturnCode::Cancel : rc;
+    }
+
+    ReturnCode produce(){
+        if (m_src.state() != DsState::XferReady){
+            return ReturnCode::Failure;
+        }
+
+        SetupMemXfer setup;
+        if (m_mech == XferMech::Memory){
+            auto rc = m_src.setupMemXfer(setup);
+            if (!success(rc)){
+                return rc;
+            }
+
+            m_ring.allocate(m_capacity + m_numConsumers + 1, setup.preferredSize());
+        }
+
+        while (!m_cancel && m_src.state() == DsState::XferReady){
+            ImageInfo info;
+            auto rc = m_src.imageInfo(info);
+            if (!success(rc)){
+                return rc;
+            }
+
+            rc = m_mech == XferMech::Native ? transferNative(info) : transferMemory(info);
+            switch (rc){
+                case ReturnCode::XferDone:
+                    m_pages++;
+                    // fallthrough
+                case ReturnCode::Cancel: // this page was cancelled, others may follow
+                    break;
+
+                default:
+                    return rc;
+            }
+
+            PendingXfers pending;
+            rc = m_src.pendingXfers(Msg::EndXfer, pending);
+            if (!success(rc)){
+                return rc;
+            }
+        }
+
+        return ReturnCode::Success;
+    }
+
+    ReturnCode transferNative(const ImageInfo& info){
+        ImageNativeXfer xfer;
+        auto rc = m_src.imageNativeXfer(xfer);
+        if (rc == ReturnCode::XferDone && !m_queue.push(XferItem(m_pages, info, std::move(xfer)))){
+            return ReturnCode::Cancel;
+        }
+
+        return rc;
+    }
+
+    ReturnCode transferMemory(const ImageInfo& info){
+        ReturnCode rc;
+        do {
+            ImageMemXfer strip;
+            if (!m_ring.acquire(strip)){
+                return ReturnCode::Cancel;
+            }
+
+            rc = m_src.imageMemXfer(strip);
+            if (rc == ReturnCode::Success || rc == ReturnCode::XferDone){
+                bool last = rc == ReturnCode::XferDone;
+                if (!m_queue.push(XferItem(m_pages, info, std::move(strip), last))){
+                    return ReturnCode::Cancel;
+                }
+            } else {
+                m_ring.release(strip);
+            }
+        } while (rc == ReturnCode::Success && !m_cancel);
+
+        return rc == ReturnCode::Success ? ReturnCode::Cancel : rc;
+    }
+
+    // leaves the source in Enabled state, if possible
+    void finish() noexcept{
+        PendingXfers pending;
+        if (m_src.state() == DsState::Xferring){
+            m_src.pendingXfers(Msg::EndXfer, pending);
+        }
+
+        if (m_src.state() == DsState::XferReady){
+            m_src.pendingXfers(Msg::Reset, pending);
+        }
+    }
+
+    Source& m_src;
+    Consumer m_consumer;
+    XferMech m_mech;
+    UInt32 m_numConsumers;
+    UInt32 m_capacity;
+    Detail::BoundedQueue<XferItem> m_queue;
+    MemXferRing m_ring;
+
+    std::thread m_producer;
+    std::vector<std::thread> m_consumers;
+
+    std::atomic<bool> m_cancel{false};
+    std::atomic<UInt32> m_pages{0};
+    ReturnCode m_rc = ReturnCode::Success;
+
+    std::mutex m_errMutex;
+    std::exception_ptr m_error;
+
+};
+
+}
+
+#endif // TWPP_DETAIL_FILE_XFERENGINE_HPP